@@ -0,0 +1,160 @@
+// Read throughput through I2CBroker against direct bus access.  N client 
+// threads each make the same number of 6-byte register reads, first 
+// directly (one bus handle per client) and then as I2CBrokerClient 
+// connections to a broker thread.  Prints reads/s and the bus transfers 
+// executed; the broker executes identical reads of one round only once.
+//
+// Without a device the bus is I2CSimBus (direct clients then share it 
+// under a mutex) and the numbers measure software overhead only.  With a 
+// device, /dev/i2c-N is opened once per direct client and once by the 
+// broker.
+//
+// Build:  part of the host CMake build on Linux (target broker-throughput)
+// Usage:  broker-throughput [clients] [reads per client] [/dev/i2c-N address register]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <I2CBrokerClient.h>
+#include <I2CLinuxBackend.h>
+#include <I2CSimBus.h>
+
+static const char* SOCKET_PATH = "/tmp/i2c-broker-throughput.sock";
+
+struct Options {
+  unsigned clients;
+  unsigned reads;
+  const char* device;   //!< The i2c-dev path, nullptr for the simulator
+  uint16_t address;
+  uint8_t reg;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static double since(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void report(const char* name, const Options& o, double seconds, 
+                   unsigned long failed, unsigned long transfers) {
+  unsigned long reads = (unsigned long)o.clients * o.reads;
+  printf("%-7s %u clients  %9.0f reads/s  %8lu bus transfers  %lu failed\n", 
+         name, o.clients, reads / seconds, transfers, failed);
+}
+
+/**
+ * @brief Each client reads through its own device on a shared simulator
+ */
+static void directSim(const Options& o, I2CSimBus& sim) {
+  std::mutex lock;
+  std::atomic<unsigned long> failed(0);
+  std::vector<std::thread> threads;
+  Clock::time_point start = Clock::now();
+  for (unsigned k = 0; k < o.clients; k++) {
+    threads.emplace_back([&]() {
+      BasicI2CDevice<I2CSimBus> dev(sim, o.address);
+      uint8_t data[6];
+      for (unsigned i = 0; i < o.reads; i++) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (dev.readRegisters(o.reg, data, 6) != I2CBusResult::SUCCESS) failed++;
+      }
+    });
+  }
+  for (std::thread& t : threads) t.join();
+  report("direct", o, since(start), failed, (unsigned long)o.clients * o.reads);
+}
+
+/**
+ * @brief Each client opens the i2c-dev device itself
+ */
+static void directLinux(const Options& o) {
+  std::atomic<unsigned long> failed(0);
+  std::vector<std::thread> threads;
+  Clock::time_point start = Clock::now();
+  for (unsigned k = 0; k < o.clients; k++) {
+    threads.emplace_back([&]() {
+      I2CLinuxBackend bus;
+      if (!bus.open(o.device)) {
+        failed += o.reads;
+        return;
+      }
+      BasicI2CDevice<I2CLinuxBackend> dev(bus, o.address);
+      uint8_t data[6];
+      for (unsigned i = 0; i < o.reads; i++) {
+        if (dev.readRegisters(o.reg, data, 6) != I2CBusResult::SUCCESS) failed++;
+      }
+    });
+  }
+  for (std::thread& t : threads) t.join();
+  report("direct", o, since(start), failed, (unsigned long)o.clients * o.reads);
+}
+
+/**
+ * @brief Each client connects to a broker serving the bus from its own thread
+ */
+template <class Bus>
+static bool brokered(const Options& o, Bus& bus) {
+  static I2CBroker<Bus> broker(bus, 400000);
+  if (!broker.listen(SOCKET_PATH)) {
+    perror("listen");
+    return false;
+  }
+  std::atomic<bool> stop(false);
+  std::thread server([&]() {
+    while (!stop) broker.poll(20);
+  });
+  std::atomic<unsigned long> failed(0);
+  std::vector<std::thread> threads;
+  Clock::time_point start = Clock::now();
+  for (unsigned k = 0; k < o.clients; k++) {
+    threads.emplace_back([&]() {
+      I2CBrokerClient client;
+      if (!client.connect(SOCKET_PATH)) {
+        failed += o.reads;
+        return;
+      }
+      BasicI2CDevice<I2CBrokerClient> dev(client, o.address);
+      uint8_t data[6];
+      for (unsigned i = 0; i < o.reads; i++) {
+        if (dev.readRegisters(o.reg, data, 6) != I2CBusResult::SUCCESS) failed++;
+      }
+    });
+  }
+  for (std::thread& t : threads) t.join();
+  double seconds = since(start);
+  stop = true;
+  server.join();
+  report("broker", o, seconds, failed, broker.getEngine().getStats().executed);
+  broker.close();
+  unlink(SOCKET_PATH);
+  return true;
+}
+
+int main(int argc, char** argv) {
+  Options o;
+  o.clients = argc > 1 ? (unsigned)atoi(argv[1]) : 4;
+  o.reads = argc > 2 ? (unsigned)atoi(argv[2]) : 2000;
+  o.device = argc > 5 ? argv[3] : nullptr;
+  o.address = argc > 5 ? (uint16_t)strtol(argv[4], nullptr, 0) : 0x76;
+  o.reg = argc > 5 ? (uint8_t)strtol(argv[5], nullptr, 0) : 0xF7;
+  if (o.device) {
+    I2CLinuxBackend bus;
+    if (!bus.open(o.device)) {
+      perror(o.device);
+      return 1;
+    }
+    directLinux(o);
+    return brokered(o, bus) ? 0 : 1;
+  }
+  static I2CSimBus sim;
+  static uint8_t memory[256];
+  for (unsigned i = 0; i < 256; i++) memory[i] = (uint8_t)i;
+  static I2CSimMemoryTarget target(o.address, memory, 256);
+  sim.attach(target);
+  directSim(o, sim);
+  return brokered(o, sim) ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+// Import speed and memory use of the capture replay.  Writes synthetic
+// sigrok-cli and Saleae Logic 2 captures of a sensor polled through a
+// register read (plus writes to a second device), at a tenth of the size
+// and at full size, then streams each through I2CCaptureReader alone and
+// replayed to a driver by I2CSimReplayTarget.  Prints lines/s, MB/s,
+// segments/s (parse) or driver transactions/s (replay), and the growth of
+// the peak resident set size, which stays flat as the capture grows.
+//
+// Build:  part of the host CMake build (target capture-replay); configure
+//         with -DCMAKE_BUILD_TYPE=Release for meaningful numbers
+// Usage:  capture-replay [transactions]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <I2CDevice.h>
+#include <I2CSimBus.h>
+#include <I2CSimReplay.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static const uint8_t SENSOR = 0x76;
+static const uint8_t OTHER = 0x50;
+static const uint8_t REGISTER = 0xF7;
+static const uint8_t LENGTH = 8;
+
+static double seconds(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static long peakKb() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+static uint8_t sample(uint32_t t, uint8_t i) {
+  return (uint8_t)(t * 7 + i * 31);
+}
+
+/**
+ * @brief Write a capture: every transaction reads LENGTH bytes from the
+ *        sensor, every fourth one also writes two bytes to the other device
+ */
+static void writeCapture(const char* path, bool csv, uint32_t transactions) {
+  FILE* f = fopen(path, "w");
+  if (!f) {
+    perror(path);
+    exit(1);
+  }
+  if (csv) fprintf(f, "\"name\",\"type\",\"start_time\",\"duration\",\"ack\",\"address\",\"read\",\"data\"\n");
+  double t = 0;
+  for (uint32_t n = 0; n < transactions; n++) {
+    if (csv) {
+      fprintf(f, "\"I2C\",\"start\",%.9f,0.000000250,,,,\n", t);
+      fprintf(f, "\"I2C\",\"address\",%.9f,0.000090000,true,0x%02X,false,\n", t, SENSOR);
+      fprintf(f, "\"I2C\",\"data\",%.9f,0.000090000,true,,,0x%02X\n", t, REGISTER);
+      fprintf(f, "\"I2C\",\"start\",%.9f,0.000000250,,,,\n", t);
+      fprintf(f, "\"I2C\",\"address\",%.9f,0.000090000,true,0x%02X,true,\n", t, SENSOR);
+      for (uint8_t i = 0; i < LENGTH; i++) {
+        fprintf(f, "\"I2C\",\"data\",%.9f,0.000090000,%s,,,0x%02X\n", t,
+                i + 1 < LENGTH ? "true" : "false", sample(n, i));
+      }
+      fprintf(f, "\"I2C\",\"stop\",%.9f,0.000000250,,,,\n", t);
+    }
+    else {
+      fprintf(f, "i2c-1: Start\ni2c-1: Address write: %02X\ni2c-1: Write\ni2c-1: ACK\n", SENSOR);
+      fprintf(f, "i2c-1: Data write: %02X\ni2c-1: ACK\n", REGISTER);
+      fprintf(f, "i2c-1: Start repeated\ni2c-1: Address read: %02X\ni2c-1: Read\ni2c-1: ACK\n", SENSOR);
+      for (uint8_t i = 0; i < LENGTH; i++) {
+        fprintf(f, "i2c-1: Data read: %02X\ni2c-1: %s\n", sample(n, i), i + 1 < LENGTH ? "ACK" : "NACK");
+      }
+      fprintf(f, "i2c-1: Stop\n");
+    }
+    if (n % 4 == 0) {
+      if (csv) {
+        fprintf(f, "\"I2C\",\"start\",%.9f,0.000000250,,,,\n", t);
+        fprintf(f, "\"I2C\",\"address\",%.9f,0.000090000,true,0x%02X,false,\n", t, OTHER);
+        fprintf(f, "\"I2C\",\"data\",%.9f,0.000090000,true,,,0x10\n", t);
+        fprintf(f, "\"I2C\",\"data\",%.9f,0.000090000,true,,,0x%02X\n", t, (uint8_t)n);
+        fprintf(f, "\"I2C\",\"stop\",%.9f,0.000000250,,,,\n", t);
+      }
+      else {
+        fprintf(f, "i2c-1: Start\ni2c-1: Address write: %02X\ni2c-1: Write\ni2c-1: ACK\n", OTHER);
+        fprintf(f, "i2c-1: Data write: 10\ni2c-1: ACK\ni2c-1: Data write: %02X\ni2c-1: ACK\n", (uint8_t)n);
+        fprintf(f, "i2c-1: Stop\n");
+      }
+    }
+    t += 0.001;
+  }
+  fclose(f);
+}
+
+static void parse(const char* path, const char* format, uint32_t transactions) {
+  struct stat st;
+  stat(path, &st);
+  long before = peakKb();
+  I2CCaptureReader reader;
+  if (!reader.open(path)) {
+    perror(path);
+    exit(1);
+  }
+  I2CCaptureSegment segment;
+  uint32_t segments = 0;
+  Clock::time_point start = Clock::now();
+  while (reader.next(segment)) segments++;
+  double s = seconds(start);
+  printf("%-7s %9lu %-7s %10.0f %8.1f %12.0f %8lu %6ld\n", format,
+         (unsigned long)transactions, "parse", reader.getLines() / s,
+         st.st_size / s / 1e6, segments / s, (unsigned long)reader.getErrors(),
+         peakKb() - before);
+}
+
+static void replay(const char* path, const char* format, uint32_t transactions) {
+  struct stat st;
+  stat(path, &st);
+  long before = peakKb();
+  I2CCaptureReader reader;
+  if (!reader.open(path)) {
+    perror(path);
+    exit(1);
+  }
+  I2CSimBus bus;
+  I2CSimReplayTarget<I2CCaptureReader> sensor(reader, SENSOR);
+  bus.attach(sensor);
+  BasicI2CDevice<I2CSimBus> device(bus, SENSOR);
+  uint8_t data[LENGTH];
+  uint32_t bad = 0;
+  Clock::time_point start = Clock::now();
+  for (uint32_t n = 0; n < transactions; n++) {
+    if (device.readRegisters(REGISTER, data, LENGTH) != I2CBusResult::SUCCESS ||
+        data[LENGTH - 1] != sample(n, LENGTH - 1)) bad++;
+  }
+  double s = seconds(start);
+  printf("%-7s %9lu %-7s %10.0f %8.1f %12.0f %8lu %6ld\n", format,
+         (unsigned long)transactions, "replay", reader.getLines() / s,
+         st.st_size / s / 1e6, transactions / s, (unsigned long)(bad + sensor.getMismatches()),
+         peakKb() - before);
+}
+
+int main(int argc, char** argv) {
+  uint32_t transactions = argc > 1 ? strtoul(argv[1], nullptr, 0) : 200000;
+  if (transactions < 10) transactions = 10;
+  char path[] = "/tmp/i2c-capture-XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    perror("mkstemp");
+    return 1;
+  }
+  close(fd);
+  printf("%-7s %9s %-7s %10s %8s %12s %8s %6s\n", "format", "xfers", "pass",
+         "lines/s", "MB/s", "items/s", "errors", "+KB");
+  const uint32_t sizes[] = {transactions / 10, transactions};
+  for (int csv = 0; csv < 2; csv++) {
+    for (uint32_t size : sizes) {
+      writeCapture(path, csv, size);
+      parse(path, csv ? "saleae" : "sigrok", size);
+      replay(path, csv ? "saleae" : "sigrok", size);
+    }
+  }
+  unlink(path);
+  return 0;
+}
@@ -0,0 +1,139 @@
+// Fairness of I2CBusEngine under a mixed load, on the host timing model.
+// An LCD floods the bus with 31-byte writes while two sensors poll 6-byte
+// samples; every device keeps 4 transfers queued.  Over one simulated
+// second, prints each device's share of the bytes on the wire and the
+// sensors' queueing latency for:
+//   fifo        one shared queue (MaxFlows = 1)
+//   equal       deficit round robin, equal quanta
+//   sensors 4x  the sensors get four times the LCD's quantum
+//   lcd capped  the LCD is limited to 2000 bytes/s (8000-byte bucket)
+//
+// Build:  part of the host CMake build (target fair-queuing)
+// Usage:  fair-queuing [bus clock Hz]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <I2CBusEngine.h>
+#include <I2CSimBus.h>
+
+static const uint8_t DEPTH = 4;
+
+/**
+ * @brief A device keeping DEPTH transfers queued
+ */
+struct Source {
+  const char* name;
+  uint16_t address;
+  uint8_t txLength;
+  uint8_t rxLength;
+  I2CTransfer slots[DEPTH];
+  bool busy[DEPTH];
+  uint64_t submittedNs[DEPTH];
+  uint8_t tx[DEPTH][32];
+  uint8_t rx[DEPTH][8];
+  uint32_t completed;
+  uint64_t wireBytes;
+  uint64_t totalLatencyNs;
+  uint64_t maxLatencyNs;
+};
+
+static I2CSimBus* simBus;
+
+static void completed(I2CTransfer& xfer) {
+  Source& s = *(Source*)xfer.context;
+  uint8_t i = (uint8_t)(&xfer - s.slots);
+  uint64_t latency = simBus->now() - s.submittedNs[i];
+  s.busy[i] = false;
+  s.completed++;
+  s.wireBytes += (xfer.rxLength ? 2 : 1) + xfer.txLength + xfer.rxLength;
+  s.totalLatencyNs += latency;
+  if (latency > s.maxLatencyNs) s.maxLatencyNs = latency;
+}
+
+static void reset(Source& s, const char* name, uint16_t address, uint8_t tx, uint8_t rx) {
+  s = Source();
+  s.name = name;
+  s.address = address;
+  s.txLength = tx;
+  s.rxLength = rx;
+}
+
+template <class Engine>
+static void topUp(Engine& engine, Source& s) {
+  for (uint8_t i = 0; i < DEPTH; i++) {
+    if (s.busy[i]) continue;
+    s.tx[i][0] = (uint8_t)(i * 8);
+    s.slots[i] = I2CTransfer(s.address, s.tx[i], s.txLength, s.rxLength ? s.rx[i] : nullptr, s.rxLength);
+    s.slots[i].onComplete = completed;
+    s.slots[i].context = &s;
+    s.submittedNs[i] = simBus->now();
+    s.busy[i] = engine.submit(s.slots[i]);
+  }
+}
+
+template <class Engine>
+static void run(const char* scenario, Engine& engine, I2CSimBus& bus, Source* sources, uint8_t count) {
+  uint64_t end = bus.now() + 1000000000ULL;
+  uint64_t start = bus.now();
+  while (bus.now() < end) {
+    for (uint8_t i = 0; i < count; i++) topUp(engine, sources[i]);
+    if (!engine.poll()) bus.advance(100000);
+  }
+  uint64_t total = 0;
+  for (uint8_t i = 0; i < count; i++) total += sources[i].wireBytes;
+  double seconds = (bus.now() - start) / 1e9;
+  printf("%-11s", scenario);
+  for (uint8_t i = 0; i < count; i++) {
+    Source& s = sources[i];
+    printf("  %s %5.1f%%", s.name, total ? 100.0 * s.wireBytes / total : 0.0);
+    if (s.rxLength) {
+      printf(" (%4.0f/%5.0f us)", s.completed ? s.totalLatencyNs / 1000.0 / s.completed : 0.0,
+             s.maxLatencyNs / 1000.0);
+    }
+  }
+  printf("  %6.0f B/s\n", total / seconds);
+}
+
+int main(int argc, char** argv) {
+  uint32_t clock = argc > 1 ? (uint32_t)atol(argv[1]) : 400000;
+  I2CSimBus bus;
+  simBus = &bus;
+  bus.setClock(clock);
+  static uint8_t lcdMemory[256], sensorMemory[2][256];
+  I2CSimMemoryTarget lcd(0x27, lcdMemory, 256);
+  I2CSimMemoryTarget sensorA(0x76, sensorMemory[0], 256);
+  I2CSimMemoryTarget sensorB(0x77, sensorMemory[1], 256);
+  bus.attach(lcd);
+  bus.attach(sensorA);
+  bus.attach(sensorB);
+
+  static Source sources[3];
+  typedef I2CBusEngine<I2CSimBus, 32, 1, I2CSimClock> FifoEngine;
+  typedef I2CBusEngine<I2CSimBus, 32, 4, I2CSimClock> FairEngine;
+
+  printf("bus %lu Hz, share of wire bytes (sensor mean/max queueing latency)\n",
+         (unsigned long)clock);
+  for (uint8_t scenario = 0; scenario < 4; scenario++) {
+    reset(sources[0], "lcd", 0x27, 31, 0);
+    reset(sources[1], "sensorA", 0x76, 1, 6);
+    reset(sources[2], "sensorB", 0x77, 1, 6);
+    if (scenario == 0) {
+      static FifoEngine fifo(bus, clock, I2CSimClock(bus));
+      run("fifo", fifo, bus, sources, 3);
+      continue;
+    }
+    FairEngine engine(bus, clock, I2CSimClock(bus));
+    const char* name = "equal";
+    if (scenario == 2) {
+      name = "sensors 4x";
+      engine.setShare(0x76, 128);
+      engine.setShare(0x77, 128);
+    } else if (scenario == 3) {
+      name = "lcd capped";
+      engine.setShare(0x27, 32, 2000, 8000);
+    }
+    run(name, engine, bus, sources, 3);
+    if (engine.pending()) engine.run();
+  }
+  return 0;
+}
@@ -0,0 +1,124 @@
+// Read throughput of I2CRegisterCache under update load, against a cache
+// guarded by a std::mutex.  One writer thread stores 16-byte snapshots
+// (every byte equal to the update count) flat out or at a fixed rate;
+// 1, 2 and 4 reader threads copy snapshots for one second each.  Prints
+// reads/s, the retries caused by overlapping updates, and torn snapshots,
+// which must be zero.
+//
+// Build:  part of the host CMake build (target register-cache); configure
+//         with -DCMAKE_BUILD_TYPE=Release for meaningful numbers
+// Usage:  register-cache [updates per second, 0 = flat out]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <I2CRegisterCache.h>
+
+static const size_t SNAPSHOT = 16;
+
+/**
+ * @brief The same snapshot protected by a mutex, for comparison
+ */
+struct MutexCache {
+  std::mutex lock;
+  uint8_t data[SNAPSHOT];
+
+  void write(const uint8_t* in) {
+    std::lock_guard<std::mutex> guard(lock);
+    memcpy(data, in, SNAPSHOT);
+  }
+  bool tryRead(uint8_t* out) {
+    std::lock_guard<std::mutex> guard(lock);
+    memcpy(out, data, SNAPSHOT);
+    return true;
+  }
+};
+
+/**
+ * @brief I2CRegisterCache with the interface of MutexCache
+ */
+struct SeqlockCache {
+  I2CRegisterCache<SNAPSHOT> cache;
+
+  void write(const uint8_t* in) { cache.write(in, SNAPSHOT); }
+  bool tryRead(uint8_t* out) { return cache.tryRead(out, SNAPSHOT); }
+};
+
+struct Result {
+  uint64_t reads;
+  uint64_t retries;
+  uint64_t torn;
+  uint64_t updates;
+};
+
+template <class Cache>
+static Result run(unsigned readers, uint32_t rate) {
+  Cache cache;
+  std::atomic<bool> stop(false);
+  std::atomic<uint64_t> reads(0), retries(0), torn(0);
+  uint64_t updates = 0;
+
+  std::vector<std::thread> threads;
+  for (unsigned r = 0; r < readers; r++) {
+    threads.emplace_back([&]() {
+      uint64_t n = 0, again = 0, bad = 0;
+      uint8_t out[SNAPSHOT];
+      while (!stop.load(std::memory_order_relaxed)) {
+        while (!cache.tryRead(out)) again++;
+        for (size_t i = 1; i < SNAPSHOT; i++) {
+          if (out[i] != out[0]) {
+            bad++;
+            break;
+          }
+        }
+        n++;
+      }
+      reads += n;
+      retries += again;
+      torn += bad;
+    });
+  }
+
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point start = Clock::now();
+  Clock::time_point end = start + std::chrono::seconds(1);
+  uint8_t in[SNAPSHOT];
+  while (Clock::now() < end) {
+    updates++;
+    memset(in, (uint8_t)updates, SNAPSHOT);
+    cache.write(in);
+    if (rate) {
+      Clock::time_point next = start + std::chrono::nanoseconds(updates * 1000000000ULL / rate);
+      while (Clock::now() < next) std::this_thread::yield();
+    }
+  }
+  stop = true;
+  for (std::thread& t : threads) t.join();
+  Result result = { reads, retries, torn, updates };
+  return result;
+}
+
+static void report(const char* name, unsigned readers, const Result& r) {
+  printf("%-8s %u readers  %10.0f reads/s  %8llu retries  %llu torn  %8llu updates/s\n", 
+         name, readers, (double)r.reads, (unsigned long long)r.retries, 
+         (unsigned long long)r.torn, (unsigned long long)r.updates);
+}
+
+int main(int argc, char** argv) {
+  uint32_t rate = argc > 1 ? (uint32_t)atol(argv[1]) : 0;
+  printf("%u hardware threads, %s updates\n", std::thread::hardware_concurrency(), 
+         rate ? argv[1] : "flat out");
+  int status = 0;
+  const unsigned counts[] = { 1, 2, 4 };
+  for (unsigned readers : counts) {
+    Result seqlock = run<SeqlockCache>(readers, rate);
+    report("seqlock", readers, seqlock);
+    report("mutex", readers, run<MutexCache>(readers, rate));
+    if (seqlock.torn) status = 1;
+  }
+  return status;
+}
@@ -0,0 +1,74 @@
+// Round-trip latency of the shared memory virtual bus.  A forked server 
+// process serves an I2CSimMemoryTarget through I2CShmBusServer; the parent 
+// reads registers through I2CShmBusClient and prints the median, 99th 
+// percentile and worst round trip for several read lengths.  The spin 
+// time defaults to I2CShmBusClient's choice for the number of CPUs.
+//
+// Build:  part of the host CMake build (target shm-bus-latency)
+// Usage:  shm-bus-latency [round trips] [spin us]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <I2CShmBus.h>
+#include <I2CSimBus.h>
+
+static const char* SEGMENT = "/i2c-shm-bus-latency";
+
+int main(int argc, char** argv) {
+  unsigned count = argc > 1 ? (unsigned)atoi(argv[1]) : 100000;
+  I2CShmBusServer server;
+  if (!server.create(SEGMENT)) {
+    perror("create");
+    return 1;
+  }
+  pid_t pid = fork();
+  if (pid < 0) {
+    perror("fork");
+    return 1;
+  }
+  if (pid == 0) {
+    static I2CSimBus sim;
+    static uint8_t memory[256];
+    for (unsigned i = 0; i < 256; i++) memory[i] = (uint8_t)i;
+    static I2CSimMemoryTarget target(0x50, memory, 256);
+    sim.attach(target);
+    std::atomic<bool> stop(false);
+    server.run(sim, stop);
+    _exit(0);
+  }
+
+  I2CShmBusClient client;
+  int status = 0;
+  if (!client.open(SEGMENT)) {
+    perror("open");
+    status = 1;
+  }
+  if (argc > 2) client.setSpin((uint32_t)atol(argv[2]));
+  BasicI2CDevice<I2CShmBusClient> dev(client, 0x50);
+  typedef std::chrono::steady_clock Clock;
+  const uint8_t lengths[] = { 1, 4, 32, 255 };
+  uint8_t data[255];
+  std::vector<double> samples(count);
+  for (uint8_t length : lengths) {
+    if (status) break;
+    unsigned failed = 0;
+    for (unsigned i = 0; i < count; i++) {
+      Clock::time_point start = Clock::now();
+      if (dev.readRegisters(0, data, length) != I2CBusResult::SUCCESS) failed++;
+      samples[i] = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    }
+    std::sort(samples.begin(), samples.end());
+    printf("%3u bytes  median %6.2f us  p99 %7.2f us  max %8.2f us  %u failed\n", length,
+           samples[count / 2], samples[(size_t)(count * 0.99)], samples[count - 1], failed);
+    if (failed) status = 1;
+  }
+  kill(pid, SIGKILL);
+  waitpid(pid, nullptr, 0);
+  server.close(SEGMENT);
+  return status;
+}
@@ -0,0 +1,77 @@
+// Skew of I2CSyncSampler under the host timing model.  Samples 2 to 8 
+// simulated sensors at 100 kHz, 400 kHz and 1 MHz with broadcast and 
+// back-to-back triggers, and prints the trigger and read spread between 
+// the first and the last device.
+//
+// Build:  part of the host CMake build (target sync-skew)
+// Usage:  sync-skew [samples]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <I2CSyncSampler.h>
+#include <I2CSimBus.h>
+
+typedef BasicI2CDevice<I2CSimBus> Device;
+typedef I2CSyncSampler<Device, 8, 6, I2CSimClock> Sampler;
+
+/**
+ * @brief Sensor with a 16-byte register file that listens to general calls
+ */
+class Sensor : public I2CSimMemoryTarget {
+  public:
+    Sensor(): I2CSimMemoryTarget(0, m_registers, sizeof(m_registers)){};
+
+    bool acceptsGeneralCall() const override { return true; }
+
+  protected:
+    uint8_t m_registers[16];
+};
+
+static void run(uint32_t clock, uint8_t devices, uint8_t mode, unsigned samples) {
+  I2CSimBus bus;
+  bus.setClock(clock);
+  Sensor sensors[8];
+  Device* handles[8];
+  Sampler sampler((I2CSimClock(bus)));
+  for (uint8_t i = 0; i < devices; i++) {
+    sensors[i].setAddress(0x40 + i);
+    bus.attach(sensors[i]);
+    handles[i] = new Device(bus, 0x40 + i);
+    sampler.add(*handles[i]);
+  }
+  uint8_t trigger[2] = {0x00, 0x01};
+  uint8_t reg = 0x02;
+  sampler.setTrigger(trigger, 2, mode);
+  sampler.setReadCommand(&reg, 1);
+  sampler.setConversionTime(100);
+  for (unsigned i = 0; i < samples; i++) {
+    if (sampler.sample() != I2CBusResult::SUCCESS) {
+      fprintf(stderr, "sample failed\n");
+      exit(1);
+    }
+    bus.advance(1000000);
+  }
+  const I2CSkewStats& t = sampler.getTriggerSkew();
+  const I2CSkewStats& r = sampler.getReadSkew();
+  printf("%8lu %7u %-10s %10lu %10lu %10lu %10lu\n", (unsigned long)clock, devices,
+         mode == Sampler::TRIGGER_BROADCAST ? "broadcast" : "sequential",
+         (unsigned long)t.mean(), (unsigned long)t.max, 
+         (unsigned long)r.mean(), (unsigned long)r.max);
+  for (uint8_t i = 0; i < devices; i++) delete handles[i];
+}
+
+int main(int argc, char** argv) {
+  unsigned samples = argc > 1 ? (unsigned)atoi(argv[1]) : 1000;
+  const uint32_t clocks[] = {100000, 400000, 1000000};
+  const uint8_t counts[] = {2, 4, 8};
+  printf("%8s %7s %-10s %10s %10s %10s %10s\n", "clock", "devices", "trigger",
+         "trig mean", "trig max", "read mean", "read max");
+  for (uint32_t clock : clocks) {
+    for (uint8_t devices : counts) {
+      run(clock, devices, Sampler::TRIGGER_BROADCAST, samples);
+      run(clock, devices, Sampler::TRIGGER_SEQUENTIAL, samples);
+    }
+  }
+  printf("(skew in simulated microseconds)\n");
+  return 0;
+}
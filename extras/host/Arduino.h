@@ -0,0 +1,74 @@
+// Minimal Arduino core declarations for building the library on a host 
+// (Linux, macOS): the extras programs and the tests.  Pins do nothing, 
+// time comes from std::chrono.
+
+#ifndef I2C_HOST_ARDUINO_H_
+#define I2C_HOST_ARDUINO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+class Print {
+  public:
+    virtual ~Print() = default;
+    virtual size_t write(uint8_t data) = 0;
+    virtual size_t write(const uint8_t* data, size_t length) {
+      size_t n = 0;
+      while (length--) n += write(*data++);
+      return n;
+    }
+    size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+    size_t print(int value) {
+      char s[12];
+      snprintf(s, sizeof(s), "%d", value);
+      return print(s);
+    }
+    size_t println(const char* s) { return print(s) + print("\n"); }
+    size_t println(int value) { return print(value) + print("\n"); }
+    virtual void flush() {}
+};
+
+/**
+ * @brief Serial port writing to stdout
+ */
+class HardwareSerial : public Print {
+  public:
+    size_t write(uint8_t data) override { return fwrite(&data, 1, 1, stdout); }
+    size_t write(const uint8_t* data, size_t length) override { 
+      return fwrite(data, 1, length, stdout); 
+    }
+    void flush() override { fflush(stdout); }
+};
+
+static HardwareSerial Serial;
+
+inline unsigned long micros() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline unsigned long millis() { return micros() / 1000; }
+
+inline void delayMicroseconds(unsigned int us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+inline void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+inline void pinMode(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+inline void digitalWrite(uint8_t pin, uint8_t value) { (void)pin; (void)value; }
+inline int digitalRead(uint8_t pin) { (void)pin; return HIGH; }
+
+#endif /* I2C_HOST_ARDUINO_H_ */
@@ -0,0 +1,28 @@
+// Host stand-in for the Arduino Wire library.  No device is attached: 
+// every address is NACKed.  Host programs use an I2CBackend (I2CSimBus, 
+// I2CLinuxBackend...) as the bus instead.
+
+#ifndef I2C_HOST_WIRE_H_
+#define I2C_HOST_WIRE_H_
+
+#include "Arduino.h"
+
+class TwoWire {
+  public:
+    void begin() {}
+    void setClock(uint32_t frequency) { (void)frequency; }
+    void beginTransmission(uint8_t address) { (void)address; }
+    size_t write(uint8_t data) { (void)data; return 1; }
+    size_t write(const uint8_t* data, size_t length) { (void)data; return length; }
+    uint8_t endTransmission(uint8_t sendStop = 1) { (void)sendStop; return 2; }
+    uint8_t requestFrom(uint8_t address, uint8_t length, uint8_t sendStop = 1) {
+      (void)address; (void)length; (void)sendStop;
+      return 0;
+    }
+    int available() { return 0; }
+    int read() { return -1; }
+};
+
+static TwoWire Wire;
+
+#endif /* I2C_HOST_WIRE_H_ */
@@ -0,0 +1,33 @@
+// I2C bus broker daemon for Linux.  Owns /dev/i2c-N and serves
+// BasicI2CDevice<I2CBrokerClient> clients over a Unix domain socket.
+//
+// Build:  part of the host CMake build on Linux (target i2c-broker), or
+//         g++ -std=c++11 -O2 -I../host -I../../src i2c-broker.cpp -o i2c-broker
+// Usage:  i2c-broker <bus number> <socket path> [clock Hz]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <I2CLinuxBackend.h>
+#include <I2CBroker.h>
+
+static I2CLinuxBackend bus;
+static I2CBroker<I2CLinuxBackend> broker(bus);
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s <bus number> <socket path> [clock Hz]\n", argv[0]);
+    return 2;
+  }
+  if (!bus.open(atoi(argv[1]))) {
+    perror("open bus");
+    return 1;
+  }
+  if (argc > 3) broker.getEngine().setClock((uint32_t)atol(argv[3]));
+  if (!broker.listen(argv[2])) {
+    perror("listen");
+    return 1;
+  }
+  broker.run();
+  perror("poll");
+  return 1;
+}
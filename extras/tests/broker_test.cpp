@@ -0,0 +1,288 @@
+// Host test of I2CBroker on I2CSimBus, with clients on socketpair() ends:
+// batch round trips, priorities, merging of identical reads across
+// clients, rejection of malformed and truncated requests, and dropping a
+// client that stopped reading its responses.
+
+#include <stdio.h>
+#include <I2CBroker.h>
+#include <I2CSimBus.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while (0)
+
+typedef I2CBrokerProtocol Protocol;
+typedef I2CBroker<I2CSimBus, 4> Broker;
+
+/**
+ * @brief A request message under construction
+ */
+struct Request {
+  uint8_t data[Protocol::MAX_MESSAGE];
+  size_t length;
+
+  Request(uint16_t count, uint8_t priority = 0): length(sizeof(Protocol::Header)) {
+    Protocol::Header h;
+    memset(&h, 0, sizeof(h));
+    h.magic = Protocol::MAGIC;
+    h.version = Protocol::VERSION;
+    h.priority = priority;
+    h.count = count;
+    memcpy(data, &h, sizeof(h));
+  };
+
+  void add(uint16_t address, const uint8_t* tx, uint16_t txLength, uint16_t rxLength) {
+    Protocol::Op op;
+    op.address = address;
+    op.flags = 0;
+    op.reserved = 0;
+    op.txLength = txLength;
+    op.rxLength = rxLength;
+    memcpy(data + length, &op, sizeof(op));
+    length += sizeof(op);
+    memcpy(data + length, tx, txLength);
+    length += txLength;
+  }
+};
+
+/**
+ * @brief A received response message
+ */
+struct Response {
+  uint8_t data[Protocol::MAX_MESSAGE];
+  ssize_t length;
+
+  const Protocol::Header& header() const { return *(const Protocol::Header*)data; }
+
+  /**
+   * @brief Get a result and its read bytes
+   */
+  Protocol::Result result(uint16_t index, const uint8_t** rx = nullptr) const {
+    size_t pos = sizeof(Protocol::Header);
+    Protocol::Result r;
+    for (uint16_t i = 0; ; i++) {
+      memcpy(&r, data + pos, sizeof(r));
+      pos += sizeof(r);
+      if (i == index) break;
+      pos += r.rxCount;
+    }
+    if (rx) *rx = data + pos;
+    return r;
+  }
+};
+
+/**
+ * @brief Connect a new client to the broker
+ *
+ * @return The client end of the socket pair
+ */
+static int connectClient(Broker& broker) {
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) < 0) return -1;
+  broker.adopt(fds[1]);
+  return fds[0];
+}
+
+static bool sendRequest(int fd, const Request& request) {
+  return send(fd, request.data, request.length, MSG_NOSIGNAL) == (ssize_t)request.length;
+}
+
+static bool receive(int fd, Response& response) {
+  response.length = recv(fd, response.data, sizeof(response.data), MSG_DONTWAIT);
+  return response.length >= (ssize_t)sizeof(Protocol::Header);
+}
+
+static void testRoundTrip() {
+  I2CSimBus bus;
+  uint8_t memory[256] = {0};
+  I2CSimMemoryTarget target(0x50, memory, sizeof(memory));
+  bus.attach(target);
+  Broker broker(bus);
+  int fd = connectClient(broker);
+  CHECK(fd >= 0);
+
+  // Write, read back, then read from an absent device, in one batch
+  uint8_t write[3] = {0x10, 0xAA, 0xBB};
+  uint8_t reg = 0x10;
+  Request request(3);
+  request.add(0x50, write, 3, 0);
+  request.add(0x50, &reg, 1, 2);
+  request.add(0x51, &reg, 1, 2);
+  CHECK(sendRequest(fd, request));
+  CHECK(broker.poll(0) == 1);
+
+  Response response;
+  CHECK(receive(fd, response));
+  CHECK(response.header().magic == Protocol::MAGIC);
+  CHECK(response.header().count == 3);
+  const uint8_t* rx;
+  Protocol::Result r = response.result(0);
+  CHECK(r.status == I2CBusResult::SUCCESS && r.rxCount == 0);
+  r = response.result(1, &rx);
+  CHECK(r.status == I2CBusResult::SUCCESS && r.rxCount == 2);
+  CHECK(rx[0] == 0xAA && rx[1] == 0xBB);
+  r = response.result(2);
+  CHECK(r.status == I2CBusResult::NACK_ON_ADDRESS && r.rxCount == 0);
+  CHECK(response.length == (ssize_t)(sizeof(Protocol::Header) + 3 * sizeof(Protocol::Result) + 2));
+
+  // An empty batch is answered with an empty response
+  Request empty(0);
+  CHECK(sendRequest(fd, empty));
+  CHECK(broker.poll(0) == 1);
+  CHECK(receive(fd, response));
+  CHECK(response.header().count == 0);
+  CHECK(broker.getStats().requests == 2);
+  CHECK(broker.getStats().transfers == 3);
+  CHECK(broker.getStats().rejected == 0);
+  close(fd);
+}
+
+static void testPriorityAndMerge() {
+  I2CSimBus bus;
+  uint8_t memory[256] = {0};
+  memory[0x20] = 0x11;
+  I2CSimMemoryTarget target(0x50, memory, sizeof(memory));
+  bus.attach(target);
+  Broker broker(bus);
+  int low = connectClient(broker);
+  int high = connectClient(broker);
+  int other = connectClient(broker);
+
+  // The high priority write runs before the reads queued in the same round
+  uint8_t reg = 0x20;
+  uint8_t write[2] = {0x20, 0x99};
+  Request read(1);
+  read.add(0x50, &reg, 1, 1);
+  Request update(1, 5);
+  update.add(0x50, write, 2, 0);
+  CHECK(sendRequest(low, read));
+  CHECK(sendRequest(other, read));
+  CHECK(sendRequest(high, update));
+  CHECK(broker.poll(0) == 3);
+
+  // ...and the two identical reads ran once
+  CHECK(bus.getStats().transfers == 2);
+  CHECK(broker.getEngine().getStats().readsMerged == 1);
+  Response response;
+  const uint8_t* rx;
+  CHECK(receive(low, response));
+  CHECK(response.result(0, &rx).rxCount == 1 && rx[0] == 0x99);
+  CHECK(receive(other, response));
+  CHECK(response.result(0, &rx).rxCount == 1 && rx[0] == 0x99);
+  CHECK(receive(high, response));
+  CHECK(response.result(0).status == I2CBusResult::SUCCESS);
+  close(low);
+  close(high);
+  close(other);
+}
+
+/**
+ * @brief Send a bad request and check that the client is dropped without
+ *        touching the bus
+ */
+static void checkRejected(const uint8_t* message, size_t length) {
+  I2CSimBus bus;
+  uint8_t memory[256] = {0};
+  I2CSimMemoryTarget target(0x50, memory, sizeof(memory));
+  bus.attach(target);
+  Broker broker(bus);
+  int fd = connectClient(broker);
+  CHECK(send(fd, message, length, MSG_NOSIGNAL) == (ssize_t)length);
+  CHECK(broker.poll(0) == 0);
+  CHECK(broker.getStats().rejected == 1);
+  CHECK(bus.getStats().transfers == 0);
+  char byte;
+  CHECK(recv(fd, &byte, 1, MSG_DONTWAIT) == 0);
+  close(fd);
+}
+
+static void testMalformed() {
+  uint8_t reg = 0x00;
+
+  // Shorter than a header
+  Request valid(1);
+  valid.add(0x50, &reg, 1, 1);
+  checkRejected(valid.data, sizeof(Protocol::Header) - 1);
+
+  // Wrong magic and wrong version
+  Request bad = valid;
+  bad.data[0] ^= 0xFF;
+  checkRejected(bad.data, bad.length);
+  bad = valid;
+  ((Protocol::Header*)bad.data)->version = Protocol::VERSION + 1;
+  checkRejected(bad.data, bad.length);
+
+  // More transfers than a batch holds
+  Request many(Protocol::MAX_OPS + 1);
+  for (uint8_t i = 0; i <= Protocol::MAX_OPS; i++) many.add(0x50, &reg, 1, 1);
+  checkRejected(many.data, many.length);
+
+  // Count promising a transfer that is missing, or a cut off Op
+  Request missing(2);
+  missing.add(0x50, &reg, 1, 1);
+  checkRejected(missing.data, missing.length);
+  checkRejected(valid.data, sizeof(Protocol::Header) + sizeof(Protocol::Op) - 1);
+
+  // Written bytes past the end of the message
+  uint8_t tx[8] = {0};
+  Request cut(1);
+  cut.add(0x50, tx, sizeof(tx), 0);
+  checkRejected(cut.data, cut.length - 1);
+
+  // Reads that do not fit in a response
+  Request big(2);
+  big.add(0x50, &reg, 1, 2048);
+  big.add(0x50, &reg, 1, 2048);
+  checkRejected(big.data, big.length);
+}
+
+static void testStalledClient() {
+  I2CSimBus bus;
+  uint8_t memory[256] = {0};
+  I2CSimMemoryTarget target(0x50, memory, sizeof(memory));
+  bus.attach(target);
+  Broker broker(bus);
+  int stalled = connectClient(broker);
+  int active = connectClient(broker);
+
+  // The stalled client keeps sending but never reads: once its socket is
+  // full the broker drops it instead of blocking
+  uint8_t reg = 0x00;
+  Request read(1);
+  read.add(0x50, &reg, 1, 2048);
+  Response response;
+  uint16_t rounds = 0;
+  while (broker.getStats().dropped == 0 && rounds < 10000) {
+    if (!sendRequest(stalled, read)) break;
+    CHECK(sendRequest(active, read));
+    broker.poll(0);
+    CHECK(receive(active, response));
+    CHECK(response.result(0).rxCount == 2048);
+    rounds++;
+  }
+  CHECK(broker.getStats().dropped == 1);
+  CHECK(rounds > 1);
+
+  // The other client is still served
+  CHECK(sendRequest(active, read));
+  CHECK(broker.poll(0) == 1);
+  CHECK(receive(active, response));
+  CHECK(response.result(0).status == I2CBusResult::SUCCESS);
+  close(stalled);
+  close(active);
+}
+
+int main() {
+  testRoundTrip();
+  testPriorityAndMerge();
+  testMalformed();
+  testStalledClient();
+  if (failures) fprintf(stderr, "%d checks failed\n", failures);
+  else printf("broker_test: all checks passed\n");
+  return failures ? 1 : 0;
+}
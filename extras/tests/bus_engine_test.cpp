@@ -0,0 +1,361 @@
+// Host test of I2CBusEngine on I2CSimBus: read merging, write collapsing,
+// deficit round robin shares, token bucket rate limits, service() budgets
+// and the arbitration retry policy, all on simulated time.
+
+#include <stdio.h>
+#include <I2CBusEngine.h>
+#include <I2CSimBus.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while (0)
+
+/**
+ * @brief Simulated bus losing arbitration a set number of times, recording
+ *        when each attempt started
+ */
+class ContestedBus : public I2CSimBus {
+  public:
+    ContestedBus(): m_losses(0), m_attempts(0){};
+
+    uint8_t transfer(I2CTransfer& xfer) override {
+      if (m_attempts < 16) m_startUs[m_attempts] = (uint32_t)(now() / 1000);
+      m_attempts++;
+      if (!m_losses) return I2CSimBus::transfer(xfer);
+      m_losses--;
+      advance(LOSS_NS);
+      xfer.rxCount = 0;
+      return xfer.status = ARBITRATION_LOST;
+    }
+
+    static constexpr uint32_t LOSS_NS = 10000; //!< Bus time of a lost attempt
+
+    uint8_t m_losses;       //!< Attempts still to lose
+    uint8_t m_attempts;     //!< Attempts made
+    uint32_t m_startUs[16]; //!< Start time of the first attempts
+};
+
+typedef I2CBusEngine<I2CSimBus, 16, 4, I2CSimClock> Engine;
+
+static void countCompletion(I2CTransfer& xfer) {
+  (*(int*)xfer.context)++;
+}
+
+static void track(I2CTransfer& xfer, int& counter) {
+  xfer.onComplete = countCompletion;
+  xfer.context = &counter;
+}
+
+static void testReadMerge() {
+  I2CSimBus bus;
+  uint8_t memory[256] = {0};
+  memory[0x10] = 0x12;
+  memory[0x11] = 0x34;
+  I2CSimMemoryTarget target(0x50, memory, sizeof(memory));
+  bus.attach(target);
+  Engine engine(bus, 100000, I2CSimClock(bus));
+
+  // Identical pending reads share one execution
+  uint8_t reg = 0x10;
+  uint8_t a[2] = {0};
+  uint8_t b[2] = {0};
+  int done = 0;
+  I2CTransfer first(0x50, &reg, 1, a, 2);
+  I2CTransfer second(0x50, &reg, 1, b, 2);
+  track(first, done);
+  track(second, done);
+  CHECK(engine.submit(first));
+  CHECK(engine.submit(second));
+  CHECK(engine.pending() == 2);
+  CHECK(engine.queued() == 1);
+
+  // ...but not across a write to the same device
+  uint8_t write[2] = {0x10, 0x56};
+  uint8_t c[2] = {0};
+  I2CTransfer update(0x50, write, 2);
+  I2CTransfer third(0x50, &reg, 1, c, 2);
+  track(update, done);
+  track(third, done);
+  CHECK(engine.submit(update));
+  CHECK(engine.submit(third));
+
+  CHECK(engine.run() == 3);
+  CHECK(done == 4);
+  CHECK(engine.pending() == 0);
+  CHECK(bus.getStats().transfers == 3);
+  CHECK(engine.getStats().readsMerged == 1);
+  CHECK(engine.getStats().executed == 3);
+  CHECK(engine.getStats().savedUs > 0);
+  CHECK(second.status == I2CBusResult::SUCCESS && second.rxCount == 2);
+  CHECK(a[0] == 0x12 && a[1] == 0x34);
+  CHECK(b[0] == 0x12 && b[1] == 0x34);
+  CHECK(c[0] == 0x56 && c[1] == 0x34);
+}
+
+static void testWriteCollapse() {
+  I2CSimBus bus;
+  uint8_t memory[256] = {0};
+  I2CSimMemoryTarget target(0x50, memory, sizeof(memory));
+  bus.attach(target);
+  Engine engine(bus, 100000, I2CSimClock(bus));
+
+  uint8_t w1[2] = {0x20, 1};
+  uint8_t w2[2] = {0x20, 2};
+  uint8_t w3[2] = {0x21, 3};
+  uint8_t w4[2] = {0x20, 4};
+  I2CTransfer x1(0x50, w1, 2);
+  I2CTransfer x2(0x50, w2, 2);
+  I2CTransfer x3(0x50, w3, 2);
+  I2CTransfer x4(0x50, w4, 2);
+  int done = 0;
+  track(x1, done);
+  track(x2, done);
+  track(x3, done);
+  track(x4, done);
+  // x2 supersedes x1, x4 follows another register write and is kept
+  CHECK(engine.submit(x1, 1));
+  CHECK(engine.submit(x2, 1));
+  CHECK(engine.submit(x3, 1));
+  CHECK(engine.submit(x4, 1));
+  CHECK(engine.queued() == 3);
+
+  // Writes without a collapse key are never superseded
+  uint8_t w5[2] = {0x22, 5};
+  uint8_t w6[2] = {0x22, 6};
+  I2CTransfer x5(0x50, w5, 2);
+  I2CTransfer x6(0x50, w6, 2);
+  CHECK(engine.submit(x5));
+  CHECK(engine.submit(x6));
+
+  CHECK(engine.run() == 5);
+  CHECK(done == 4);
+  CHECK(bus.getStats().transfers == 5);
+  CHECK(engine.getStats().writesCollapsed == 1);
+  CHECK(x1.status == I2CBusResult::SUCCESS);
+  CHECK(memory[0x20] == 4);
+  CHECK(memory[0x21] == 3);
+  CHECK(memory[0x22] == 6);
+}
+
+static void testFairness() {
+  I2CSimBus bus;
+  uint8_t memA[256] = {0};
+  uint8_t memB[256] = {0};
+  I2CSimMemoryTarget a(0x50, memA, sizeof(memA));
+  I2CSimMemoryTarget b(0x51, memB, sizeof(memB));
+  bus.attach(a);
+  bus.attach(b);
+  Engine engine(bus, 100000, I2CSimClock(bus));
+
+  // 8 wire bytes per write: 0x50 may send three per round, 0x51 one
+  CHECK(engine.setShare(0x50, 24));
+  CHECK(engine.setShare(0x51, 8));
+  uint8_t data[7] = {0x00, 1, 2, 3, 4, 5, 6};
+  I2CTransfer xfers[16];
+  int doneA = 0;
+  int doneB = 0;
+  for (uint8_t i = 0; i < 16; i++) {
+    bool first = i < 8;
+    xfers[i] = I2CTransfer(first ? 0x50 : 0x51, data, sizeof(data));
+    track(xfers[i], first ? doneA : doneB);
+    CHECK(engine.submit(xfers[i]));
+  }
+  CHECK(!engine.submit(xfers[0]));
+
+  for (uint8_t i = 0; i < 8; i++) CHECK(engine.poll());
+  CHECK(doneA == 6);
+  CHECK(doneB == 2);
+
+  // Once 0x50 has nothing left, 0x51 gets the whole bus
+  CHECK(engine.run() == 8);
+  CHECK(doneA == 8);
+  CHECK(doneB == 8);
+  CHECK(engine.getStats().throttled == 0);
+}
+
+static void testTokenBucket() {
+  I2CSimBus bus;
+  I2CSimClock clock(bus);
+  uint8_t memA[256] = {0};
+  uint8_t memB[256] = {0};
+  I2CSimMemoryTarget a(0x50, memA, sizeof(memA));
+  I2CSimMemoryTarget b(0x51, memB, sizeof(memB));
+  bus.attach(a);
+  bus.attach(b);
+  Engine engine(bus, 100000, clock);
+
+  // 0x50 is capped to 1000 B/s with a 16 byte burst, 8 wire bytes per write
+  CHECK(engine.setShare(0x50, 32, 1000, 16));
+  uint8_t data[7] = {0x00, 1, 2, 3, 4, 5, 6};
+  I2CTransfer xfers[15];
+  int doneA = 0;
+  for (uint8_t i = 0; i < 15; i++) {
+    xfers[i] = I2CTransfer(0x50, data, sizeof(data));
+    track(xfers[i], doneA);
+    CHECK(engine.submit(xfers[i]));
+  }
+  uint32_t start = clock.nowUs();
+  CHECK(engine.run() == 2);
+  CHECK(engine.getStats().throttled == 1);
+
+  // An unlimited device uses the bus while 0x50 is out of tokens
+  int doneB = 0;
+  I2CTransfer other(0x51, data, sizeof(data));
+  track(other, doneB);
+  CHECK(engine.submit(other));
+  CHECK(engine.poll());
+  CHECK(doneB == 1);
+  CHECK(doneA == 2);
+
+  // The remaining 13 writes (104 bytes) drain at the capped rate
+  while (engine.pending()) {
+    if (!engine.poll()) clock.delayUs(100);
+  }
+  uint32_t elapsed = clock.nowUs() - start;
+  CHECK(doneA == 15);
+  CHECK(elapsed >= 104000 && elapsed <= 104000 + 1000);
+}
+
+static void testServiceBudget() {
+  I2CSimBus bus;
+  I2CSimClock clock(bus);
+  uint8_t memory[256] = {0};
+  I2CSimMemoryTarget target(0x50, memory, sizeof(memory));
+  bus.attach(target);
+  Engine engine(bus, 100000, clock);
+
+  uint8_t data[7] = {0x00, 1, 2, 3, 4, 5, 6};
+  I2CTransfer xfers[6];
+  for (uint8_t i = 0; i < 6; i++) {
+    xfers[i] = I2CTransfer(0x50, data, sizeof(data));
+    CHECK(engine.submit(xfers[i]));
+  }
+  uint32_t costUs = (engine.getCostModel().transferNs(xfers[0]) + 999) / 1000;
+
+  // Two transfers fit in two and a half, the other four wait
+  uint32_t budget = costUs * 5 / 2;
+  uint32_t start = clock.nowUs();
+  CHECK(engine.service(budget) == 2);
+  CHECK(clock.nowUs() - start <= budget);
+  CHECK(engine.pending() == 4);
+  CHECK(engine.getStats().deferred == 4);
+  CHECK(engine.getStats().overruns == 0);
+  CHECK(engine.service(budget) == 2);
+  CHECK(engine.service(budget) == 2);
+  CHECK(engine.pending() == 0);
+  CHECK(engine.getStats().deferred == 6);
+  CHECK(engine.service(budget) == 0);
+
+  // A transfer longer than the whole budget runs alone, and overruns it
+  uint8_t burst[32] = {0};
+  I2CTransfer big(0x50, burst, sizeof(burst));
+  I2CTransfer small(0x50, data, sizeof(data));
+  CHECK(engine.submit(big));
+  CHECK(engine.submit(small));
+  CHECK(engine.service(budget) == 1);
+  CHECK(engine.getStats().overruns == 1);
+  CHECK(engine.getStats().deferred == 7);
+  CHECK(engine.service(budget) == 1);
+
+  // Clock stretching the model does not know about overruns the budget too
+  target.setStretch(costUs * 2000);
+  CHECK(engine.submit(xfers[0]));
+  CHECK(engine.submit(xfers[1]));
+  CHECK(engine.service(budget) == 1);
+  CHECK(engine.getStats().overruns == 2);
+  CHECK(engine.pending() == 1);
+}
+
+static void testArbitration() {
+  // Lost against a real competing controller: retried after the backoff
+  I2CSimBus bus;
+  I2CSimClock clock(bus);
+  uint8_t memory[256] = {0};
+  I2CSimMemoryTarget target(0x50, memory, sizeof(memory));
+  bus.attach(target);
+  uint8_t theirs[1] = {0x00};
+  I2CSimMaster master(0x08, theirs, 1, 1000000000UL);
+  bus.setContender(&master);
+  Engine engine(bus, 100000, clock);
+
+  uint8_t data[2] = {0x30, 0x77};
+  I2CTransfer write(0x50, data, 2);
+  int done = 0;
+  track(write, done);
+  CHECK(engine.submit(write));
+  CHECK(engine.poll());
+  CHECK(done == 0);
+  CHECK(engine.pending() == 1);
+  CHECK(engine.getStats().arbitrationLost == 1);
+  CHECK(!engine.poll());
+  while (engine.pending()) {
+    if (!engine.poll()) clock.delayUs(1);
+  }
+  CHECK(done == 1);
+  CHECK(write.status == I2CBusResult::SUCCESS);
+  CHECK(memory[0x30] == 0x77);
+  CHECK(engine.getStats().retries == 1);
+  CHECK(engine.getStats().executed == 2);
+  CHECK(master.getStats().transfers == 1);
+
+  // Backoff windows double with every retry, then the transfer gives up
+  ContestedBus contested;
+  I2CBusEngine<ContestedBus, 16, 4, I2CSimClock> retrying(contested, 100000,
+                                                           I2CSimClock(contested));
+  retrying.setBackoff(50, 4);
+  contested.m_losses = 10;
+  I2CTransfer lost(0x50, data, 2);
+  done = 0;
+  track(lost, done);
+  CHECK(retrying.submit(lost));
+  while (retrying.pending()) {
+    if (!retrying.poll()) I2CSimClock(contested).delayUs(1);
+  }
+  CHECK(done == 1);
+  CHECK(lost.status == I2CBusResult::ARBITRATION_LOST);
+  CHECK(contested.m_attempts == 5);
+  CHECK(retrying.getStats().retries == 4);
+  CHECK(retrying.getStats().arbitrationLost == 5);
+  for (uint8_t i = 1; i < 5; i++) {
+    uint32_t waitUs = contested.m_startUs[i] - contested.m_startUs[i - 1] -
+                      ContestedBus::LOSS_NS / 1000;
+    CHECK(waitUs >= 1 && waitUs <= (50UL << (i - 1)) + 1);
+  }
+
+  // A retry keeps its place: later transfers to the device wait for it
+  contested.m_losses = 1;
+  contested.m_attempts = 0;
+  uint8_t memory2[256] = {0};
+  I2CSimMemoryTarget target2(0x50, memory2, sizeof(memory2));
+  contested.attach(target2);
+  uint8_t first[2] = {0x40, 1};
+  uint8_t second[2] = {0x40, 2};
+  I2CTransfer x1(0x50, first, 2);
+  I2CTransfer x2(0x50, second, 2);
+  CHECK(retrying.submit(x1));
+  CHECK(retrying.submit(x2));
+  while (retrying.pending()) {
+    if (!retrying.poll()) I2CSimClock(contested).delayUs(1);
+  }
+  CHECK(x1.status == I2CBusResult::SUCCESS);
+  CHECK(x2.status == I2CBusResult::SUCCESS);
+  CHECK(contested.m_attempts == 3);
+  CHECK(memory2[0x40] == 2);
+}
+
+int main() {
+  testReadMerge();
+  testWriteCollapse();
+  testFairness();
+  testTokenBucket();
+  testServiceBudget();
+  testArbitration();
+  if (failures) fprintf(stderr, "%d checks failed\n", failures);
+  else printf("bus_engine_test: all checks passed\n");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,198 @@
+// Host test of I2CPcapWriter against golden bytes, written to memory: pcap
+// and pcapng file headers, record and block lengths with their padding,
+// the DLT_I2C_LINUX pseudo-header flags, 7-bit and 10-bit address bytes,
+// which phases of failed transfers are recorded, and timestamps extended
+// across 32-bit clock wraparounds.
+
+#include <stdio.h>
+#include <I2CDevice.h>
+#include <I2CSimBus.h>
+#include <I2CPcap.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while (0)
+
+/**
+ * @brief Output collecting the capture in memory
+ */
+class MemoryOutput {
+  public:
+    MemoryOutput(): m_length(0){};
+
+    size_t write(const uint8_t* data, size_t length) {
+      if (m_length + length > sizeof(m_data)) length = sizeof(m_data) - m_length;
+      memcpy(m_data + m_length, data, length);
+      m_length += length;
+      return length;
+    }
+
+    /**
+     * @brief Compare the next bytes of the capture with golden bytes
+     *
+     * @param offset The position compared, advanced past the golden bytes
+     */
+    bool matches(size_t& offset, const uint8_t* golden, size_t length) const {
+      bool same = offset + length <= m_length && memcmp(m_data + offset, golden, length) == 0;
+      if (!same) fprintf(stderr, "capture differs in the %u bytes at %u\n",
+                         (unsigned)length, (unsigned)offset);
+      offset += length;
+      return same;
+    }
+
+    inline size_t length() const { return m_length; }
+
+  protected:
+    uint8_t m_data[1024];
+    size_t m_length;
+};
+
+typedef I2CPcapWriter<MemoryOutput, I2CSimClock> Writer;
+
+#define CHECK_BYTES(output, offset, ...) do { \
+    static const uint8_t golden[] = {__VA_ARGS__}; \
+    CHECK((output).matches(offset, golden, sizeof(golden))); \
+  } while (0)
+
+static void testPcap() {
+  I2CSimBus bus;
+  bus.advance(1000000);
+  MemoryOutput output;
+  Writer writer(output, 3, Writer::PCAP, I2CSimClock(bus));
+  writer.begin(1700000000123456ULL);
+
+  // Write-then-read: a write packet at the start, a read packet at the end
+  uint8_t reg = 0x10;
+  uint8_t rx[2] = {0xAB, 0xCD};
+  I2CTransfer read(0x50, &reg, 1, rx, 2);
+  read.status = I2CBusResult::SUCCESS;
+  read.rxCount = 2;
+  writer.record(read, 1100, 1400);
+
+  // 10-bit write
+  uint8_t tx[2] = {0x01, 0x02};
+  I2CTransfer ten(0x2A5, tx, 2);
+  ten.flags = I2CTransfer::TEN_BIT;
+  ten.status = I2CBusResult::SUCCESS;
+  writer.record(ten, 1500, 1600);
+
+  // Probe NACKed on the address: the address byte alone
+  I2CTransfer probe(0x51);
+  probe.status = I2CBusResult::NACK_ON_ADDRESS;
+  writer.record(probe, 1700, 1700);
+
+  // 10-bit read without a register: only the read packet
+  uint8_t one = 0x5A;
+  I2CTransfer tenRead(0x2A5, nullptr, 0, &one, 1);
+  tenRead.flags = I2CTransfer::TEN_BIT;
+  tenRead.status = I2CBusResult::SUCCESS;
+  tenRead.rxCount = 1;
+  writer.record(tenRead, 1800, 1900);
+
+  // Register write NACKed before the read phase: only the write packet
+  uint8_t other = 0x20;
+  I2CTransfer failed(0x50, &other, 1, rx, 2);
+  failed.status = I2CBusResult::NACK_ON_DATA;
+  writer.record(failed, 2000, 2100);
+
+  size_t offset = 0;
+  // Magic, version 2.4, zone, sigfigs, snaplen, DLT_I2C_LINUX
+  CHECK_BYTES(output, offset, 0xD4, 0xC3, 0xB2, 0xA1, 0x02, 0x00, 0x04, 0x00,
+              0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+              0xFF, 0xFF, 0x00, 0x00, 0xD1, 0x00, 0x00, 0x00);
+  // Seconds, microseconds, captured and original length, then bus 3,
+  // flags (big-endian) and the address byte
+  CHECK_BYTES(output, offset, 0x00, 0xF1, 0x53, 0x65, 0xA4, 0xE2, 0x01, 0x00,
+              0x07, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00,
+              0x03, 0x00, 0x00, 0x00, 0x00, 0xA0, 0x10);
+  CHECK_BYTES(output, offset, 0x00, 0xF1, 0x53, 0x65, 0xD0, 0xE3, 0x01, 0x00,
+              0x08, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00,
+              0x03, 0x00, 0x00, 0x00, 0x01, 0xA1, 0xAB, 0xCD);
+  // I2C_M_TEN, then the 11110XX prefix and the low address byte
+  CHECK_BYTES(output, offset, 0x00, 0xF1, 0x53, 0x65, 0x34, 0xE4, 0x01, 0x00,
+              0x09, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00,
+              0x03, 0x00, 0x00, 0x00, 0x10, 0xF4, 0xA5, 0x01, 0x02);
+  CHECK_BYTES(output, offset, 0x00, 0xF1, 0x53, 0x65, 0xFC, 0xE4, 0x01, 0x00,
+              0x06, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00,
+              0x03, 0x00, 0x00, 0x00, 0x00, 0xA2);
+  CHECK_BYTES(output, offset, 0x00, 0xF1, 0x53, 0x65, 0xC4, 0xE5, 0x01, 0x00,
+              0x08, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00,
+              0x03, 0x00, 0x00, 0x00, 0x11, 0xF5, 0xA5, 0x5A);
+  CHECK_BYTES(output, offset, 0x00, 0xF1, 0x53, 0x65, 0x28, 0xE6, 0x01, 0x00,
+              0x07, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00,
+              0x03, 0x00, 0x00, 0x00, 0x00, 0xA0, 0x20);
+  CHECK(offset == output.length());
+  CHECK(writer.getPackets() == 6);
+  CHECK(writer.getBytes() == output.length());
+}
+
+static void testPcapng() {
+  // The clock wraps between the two phases of the first transfer
+  I2CSimBus bus;
+  bus.advance(0xFFFFFF00ULL * 1000);
+  MemoryOutput output;
+  Writer writer(output, 0x81, Writer::PCAPNG, I2CSimClock(bus));
+  writer.begin(0x00000005FFFFFFF0ULL);
+
+  uint8_t reg = 0x10;
+  uint8_t rx[2] = {0xAB, 0xCD};
+  I2CTransfer read(0x50, &reg, 1, rx, 2);
+  read.status = I2CBusResult::SUCCESS;
+  read.rxCount = 2;
+  writer.record(read, 0xFFFFFFF0UL, 0x10);
+
+  // Probes spaced under 2^31 µs apart, wrapping the clock once more
+  I2CTransfer probe(0x51);
+  probe.status = I2CBusResult::NACK_ON_ADDRESS;
+  writer.record(probe, 0x60000000UL, 0x60000000UL);
+  writer.record(probe, 0xC0000000UL, 0xC0000000UL);
+  writer.record(probe, 0x100, 0x100);
+
+  size_t offset = 0;
+  // Section header: byte order magic, version 1.0, unknown section length
+  CHECK_BYTES(output, offset, 0x0A, 0x0D, 0x0D, 0x0A, 0x1C, 0x00, 0x00, 0x00,
+              0x4D, 0x3C, 0x2B, 0x1A, 0x01, 0x00, 0x00, 0x00,
+              0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x1C, 0x00, 0x00, 0x00);
+  // Interface description: DLT_I2C_LINUX, snaplen
+  CHECK_BYTES(output, offset, 0x01, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00,
+              0xD1, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00);
+  // Enhanced packets: type, block length, interface, timestamp high and
+  // low words, captured and original length, the padded data (bus 1, the
+  // event bit of the bus number dropped), and the block length again
+  CHECK_BYTES(output, offset, 0x06, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00,
+              0x00, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0xE0, 0x00, 0x00, 0x00,
+              0x07, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00,
+              0x01, 0x00, 0x00, 0x00, 0x00, 0xA0, 0x10, 0x00, 0x28, 0x00, 0x00, 0x00);
+  CHECK_BYTES(output, offset, 0x06, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00,
+              0x00, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00,
+              0x08, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00,
+              0x01, 0x00, 0x00, 0x00, 0x01, 0xA1, 0xAB, 0xCD, 0x28, 0x00, 0x00, 0x00);
+  CHECK_BYTES(output, offset, 0x06, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00,
+              0x00, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0xF0, 0x00, 0x00, 0x60,
+              0x06, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00,
+              0x01, 0x00, 0x00, 0x00, 0x00, 0xA2, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00);
+  CHECK_BYTES(output, offset, 0x06, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00,
+              0x00, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0xF0, 0x00, 0x00, 0xC0,
+              0x06, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00,
+              0x01, 0x00, 0x00, 0x00, 0x00, 0xA2, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00);
+  CHECK_BYTES(output, offset, 0x06, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00,
+              0x00, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0xF0, 0x01, 0x00, 0x00,
+              0x06, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00,
+              0x01, 0x00, 0x00, 0x00, 0x00, 0xA2, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00);
+  CHECK(offset == output.length());
+  CHECK(writer.getPackets() == 5);
+  CHECK(writer.getBytes() == output.length());
+}
+
+int main() {
+  testPcap();
+  testPcapng();
+  if (failures) fprintf(stderr, "%d checks failed\n", failures);
+  else printf("pcap_test: all checks passed\n");
+  return failures ? 1 : 0;
+}
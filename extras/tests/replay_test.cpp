@@ -0,0 +1,162 @@
+// Host test of the capture replay: parses the same BME280 session as
+// decoded by sigrok-cli and exported by Saleae Logic 2 (extras/tests/
+// fixtures), then replays it to a driver through I2CSimReplayTarget.
+//
+// Usage:  replay_test [fixtures directory]
+
+#include <stdio.h>
+#include <I2CDevice.h>
+#include <I2CSimBus.h>
+#include <I2CSimReplay.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while (0)
+
+static const char* fixtures = "extras/tests/fixtures";
+
+/**
+ * @brief A segment expected in the fixtures
+ */
+struct Expected {
+  uint16_t address;
+  bool read;
+  bool addressAck;
+  uint16_t length;
+  uint16_t acked;
+  uint8_t data[3];
+};
+
+static const Expected session[] = {
+  {0x76, false, true,  1, 1, {0xD0}},             // chip ID register
+  {0x76, true,  true,  1, 0, {0x60}},             // chip ID, NACKed by the controller
+  {0x50, false, false, 0, 0, {0}},                // absent device
+  {0x76, false, true,  2, 2, {0xF4, 0x27}},       // ctrl_meas
+  {0x76, false, true,  1, 1, {0xF7}},             // pressure registers
+  {0x76, true,  true,  3, 2, {0x52, 0x3A, 0x80}},
+  {0x76, false, true,  2, 1, {0xE0, 0xB6}},       // reset, NACKed by the device
+};
+
+static const size_t SESSION_SEGMENTS = sizeof(session) / sizeof(session[0]);
+
+static void path(char* out, size_t size, const char* name) {
+  snprintf(out, size, "%s/%s", fixtures, name);
+}
+
+static void checkSegment(const I2CCaptureSegment& s, const Expected& e) {
+  CHECK(s.address == e.address);
+  CHECK(s.read == e.read);
+  CHECK(s.addressAck == e.addressAck);
+  CHECK(s.length == e.length);
+  CHECK(s.acked == e.acked);
+  CHECK(memcmp(s.data, e.data, e.length) == 0);
+}
+
+static void testParse(const char* name) {
+  char file[256];
+  path(file, sizeof(file), name);
+  I2CCaptureReader reader;
+  CHECK(reader.open(file));
+  I2CCaptureSegment segment;
+  size_t count = 0;
+  while (reader.next(segment)) {
+    if (count < SESSION_SEGMENTS) checkSegment(segment, session[count]);
+    count++;
+  }
+  CHECK(count == SESSION_SEGMENTS);
+  CHECK(reader.getErrors() == 0);
+  CHECK(!reader.next(segment));
+}
+
+static void testShortForm() {
+  // sigrok-cli short annotations without ACK lines, and a segment longer
+  // than the bytes kept
+  I2CCaptureParser parser;
+  I2CCaptureSegment segment;
+  CHECK(!parser.feed("S\n", segment));
+  CHECK(!parser.feed("AW: 3C\n", segment));
+  for (int i = 0; i < 300; i++) {
+    char line[16];
+    snprintf(line, sizeof(line), "DW: %02X\n", i & 0xFF);
+    CHECK(!parser.feed(line, segment));
+  }
+  CHECK(parser.feed("Sr\n", segment));
+  CHECK(segment.address == 0x3C && !segment.read && segment.addressAck);
+  CHECK(segment.length == 300 && segment.acked == 300);
+  CHECK(segment.data[0] == 0x00 && segment.data[255] == 0xFF);
+  CHECK(!parser.feed("AR: 3C\n", segment));
+  CHECK(!parser.feed("DR: 12\n", segment));
+  CHECK(!parser.feed("Bit rate: 100000\n", segment));
+  CHECK(parser.finish(segment));
+  CHECK(segment.read && segment.length == 1 && segment.data[0] == 0x12);
+  CHECK(parser.getErrors() == 1);
+}
+
+static void testReplay(const char* name) {
+  char file[256];
+  path(file, sizeof(file), name);
+  I2CCaptureReader reader;
+  CHECK(reader.open(file));
+  I2CSimBus bus;
+  I2CSimReplayTarget<I2CCaptureReader> sensor(reader, 0x76);
+  bus.attach(sensor);
+  BasicI2CDevice<I2CSimBus> device(bus, 0x76);
+
+  uint8_t id = 0;
+  CHECK(device.readRegister(0xD0, id) == I2CBusResult::SUCCESS);
+  CHECK(id == 0x60);
+  CHECK(device.writeRegister(0xF4, 0x27) == I2CBusResult::SUCCESS);
+  uint8_t pressure[3] = {0};
+  CHECK(device.readRegisters(0xF7, pressure, 3) == I2CBusResult::SUCCESS);
+  CHECK(pressure[0] == 0x52 && pressure[1] == 0x3A && pressure[2] == 0x80);
+  CHECK(device.writeRegister(0xE0, 0xB6) == I2CBusResult::NACK_ON_DATA);
+  CHECK(sensor.getMismatches() == 0);
+  CHECK(sensor.getReplayed() == 6);
+  CHECK(!sensor.isFinished());
+
+  // Past the end of the capture the device is gone
+  CHECK(device.readRegister(0xD0, id) == I2CBusResult::NACK_ON_ADDRESS);
+  CHECK(sensor.isFinished());
+}
+
+static void testMismatch() {
+  char file[256];
+  path(file, sizeof(file), "bme280-sigrok.txt");
+  I2CCaptureReader reader;
+  CHECK(reader.open(file));
+  I2CSimBus bus;
+  I2CSimReplayTarget<I2CCaptureReader> sensor(reader, 0x76);
+  bus.attach(sensor);
+  BasicI2CDevice<I2CSimBus> device(bus, 0x76);
+
+  // A driver reading the wrong register, then writing a different value
+  uint8_t id = 0;
+  CHECK(device.readRegister(0xD1, id) == I2CBusResult::SUCCESS);
+  CHECK(sensor.getMismatches() == 1);
+  CHECK(device.writeRegister(0xF4, 0x25) == I2CBusResult::SUCCESS);
+  CHECK(sensor.getMismatches() == 2);
+
+  // Reading more than was captured
+  uint8_t pressure[4] = {0};
+  CHECK(device.readRegisters(0xF7, pressure, 4) == I2CBusResult::SUCCESS);
+  CHECK(pressure[3] == 0xFF);
+  CHECK(sensor.getMismatches() == 3);
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1) fixtures = argv[1];
+  testParse("bme280-sigrok.txt");
+  testParse("bme280-saleae.csv");
+  testShortForm();
+  testReplay("bme280-sigrok.txt");
+  testReplay("bme280-saleae.csv");
+  testMismatch();
+  if (failures) fprintf(stderr, "%d checks failed\n", failures);
+  else printf("replay_test: all checks passed\n");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,263 @@
+// Host test of I2CSimBus: read, write, combined, NACK, 10-bit and general 
+// call transfers, through raw transfers, BasicI2CDevice and I2CDeviceGroup,
+// the end of sessions held with NO_STOP, and the TwoWire read length limit.
+
+#include <stdio.h>
+#include <I2CDevice.h>
+#include <I2CSimBus.h>
+#include <I2CDeviceGroup.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while (0)
+
+/**
+ * @brief Memory target that NACKs written bytes after the first limit
+ */
+class NackingTarget : public I2CSimMemoryTarget {
+  public:
+    NackingTarget(uint16_t address, uint8_t* memory, size_t size, size_t limit):
+      I2CSimMemoryTarget(address, memory, size), m_limit(limit), m_count(0){};
+
+    bool onStart(bool read) override {
+      if (!read) m_count = 0;
+      return I2CSimMemoryTarget::onStart(read);
+    }
+
+    bool onWrite(uint8_t data) override {
+      if (m_count++ >= m_limit) return false;
+      return I2CSimMemoryTarget::onWrite(data);
+    }
+
+  protected:
+    size_t m_limit;
+    size_t m_count;
+};
+
+static void testRawTransfers() {
+  I2CSimBus bus;
+  uint8_t memory[16];
+  for (uint8_t i = 0; i < sizeof(memory); i++) memory[i] = i;
+  I2CSimMemoryTarget target(0x50, memory, sizeof(memory));
+  bus.attach(target);
+
+  // Write: pointer then two bytes
+  uint8_t tx[3] = {0x04, 0xAA, 0xBB};
+  I2CTransfer write(0x50, tx, 3);
+  CHECK(bus.transfer(write) == I2CBusResult::SUCCESS);
+  CHECK(memory[4] == 0xAA && memory[5] == 0xBB);
+
+  // Read continues from the pointer
+  uint8_t rx[2] = {0, 0};
+  I2CTransfer read(0x50, nullptr, 0, rx, 2);
+  CHECK(bus.transfer(read) == I2CBusResult::SUCCESS);
+  CHECK(read.rxCount == 2 && rx[0] == 0x06 && rx[1] == 0x07);
+
+  // Combined write-then-read
+  uint8_t reg = 0x04;
+  I2CTransfer combined(0x50, &reg, 1, rx, 2);
+  CHECK(bus.transfer(combined) == I2CBusResult::SUCCESS);
+  CHECK(rx[0] == 0xAA && rx[1] == 0xBB);
+
+  // NACK on address for writes, reads and probes
+  I2CTransfer missingWrite(0x51, tx, 3);
+  CHECK(bus.transfer(missingWrite) == I2CBusResult::NACK_ON_ADDRESS);
+  I2CTransfer missingRead(0x51, nullptr, 0, rx, 2);
+  CHECK(bus.transfer(missingRead) == I2CBusResult::NACK_ON_ADDRESS);
+  CHECK(missingRead.rxCount == 0);
+  I2CTransfer probe(0x51);
+  CHECK(bus.transfer(probe) == I2CBusResult::NACK_ON_ADDRESS);
+  I2CTransfer present(0x50);
+  CHECK(bus.transfer(present) == I2CBusResult::SUCCESS);
+
+  CHECK(bus.getStats().transfers == 7);
+  CHECK(bus.getStats().nacks == 3);
+}
+
+static void testNackOnData() {
+  I2CSimBus bus;
+  uint8_t memory[16] = {0};
+  NackingTarget target(0x20, memory, sizeof(memory), 2);
+  bus.attach(target);
+  uint8_t tx[4] = {0x00, 0x11, 0x22, 0x33};
+  I2CTransfer write(0x20, tx, 4);
+  CHECK(bus.transfer(write) == I2CBusResult::NACK_ON_DATA);
+  CHECK(memory[0] == 0x11 && memory[1] == 0x00);
+}
+
+static void testTenBit() {
+  I2CSimBus bus;
+  uint8_t memory[8] = {0};
+  I2CSimMemoryTarget target(0x2A5, memory, sizeof(memory), 1, true);
+  bus.attach(target);
+
+  uint8_t tx[3] = {0x01, 0x5A, 0xA5};
+  I2CTransfer write(0x2A5, tx, 3);
+  write.flags = I2CTransfer::TEN_BIT;
+  CHECK(bus.transfer(write) == I2CBusResult::SUCCESS);
+  CHECK(memory[1] == 0x5A && memory[2] == 0xA5);
+
+  uint8_t reg = 0x01;
+  uint8_t rx[2] = {0, 0};
+  I2CTransfer read(0x2A5, &reg, 1, rx, 2);
+  read.flags = I2CTransfer::TEN_BIT;
+  CHECK(bus.transfer(read) == I2CBusResult::SUCCESS);
+  CHECK(rx[0] == 0x5A && rx[1] == 0xA5);
+
+  I2CTransfer other(0x1A5, tx, 1);
+  other.flags = I2CTransfer::TEN_BIT;
+  CHECK(bus.transfer(other) == I2CBusResult::NACK_ON_ADDRESS);
+
+  BasicI2CDevice<I2CSimBus, I2CAddress10> device(bus, 0x2A5);
+  CHECK(device.detect());
+  uint8_t value = 0;
+  CHECK(device.readRegister(0x02, value) == I2CBusResult::SUCCESS && value == 0xA5);
+  CHECK(device.writeRegister(0x03, 0x77) == I2CBusResult::SUCCESS && memory[3] == 0x77);
+
+  // The second address byte takes one byte of the Wire buffer
+  uint8_t burst[32] = {0};
+  CHECK(device.MAX_WRITE == 30);
+  CHECK(device.writeRegisters(0x00, burst, 30) == I2CBusResult::SUCCESS);
+  CHECK(device.writeRegisters(0x00, burst, 31) == I2CBusResult::DATA_TOO_LONG);
+}
+
+static void testDevice() {
+  I2CSimBus bus;
+  uint8_t memory[32] = {0};
+  I2CSimMemoryTarget target(0x68, memory, sizeof(memory));
+  bus.attach(target);
+  BasicI2CDevice<I2CSimBus> device(bus, 0x68);
+  BasicI2CDevice<I2CSimBus> missing(bus, 0x69);
+  BasicI2CDevice<I2CSimBus> prefix(bus, 0x78);
+
+  CHECK(device.detect());
+  CHECK(!missing.detect());
+  // A 10-bit prefix with no 10-bit device selected
+  CHECK(!prefix.detect());
+  uint8_t value = 0;
+  CHECK(prefix.readRegisters(0x00, &value, 0) != I2CBusResult::SUCCESS);
+
+  uint8_t data[4] = {1, 2, 3, 4};
+  CHECK(device.writeRegisters(0x10, data, 4) == I2CBusResult::SUCCESS);
+  uint8_t back[4] = {0};
+  CHECK(device.readRegisters(0x10, back, 4) == I2CBusResult::SUCCESS);
+  CHECK(memcmp(data, back, 4) == 0);
+  CHECK(missing.readRegisters(0x10, back, 4) == I2CBusResult::NACK_ON_ADDRESS);
+}
+
+/**
+ * @brief Memory target that also listens to general call writes
+ */
+class GeneralCallTarget : public I2CSimMemoryTarget {
+  public:
+    GeneralCallTarget(uint16_t address, uint8_t* memory, size_t size):
+      I2CSimMemoryTarget(address, memory, size){};
+
+    bool acceptsGeneralCall() const override { return true; }
+};
+
+static void testGroupWrite() {
+  I2CSimBus bus;
+  uint8_t first[4] = {0};
+  uint8_t second[4] = {0};
+  GeneralCallTarget a(0x40, first, sizeof(first));
+  GeneralCallTarget b(0x41, second, sizeof(second));
+  bus.attach(a);
+  BasicI2CDevice<I2CSimBus> deviceA(bus, 0x40);
+  BasicI2CDevice<I2CSimBus> deviceB(bus, 0x41);
+  I2CDeviceGroup<BasicI2CDevice<I2CSimBus>> group;
+  group.add(deviceA);
+
+  // General call with a single listener
+  uint8_t command[2] = {0x01, 0x5A};
+  CHECK(group.write(command, 2) == I2CBusResult::SUCCESS);
+  CHECK(first[1] == 0x5A);
+
+  bus.attach(b);
+  group.add(deviceB);
+  command[1] = 0xA5;
+  CHECK(group.write(command, 2) == I2CBusResult::SUCCESS);
+  CHECK(first[1] == 0xA5 && second[1] == 0xA5);
+
+  // No listener at all
+  bus.detach(a);
+  bus.detach(b);
+  CHECK(group.write(command, 2) == I2CBusResult::NACK_ON_ADDRESS);
+}
+
+/**
+ * @brief Memory target that counts stop conditions
+ */
+class StopCountingTarget : public I2CSimMemoryTarget {
+  public:
+    StopCountingTarget(uint16_t address, uint8_t* memory, size_t size):
+      I2CSimMemoryTarget(address, memory, size), stops(0){};
+
+    void onStop() override {
+      stops++;
+      I2CSimMemoryTarget::onStop();
+    }
+
+    uint32_t stops;
+};
+
+static void testReleaseBus() {
+  I2CSimBus bus;
+  uint8_t memory[8] = {0};
+  StopCountingTarget target(0x50, memory, sizeof(memory));
+  bus.attach(target);
+
+  // A NO_STOP transfer keeps the device addressed until the bus is released
+  uint8_t reg = 0x01;
+  uint8_t rx[2];
+  I2CTransfer held(0x50, &reg, 1, rx, 2);
+  held.flags = I2CTransfer::NO_STOP;
+  CHECK(bus.transfer(held) == I2CBusResult::SUCCESS);
+  CHECK(target.stops == 0);
+  bus.releaseBus();
+  CHECK(target.stops == 1);
+  bus.releaseBus();
+  CHECK(target.stops == 1);
+
+  // After the release, transfers contend with the other controller again
+  uint8_t theirs[1] = {0x00};
+  I2CSimMaster master(0x08, theirs, 1, 1000000);
+  CHECK(bus.transfer(held) == I2CBusResult::SUCCESS);
+  bus.setContender(&master);
+  bus.releaseBus();
+  bus.advance(1000000 - bus.now());
+  I2CTransfer read(0x50, &reg, 1, rx, 2);
+  CHECK(bus.transfer(read) == I2CBusResult::ARBITRATION_LOST);
+  CHECK(bus.getStats().arbitrationLost == 1);
+}
+
+static void testWireLimit() {
+  // requestFrom() takes a uint8_t length: longer reads are refused whole
+  // rather than truncated to the low byte
+  uint8_t reg = 0x00;
+  uint8_t rx[300];
+  I2CTransfer read(0x50, &reg, 1, rx, sizeof(rx));
+  CHECK(i2cTransfer(Wire, read) == I2CBusResult::DATA_TOO_LONG);
+  CHECK(read.status == I2CBusResult::DATA_TOO_LONG);
+  CHECK(read.rxCount == 0);
+  I2CTransfer bare(0x50, nullptr, 0, rx, 256);
+  CHECK(i2cTransfer(Wire, bare) == I2CBusResult::DATA_TOO_LONG);
+}
+
+int main() {
+  testRawTransfers();
+  testNackOnData();
+  testTenBit();
+  testDevice();
+  testGroupWrite();
+  testReleaseBus();
+  testWireLimit();
+  if (failures) fprintf(stderr, "%d checks failed\n", failures);
+  else printf("sim_bus_test: all checks passed\n");
+  return failures ? 1 : 0;
+}
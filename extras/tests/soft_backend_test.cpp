@@ -0,0 +1,196 @@
+// Host test of I2CSoftBackend against the bit-level line model of 
+// I2CSimPins: ACK/NACK, combined transfers with a repeated start, 10-bit 
+// addresses and clock stretching, checked against the target decoder.  
+// Prints the achieved bit rate for each clock setting.
+
+#include <stdio.h>
+#include <I2CDevice.h>
+#include <I2CSimBus.h>
+#include <I2CSimPins.h>
+#include <I2CSoftBackend.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while (0)
+
+typedef I2CSoftBackend<I2CSimPinsRef> SoftBus;
+
+/**
+ * @brief Memory target that NACKs written bytes after the first limit
+ */
+class NackingTarget : public I2CSimMemoryTarget {
+  public:
+    NackingTarget(uint16_t address, uint8_t* memory, size_t size, size_t limit):
+      I2CSimMemoryTarget(address, memory, size), m_limit(limit), m_count(0){};
+
+    bool onStart(bool read) override {
+      if (!read) m_count = 0;
+      return I2CSimMemoryTarget::onStart(read);
+    }
+
+    bool onWrite(uint8_t data) override {
+      if (m_count++ >= m_limit) return false;
+      return I2CSimMemoryTarget::onWrite(data);
+    }
+
+  protected:
+    size_t m_limit;
+    size_t m_count;
+};
+
+static void testTransfers() {
+  I2CSimBus bus;
+  I2CSimPins pins(bus);
+  SoftBus soft{I2CSimPinsRef(pins)};
+  soft.begin();
+  uint8_t memory[16];
+  for (uint8_t i = 0; i < sizeof(memory); i++) memory[i] = i;
+  I2CSimMemoryTarget target(0x50, memory, sizeof(memory));
+  bus.attach(target);
+
+  // Write: pointer then two bytes
+  uint8_t tx[3] = {0x04, 0xAA, 0xBB};
+  I2CTransfer write(0x50, tx, 3);
+  CHECK(soft.transfer(write) == I2CBusResult::SUCCESS);
+  CHECK(memory[4] == 0xAA && memory[5] == 0xBB);
+
+  // Combined write-then-read, joined by a repeated start
+  uint8_t reg = 0x04;
+  uint8_t rx[3] = {0, 0, 0};
+  I2CTransfer combined(0x50, &reg, 1, rx, 3);
+  CHECK(soft.transfer(combined) == I2CBusResult::SUCCESS);
+  CHECK(combined.rxCount == 3 && rx[0] == 0xAA && rx[1] == 0xBB && rx[2] == 0x06);
+
+  // Plain read continues after the last byte read
+  I2CTransfer read(0x50, nullptr, 0, rx, 2);
+  CHECK(soft.transfer(read) == I2CBusResult::SUCCESS);
+  CHECK(rx[0] == 0x07 && rx[1] == 0x08);
+
+  // NACK on address for writes, reads and probes
+  I2CTransfer missingWrite(0x51, tx, 3);
+  CHECK(soft.transfer(missingWrite) == I2CBusResult::NACK_ON_ADDRESS);
+  I2CTransfer missingRead(0x51, nullptr, 0, rx, 2);
+  CHECK(soft.transfer(missingRead) == I2CBusResult::NACK_ON_ADDRESS);
+  CHECK(missingRead.rxCount == 0);
+  I2CTransfer probe(0x51);
+  CHECK(soft.transfer(probe) == I2CBusResult::NACK_ON_ADDRESS);
+  I2CTransfer present(0x50);
+  CHECK(soft.transfer(present) == I2CBusResult::SUCCESS);
+
+  // The bus is usable after the NACKs
+  BasicI2CDevice<SoftBus> device(soft, 0x50);
+  uint8_t value = 0;
+  CHECK(device.readRegister(0x05, value) == I2CBusResult::SUCCESS && value == 0xBB);
+  CHECK(pins.getErrors() == 0);
+}
+
+static void testNackOnData() {
+  I2CSimBus bus;
+  I2CSimPins pins(bus);
+  SoftBus soft{I2CSimPinsRef(pins)};
+  soft.begin();
+  uint8_t memory[16] = {0};
+  NackingTarget target(0x20, memory, sizeof(memory), 2);
+  bus.attach(target);
+  uint8_t tx[4] = {0x00, 0x11, 0x22, 0x33};
+  I2CTransfer write(0x20, tx, 4);
+  CHECK(soft.transfer(write) == I2CBusResult::NACK_ON_DATA);
+  CHECK(memory[0] == 0x11 && memory[1] == 0x00);
+  CHECK(pins.getErrors() == 0);
+}
+
+static void testTenBit() {
+  I2CSimBus bus;
+  I2CSimPins pins(bus);
+  SoftBus soft{I2CSimPinsRef(pins)};
+  soft.begin();
+  uint8_t memory[8] = {0};
+  I2CSimMemoryTarget target(0x2A5, memory, sizeof(memory), 1, true);
+  bus.attach(target);
+
+  BasicI2CDevice<SoftBus, I2CAddress10> device(soft, 0x2A5);
+  BasicI2CDevice<SoftBus, I2CAddress10> other(soft, 0x1A5);
+  CHECK(device.detect());
+  CHECK(!other.detect());
+  uint8_t data[2] = {0x5A, 0xA5};
+  CHECK(device.writeRegisters(0x01, data, 2) == I2CBusResult::SUCCESS);
+  CHECK(memory[1] == 0x5A && memory[2] == 0xA5);
+  uint8_t back[2] = {0, 0};
+  CHECK(device.readRegisters(0x01, back, 2) == I2CBusResult::SUCCESS);
+  CHECK(back[0] == 0x5A && back[1] == 0xA5);
+  CHECK(pins.getErrors() == 0);
+}
+
+static void testClockStretching() {
+  I2CSimBus bus;
+  I2CSimPins pins(bus);
+  SoftBus soft{I2CSimPinsRef(pins)};
+  soft.begin();
+  uint8_t memory[8] = {0};
+  I2CSimMemoryTarget target(0x30, memory, sizeof(memory));
+  bus.attach(target);
+  BasicI2CDevice<SoftBus> device(soft, 0x30);
+
+  // The master waits for the device to release SCL
+  pins.setStretch(50000);
+  uint64_t start = bus.now();
+  CHECK(device.writeRegister(0x02, 0x42) == I2CBusResult::SUCCESS && memory[2] == 0x42);
+  CHECK(bus.now() - start >= 3 * 50000ULL);
+  uint8_t value = 0;
+  CHECK(device.readRegister(0x02, value) == I2CBusResult::SUCCESS && value == 0x42);
+
+  // Stretching past the timeout aborts the transfer
+  soft.setStretchTimeout(20000);
+  CHECK(device.writeRegister(0x03, 0x43) == I2CBusResult::OTHER_ERROR);
+  pins.setStretch(0);
+  soft.setStretchTimeout(25000000UL);
+  CHECK(device.writeRegister(0x03, 0x43) == I2CBusResult::SUCCESS && memory[3] == 0x43);
+}
+
+/**
+ * @brief Run 32-byte writes at a clock and check that the bit rate on the 
+ *        wire stays at or below it
+ */
+static void testBitRate(uint32_t clock) {
+  I2CSimBus bus;
+  I2CSimPins pins(bus);
+  SoftBus soft{I2CSimPinsRef(pins)};
+  soft.begin();
+  soft.setClock(clock);
+  uint8_t memory[64] = {0};
+  I2CSimMemoryTarget target(0x50, memory, sizeof(memory));
+  bus.attach(target);
+
+  uint8_t tx[32] = {0};
+  uint64_t start = bus.now();
+  uint32_t clocks = pins.getClocks();
+  for (uint8_t i = 0; i < 10; i++) {
+    I2CTransfer write(0x50, tx, sizeof(tx));
+    CHECK(soft.transfer(write) == I2CBusResult::SUCCESS);
+  }
+  double seconds = (bus.now() - start) / 1e9;
+  double rate = (pins.getClocks() - clocks) / seconds;
+  printf("%7lu Hz clock: %7.0f bit/s achieved (%.1f%%)\n", (unsigned long)clock, rate, 
+         100.0 * rate / clock);
+  CHECK(rate <= clock);
+  CHECK(rate >= 0.8 * clock);
+  CHECK(pins.getErrors() == 0);
+}
+
+int main() {
+  testTransfers();
+  testNackOnData();
+  testTenBit();
+  testClockStretching();
+  testBitRate(100000);
+  testBitRate(400000);
+  testBitRate(1000000);
+  if (failures) fprintf(stderr, "%d checks failed\n", failures);
+  else printf("soft_backend_test: all checks passed\n");
+  return failures ? 1 : 0;
+}
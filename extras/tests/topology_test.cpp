@@ -0,0 +1,86 @@
+// Host test of the compile-time topology description: the table checks, 
+// the per-bus address tables and the device objects generated from a 
+// table, used on I2CSimBus.
+
+#include <stdio.h>
+#include <I2CDevice.h>
+#include <I2CSimBus.h>
+#include <I2CTopology.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while (0)
+
+typedef BasicI2CDevice<I2CSimBus> Device;
+
+constexpr I2CTopologyNode board[] = {
+  I2CTopology::mux(0, 0x70),            // 0
+  I2CTopology::device(0, 0x68),         // 1: IMU on bus 0
+  I2CTopology::device(0, 0x76, 0, 0),   // 2: behind mux 0, channel 0
+  I2CTopology::device(0, 0x76, 0, 1),   // 3: behind mux 0, channel 1
+  I2CTopology::device(1, 0x50),         // 4: EEPROM on bus 1
+  I2CTopology::device(1, 0x51),         // 5
+};
+I2C_TOPOLOGY_CHECK(board);
+
+constexpr I2CTopologyNode conflicting[] = {
+  I2CTopology::mux(0, 0x70),
+  I2CTopology::device(0, 0x76),
+  I2CTopology::device(0, 0x76, 0, 2),
+};
+static_assert(!I2CTopology::conflictFree(conflicting, I2C_TOPOLOGY_SIZE(conflicting)),
+              "a device upstream of a mux conflicts with the same address behind it");
+
+constexpr I2CTopologyNode reserved[] = { I2CTopology::device(0, 0x78) };
+static_assert(!I2CTopology::reservedFree(reserved, 1), "0x78 is reserved");
+
+constexpr I2CTopologyNode badRef[] = { I2CTopology::device(0, 0x20, 1, 0), I2CTopology::mux(0, 0x70) };
+static_assert(!I2CTopology::muxRefsValid(badRef, 2), "mux references must point backwards");
+
+constexpr auto bus0 = I2C_BUS_TABLE(board, 0);
+constexpr auto bus1 = I2C_BUS_TABLE(board, 1);
+constexpr auto bus2 = I2C_BUS_TABLE(board, 2);
+static_assert(bus0.COUNT == 3 && bus1.COUNT == 2 && bus2.COUNT == 0, "per-bus device counts");
+static_assert(bus0.address[0] == 0x68 && bus0.address[1] == 0x76 && bus0.node[2] == 3, 
+              "bus 0 table");
+static_assert(bus1.address[0] == 0x50 && bus1.address[1] == 0x51 && bus1.node[0] == 4, 
+              "bus 1 table");
+static_assert(I2CTopology::presenceMask(board, I2C_TOPOLOGY_SIZE(board), 0, 0, 1, 3) == 
+              ((1UL << (0x68 % 32)) | (1UL << (0x70 % 32)) | (1UL << (0x76 % 32))),
+              "segment presence mask");
+
+static I2CSimBus simBus0;
+static I2CSimBus simBus1;
+static I2CDeviceSet<Device, bus0.COUNT> devices0 = I2C_BUS_DEVICES(Device, simBus0, board, 0);
+static I2CDeviceSet<Device, bus1.COUNT> devices1 = I2C_BUS_DEVICES(Device, simBus1, board, 1);
+
+static void testDevices() {
+  uint8_t imuMemory[4] = {0x11, 0x22, 0x33, 0x44};
+  uint8_t eepromMemory[2][4] = {{0xA0, 0xA1, 0xA2, 0xA3}, {0xB0, 0xB1, 0xB2, 0xB3}};
+  I2CSimMemoryTarget imu(0x68, imuMemory, sizeof(imuMemory));
+  I2CSimMemoryTarget eeprom0(0x50, eepromMemory[0], sizeof(eepromMemory[0]));
+  I2CSimMemoryTarget eeprom1(0x51, eepromMemory[1], sizeof(eepromMemory[1]));
+  simBus0.attach(imu);
+  simBus1.attach(eeprom0);
+  simBus1.attach(eeprom1);
+
+  CHECK(devices0[0].getAddress() == 0x68 && devices0[2].getAddress() == 0x76);
+  uint8_t value = 0;
+  CHECK(devices0[0].readRegister(0x02, value) == I2CBusResult::SUCCESS && value == 0x33);
+  CHECK(devices1[1].readRegister(0x01, value) == I2CBusResult::SUCCESS && value == 0xB1);
+  CHECK(&devices1[0].getWireInstance() == &simBus1);
+  Device single = I2CTopology::makeDevice<Device>(simBus1, board[4]);
+  CHECK(single.readRegister(0x03, value) == I2CBusResult::SUCCESS && value == 0xA3);
+}
+
+int main() {
+  testDevices();
+  if (failures) fprintf(stderr, "%d checks failed\n", failures);
+  else printf("topology_test: all checks passed\n");
+  return failures ? 1 : 0;
+}
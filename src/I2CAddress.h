@@ -0,0 +1,166 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CAddress.h 
+//!  @brief I2C address width traits
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_ADDRESS_LIB_H_
+#define I2C_ADDRESS_LIB_H_
+
+#include "I2CBackend.h"
+
+/**
+ * @brief Address traits for standard 7-bit I2C addresses.
+ * 
+ *        The address width is a template parameter of BasicI2CDevice, so 
+ *        7-bit devices store a single byte and keep the plain TwoWire calls.
+ */
+struct I2CAddress7 {
+  typedef uint8_t Type;                    //!< Storage type of the address
+  static constexpr uint8_t BYTES = 1;      //!< Address bytes sent on the bus
+  static constexpr uint8_t FLAGS = 0;      //!< I2CTransfer flags for this width
+
+  /**
+   * @brief Begin a TwoWire-style transmission to a device
+   * 
+   * @param bus The TwoWire object or backend
+   * @param address The 7-bit device address
+   */
+  template <class Bus>
+  static inline void begin(Bus& bus, Type address) {
+    bus.beginTransmission(address);
+  }
+
+  /**
+   * @brief Request bytes from a device with TwoWire-style calls
+   * 
+   * @param bus The TwoWire object or backend
+   * @param address The 7-bit device address
+   * @param quantity The number of bytes to request
+   * @return The number of bytes returned and stored in the buffer
+   */
+  template <class Bus>
+  static inline uint8_t request(Bus& bus, Type address, uint8_t quantity) {
+    return bus.requestFrom(address, quantity);
+  }
+};
+
+/**
+ * @brief Address traits for 10-bit I2C addresses.
+ * 
+ *        A 10-bit address is sent as the reserved 7-bit prefix 11110XX 
+ *        (XX being address bits 9-8) followed by a byte holding address 
+ *        bits 7-0.  Reads re-address with only the prefix after a repeated 
+ *        start, which is how a TwoWire bus behaves when the address phase 
+ *        is written with endTransmission(false) before requestFrom().
+ */
+struct I2CAddress10 {
+  typedef uint16_t Type;                   //!< Storage type of the address
+  static constexpr uint8_t BYTES = 2;      //!< Address bytes sent on the bus
+  static constexpr uint8_t FLAGS = I2CTransfer::TEN_BIT; //!< I2CTransfer flags for this width
+
+  /**
+   * @brief Get the 7-bit prefix used on the bus for a 10-bit address
+   * 
+   * @param address The 10-bit device address
+   * @return The 7-bit prefix 11110XX
+   */
+  static constexpr uint8_t prefix(Type address) {
+    return (uint8_t)(0x78 | ((address >> 8) & 0x03));
+  }
+
+  /**
+   * @brief Get the second address byte of a 10-bit address
+   * 
+   * @param address The 10-bit device address
+   * @return Address bits 7-0
+   */
+  static constexpr uint8_t low(Type address) {
+    return (uint8_t)(address & 0xFF);
+  }
+
+  /**
+   * @brief Begin a TwoWire-style transmission to a device.  Sends the 
+   *        two-byte address phase.
+   * 
+   * @param bus The TwoWire object or backend
+   * @param address The 10-bit device address
+   */
+  template <class Bus>
+  static inline void begin(Bus& bus, Type address) {
+    bus.beginTransmission(prefix(address));
+    bus.write(low(address));
+  }
+
+  /**
+   * @brief Request bytes from a device with TwoWire-style calls.  
+   *        Selects the device with a full address phase, then reads after 
+   *        a repeated start.
+   * 
+   * @param bus The TwoWire object or backend
+   * @param address The 10-bit device address
+   * @param quantity The number of bytes to request
+   * @return The number of bytes returned and stored in the buffer
+   */
+  template <class Bus>
+  static inline uint8_t request(Bus& bus, Type address, uint8_t quantity) {
+    begin(bus, address);
+    if (bus.endTransmission(0) != I2CBusResult::SUCCESS) return 0;
+    return bus.requestFrom(prefix(address), quantity);
+  }
+};
+#endif /* I2C_ADDRESS_LIB_H_ */
@@ -0,0 +1,240 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CAddressAssigner.h 
+//!  @brief I2CAddressAssigner class definition
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_ADDRESS_ASSIGNER_LIB_H_
+#define I2C_ADDRESS_ASSIGNER_LIB_H_
+
+#include "I2CDevice.h"
+#include "I2CClock.h"
+
+/**
+ * @brief Address change command for devices that take their new address 
+ *        through a register write, e.g. the VL53L0X/VL53L1X 
+ *        (I2C_SLAVE_DEVICE_ADDRESS register 0x8A, 7-bit value).
+ * 
+ * @tparam Device The I2C device type, an instance of BasicI2CDevice
+ * @tparam Reg The address register
+ * @param device The device, still at its old address
+ * @param address The new address
+ * @return The I2C Bus result
+ */
+template <class Device, uint8_t Reg>
+uint8_t i2cAddressRegisterChange(Device& device, typename Device::AddressType address) {
+  return device.writeRegister(Reg, (uint8_t)(address & 0x7F));
+}
+
+/**
+ * @brief Gives identical devices that share a default address their own 
+ *        addresses at runtime, so they can sit directly on one bus instead 
+ *        of behind a multiplexer.
+ * 
+ *        Every device has an enable (shutdown/reset) pin.  assign() holds all
+ *        devices in reset, then enables them one at a time: the enabled 
+ *        device is the only one answering at the default address, receives 
+ *        the address change command, and its device object is updated to 
+ *        the new address.
+ * 
+ * @tparam Device The I2C device type, an instance of BasicI2CDevice
+ * @tparam Capacity The maximum number of devices
+ * @tparam Clock The time source, e.g. I2CArduinoClock or I2CSimClock
+ */
+template <class Device = I2CDevice, uint8_t Capacity = 8, class Clock = I2CDefaultClock>
+class I2CAddressAssigner : public I2CBusResult {
+  public:
+    typedef typename Device::AddressType AddressType; //!< The device address type
+
+    /**
+     * @brief Address change command, sent to the device at its old address
+     */
+    typedef uint8_t (*ChangeCommand)(Device& device, AddressType address);
+
+    /**
+     * @brief Enable pin control: drive pin high (on = true) or low
+     */
+    typedef void (*EnableControl)(uint8_t pin, bool on);
+
+    /**
+     * @brief Construct an address assigner
+     * 
+     * @param command The address change command
+     * @param enable The enable pin control, defaults to pinMode/digitalWrite 
+     *               on Arduino.  Required on other platforms.
+     * @param clock The time source
+     */
+#if defined(ARDUINO)
+    I2CAddressAssigner(ChangeCommand command, EnableControl enable = arduinoEnable,
+                       const Clock& clock = Clock()):
+#else
+    I2CAddressAssigner(ChangeCommand command, EnableControl enable,
+                       const Clock& clock = Clock()):
+#endif
+      m_command(command), m_enable(enable), m_clock(clock), m_count(0),
+      m_resetUs(10000), m_bootUs(2000){};
+
+    /**
+     * @brief Add a device.  The device object must be set to the default 
+     *        (power-on) address, which the device returns to when it is 
+     *        held in reset.
+     * 
+     * @param device The device
+     * @param enablePin The pin connected to the device's enable/shutdown input
+     * @param address The address to assign
+     * @return bool True if the device was added
+     */
+    bool add(Device& device, uint8_t enablePin, AddressType address) {
+      if (m_count >= Capacity) return false;
+      Entry& e = m_entries[m_count++];
+      e.device = &device;
+      e.pin = enablePin;
+      e.initial = device.getAddress();
+      e.address = address;
+      e.status = OTHER_ERROR;
+      return true;
+    }
+
+    /**
+     * @brief Set the reset and boot times
+     * 
+     * @param resetUs Time all devices are held in reset
+     * @param bootUs Time a device needs after enable before it answers
+     */
+    inline void setTiming(uint32_t resetUs, uint32_t bootUs) {
+      m_resetUs = resetUs;
+      m_bootUs = bootUs;
+    }
+
+    /**
+     * @brief Run the assignment flow for all devices
+     * 
+     * @return The number of devices now at their assigned address
+     */
+    uint8_t assign() {
+      for (uint8_t i = 0; i < m_count; i++) m_enable(m_entries[i].pin, false);
+      m_clock.delayUs(m_resetUs);
+      uint8_t assigned = 0;
+      for (uint8_t i = 0; i < m_count; i++) {
+        if (assignOne(m_entries[i]) == SUCCESS) assigned++;
+      }
+      return assigned;
+    }
+
+    /**
+     * @brief Get the result of the assignment of a device
+     * 
+     * @param index The device index (in order of adding)
+     * @return SUCCESS, NACK_ON_ADDRESS if the device did not answer at its 
+     *         default address or at its new address, or the bus result of 
+     *         the change command
+     */
+    inline uint8_t getStatus(uint8_t index) const { return m_entries[index].status; }
+
+  protected:
+    struct Entry {
+      Device* device;      //!< The device object
+      uint8_t pin;         //!< The enable pin
+      AddressType initial; //!< The default (power-on) address
+      AddressType address; //!< The address to assign
+      uint8_t status;      //!< The assignment result
+    };
+
+    /**
+     * @brief Enable a device and move it to its address.  A device that 
+     *        fails is put back into reset, so it does not answer at the 
+     *        default address when the next device is enabled.
+     */
+    uint8_t assignOne(Entry& e) {
+      m_enable(e.pin, true);
+      m_clock.delayUs(m_bootUs);
+      Device& device = *e.device;
+      device.setAddress(e.initial);
+      if (!device.detect()) return fail(e, NACK_ON_ADDRESS);
+      if (e.address != e.initial) {
+        uint8_t status = m_command(device, e.address);
+        if (status != SUCCESS) return fail(e, status);
+        device.setAddress(e.address);
+        if (!device.detect()) {
+          device.setAddress(e.initial);
+          return fail(e, NACK_ON_ADDRESS);
+        }
+      }
+      return e.status = SUCCESS;
+    }
+
+    uint8_t fail(Entry& e, uint8_t status) {
+      m_enable(e.pin, false);
+      return e.status = status;
+    }
+
+#if defined(ARDUINO)
+    static void arduinoEnable(uint8_t pin, bool on) {
+      pinMode(pin, OUTPUT);
+      digitalWrite(pin, on ? HIGH : LOW);
+    }
+#endif
+
+    ChangeCommand m_command;     //!< The address change command
+    EnableControl m_enable;      //!< The enable pin control
+    Clock m_clock;               //!< The time source
+    Entry m_entries[Capacity];   //!< The managed devices
+    uint8_t m_count;             //!< The number of managed devices
+    uint32_t m_resetUs;          //!< Time all devices are held in reset
+    uint32_t m_bootUs;           //!< Boot time after enable
+};
+#endif /* I2C_ADDRESS_ASSIGNER_LIB_H_ */
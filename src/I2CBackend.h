@@ -0,0 +1,393 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CBackend.h 
+//!  @brief I2CBackend transaction interface definition
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_BACKEND_LIB_H_
+#define I2C_BACKEND_LIB_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * @brief I2C bus result constants shared by I2CDevice and all backends.
+ */
+struct I2CBusResult {
+  /**
+   * @brief I2C Bus reutrn value on successful transmission.
+   */
+  static constexpr uint8_t SUCCESS = 0x0;
+  /**
+   * @brief I2C Bus return value on data overrun (data longer than expected)
+   */
+  static constexpr uint8_t DATA_TOO_LONG = 0x1;
+  /**
+   * @brief I2C Bus return value on device NACK on address transmission
+   */
+  static constexpr uint8_t NACK_ON_ADDRESS = 0x2;
+  /**
+   * @brief I2C Bus return value on device NACK on data transmission
+   */
+  static constexpr uint8_t NACK_ON_DATA = 0x3;
+  /**
+   * @brief I2C Bus return value for all other errors
+   */
+  static constexpr uint8_t OTHER_ERROR = 0x4;
+  /**
+   * @brief I2C Bus return value when another controller won arbitration 
+   *        (0x5 is left to the timeout code of some Wire cores)
+   */
+  static constexpr uint8_t ARBITRATION_LOST = 0x6;
+};
+
+struct I2CTransfer;
+
+/**
+ * @brief Completion callback for asynchronous transfers.  Called with the 
+ *        finished transfer, possibly from interrupt context.
+ */
+typedef void (*I2CTransferCallback)(I2CTransfer& xfer);
+
+/**
+ * @brief A complete I2C transaction: an optional write phase followed by an 
+ *        optional read phase joined by a repeated start.
+ */
+struct I2CTransfer {
+  /**
+   * @brief Do not send a stop condition after the transaction, 
+   *        the bus is kept for the next one.
+   */
+  static constexpr uint8_t NO_STOP = 0x01;
+  /**
+   * @brief The address is a 10-bit address
+   */
+  static constexpr uint8_t TEN_BIT = 0x02;
+  /**
+   * @brief Run the transaction in high-speed mode (3.4 MHz).  The backend 
+   *        sends the master code first unless the bus is already in 
+   *        high-speed mode, and drops back to the normal clock on STOP.
+   */
+  static constexpr uint8_t HIGH_SPEED = 0x04;
+
+  uint16_t address;           //!< The 7-bit (or 10-bit) device address
+  uint8_t flags;              //!< Transfer option flags (NO_STOP, TEN_BIT, HIGH_SPEED)
+  uint8_t status;             //!< The bus result, set when the transfer completes
+  const uint8_t* txData;      //!< The data to write, may be nullptr if txLength is 0
+  size_t txLength;            //!< The number of bytes to write
+  uint8_t* rxData;            //!< The buffer to read into, may be nullptr if rxLength is 0
+  size_t rxLength;            //!< The number of bytes to read
+  size_t rxCount;             //!< The number of bytes actually read
+  I2CTransferCallback onComplete; //!< Optional completion callback
+  void* context;              //!< User pointer for the completion callback
+
+  I2CTransfer(uint16_t addr = 0x0, 
+              const uint8_t* tx = nullptr, size_t txLen = 0,
+              uint8_t* rx = nullptr, size_t rxLen = 0):
+    address(addr), flags(0), status(I2CBusResult::SUCCESS), 
+    txData(tx), txLength(txLen), rxData(rx), rxLength(rxLen), rxCount(0),
+    onComplete(nullptr), context(nullptr){};
+};
+
+/**
+ * @brief Base class for I2C bus backends that can execute whole 
+ *        transactions at once (DMA engines, bit-banged buses, simulators).
+ * 
+ *        Backends only implement transfer().  This class provides the same 
+ *        beginTransmission()/write()/endTransmission()/requestFrom()/read()
+ *        interface as TwoWire on top of it, so any backend can be used 
+ *        wherever I2CDevice expects a bus.  A write ended with 
+ *        endTransmission(false) is held back and merged with the following
+ *        requestFrom() into a single write-then-read transfer.
+ */
+class I2CBackend : public I2CBusResult {
+  public:
+    /**
+     * @brief The size of the Wire-compatible transmit and receive buffers
+     */
+    static constexpr size_t BUFFER_SIZE = 32;
+
+    I2CBackend():
+      m_clock(100000), m_address(0), m_txLength(0), m_rxLength(0), 
+      m_rxPosition(0), m_pending(false), m_hsClock(3400000), m_masterCode(0x08),
+      m_hsActive(false){};
+    virtual ~I2CBackend() = default;
+
+    /**
+     * @brief Execute a transfer, blocking until it is complete.
+     * 
+     * @param xfer The transfer to execute.  status and rxCount are updated.
+     * @return The I2C Bus result
+     */
+    virtual uint8_t transfer(I2CTransfer& xfer) = 0;
+
+    /**
+     * @brief Start a transfer without waiting for it to complete.  
+     *        The transfer's onComplete callback is called on completion.
+     *        Backends without asynchronous support complete the transfer 
+     *        before returning.
+     * 
+     * @param xfer The transfer, must stay valid until completion.
+     * @return bool True if the transfer was started
+     */
+    virtual bool startTransfer(I2CTransfer& xfer) {
+      complete(xfer, transfer(xfer));
+      return true;
+    }
+
+    /**
+     * @brief Check if an asynchronous transfer is in progress
+     * 
+     * @return bool True if the backend is busy
+     */
+    virtual bool isBusy() const { return false; }
+
+    /**
+     * @brief Set the bus clock frequency
+     * 
+     * @param frequency The SCL frequency in Hz
+     */
+    virtual void setClock(uint32_t frequency) { m_clock = frequency; }
+
+    /**
+     * @brief Get the bus clock frequency
+     * 
+     * @return The SCL frequency in Hz 
+     */
+    inline uint32_t getClock() const { return m_clock; }
+
+    /**
+     * @brief Check if the backend can run HIGH_SPEED transfers.  Backends 
+     *        without high-speed support run them at the normal clock.
+     * 
+     * @return bool 
+     */
+    virtual bool supportsHighSpeed() const { return false; }
+
+    /**
+     * @brief Set the high-speed mode clock frequency
+     * 
+     * @param frequency The SCL frequency in Hz, up to 3400000
+     */
+    inline void setHighSpeedClock(uint32_t frequency) { m_hsClock = frequency; }
+
+    /**
+     * @brief Get the high-speed mode clock frequency
+     * 
+     * @return The SCL frequency in Hz 
+     */
+    inline uint32_t getHighSpeedClock() const { return m_hsClock; }
+
+    /**
+     * @brief Set the master code sent to enter high-speed mode.  Each 
+     *        master on a bus needs a unique code.
+     * 
+     * @param code The master code number (0 to 7)
+     */
+    inline void setMasterCode(uint8_t code) { m_masterCode = 0x08 | (code & 0x07); }
+
+    /**
+     * @brief Get the master code byte (00001XXX)
+     * 
+     * @return uint8_t 
+     */
+    inline uint8_t getMasterCode() const { return m_masterCode; }
+
+    /**
+     * @brief Check if the bus is currently held in high-speed mode
+     * 
+     * @return bool 
+     */
+    inline bool isHighSpeedActive() const { return m_hsActive; }
+
+    /**
+     * @brief Send a stop condition if the bus is still held after a 
+     *        NO_STOP transfer.  Leaves high-speed mode.
+     */
+    virtual void releaseBus() { m_hsActive = false; }
+
+    /**
+     * @brief TwoWire compatible beginTransmission()
+     * 
+     * @param address The 7-bit I2C device address
+     */
+    void beginTransmission(uint8_t address) {
+      flushPending();
+      m_address = address;
+      m_txLength = 0;
+    }
+
+    /**
+     * @brief TwoWire compatible write(), queues a byte for transmission
+     * 
+     * @param data The data byte to write.
+     * @return The number of bytes written (1 on success, 0 on failure)
+     */
+    size_t write(uint8_t data) {
+      if (m_txLength >= BUFFER_SIZE) return 0;
+      m_tx[m_txLength++] = data;
+      return 1;
+    }
+
+    /**
+     * @brief TwoWire compatible write(), queues a buffer for transmission
+     * 
+     * @param data A pointer to the data buffer to write
+     * @param size The size of the data buffer in bytes
+     * @return The number of bytes written
+     */
+    size_t write(const uint8_t* data, size_t size) {
+      size_t n = 0;
+      while (n < size && write(data[n])) n++;
+      return n;
+    }
+
+    /**
+     * @brief TwoWire compatible endTransmission()
+     * 
+     * @param sendStop Set to 1 to send stop condition, 0 to not.  Without a 
+     *                 stop the write is deferred and sent together with the 
+     *                 next requestFrom(), in which case SUCCESS is returned 
+     *                 and any error is reported by requestFrom().
+     * @return The I2C Bus result
+     */
+    uint8_t endTransmission(uint8_t sendStop = 1) {
+      if (!sendStop) {
+        m_pending = true;
+        return SUCCESS;
+      }
+      I2CTransfer xfer(m_address, m_tx, m_txLength);
+      return transfer(xfer);
+    }
+
+    /**
+     * @brief TwoWire compatible requestFrom()
+     * 
+     * @param address The 7-bit I2C device address
+     * @param quantity The number of bytes to request
+     * @param sendStop Set to 1 to send stop condition, 0 to not.
+     * @return The number of bytes returned and stored in the buffer
+     */
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop = 1) {
+      if (quantity > BUFFER_SIZE) quantity = BUFFER_SIZE;
+      I2CTransfer xfer(address, nullptr, 0, m_rx, quantity);
+      if (m_pending && m_address == address) {
+        xfer.txData = m_tx;
+        xfer.txLength = m_txLength;
+        m_pending = false;
+      }
+      else flushPending();
+      if (!sendStop) xfer.flags |= I2CTransfer::NO_STOP;
+      m_rxPosition = 0;
+      m_rxLength = (transfer(xfer) == SUCCESS) ? xfer.rxCount : 0;
+      return (uint8_t)m_rxLength;
+    }
+
+    /**
+     * @brief TwoWire compatible available()
+     * 
+     * @return The number of bytes left in the receive buffer
+     */
+    int available() { return (int)(m_rxLength - m_rxPosition); }
+
+    /**
+     * @brief TwoWire compatible read()
+     * 
+     * @return int The data byte or -1 if the buffer is empty
+     */
+    int read() { 
+      return (m_rxPosition < m_rxLength) ? m_rx[m_rxPosition++] : -1; 
+    }
+
+  protected:
+    /**
+     * @brief Store the result of a transfer and call its completion callback
+     * 
+     * @param xfer The finished transfer
+     * @param status The I2C Bus result
+     */
+    static void complete(I2CTransfer& xfer, uint8_t status) {
+      xfer.status = status;
+      if (xfer.onComplete) xfer.onComplete(xfer);
+    }
+
+    /**
+     * @brief Send a write deferred by endTransmission(false) that was not 
+     *        followed by a read from the same device.
+     */
+    void flushPending() {
+      if (!m_pending) return;
+      m_pending = false;
+      I2CTransfer xfer(m_address, m_tx, m_txLength);
+      xfer.flags |= I2CTransfer::NO_STOP;
+      transfer(xfer);
+    }
+
+    uint32_t m_clock;             //!< The SCL frequency in Hz
+    uint8_t m_address;            //!< The address of the current transmission
+    uint8_t m_tx[BUFFER_SIZE];    //!< Wire-compatible transmit buffer
+    uint8_t m_rx[BUFFER_SIZE];    //!< Wire-compatible receive buffer
+    size_t m_txLength;            //!< Bytes queued in the transmit buffer
+    size_t m_rxLength;            //!< Bytes stored in the receive buffer
+    size_t m_rxPosition;          //!< Read position in the receive buffer
+    bool m_pending;               //!< A write is held for a repeated start
+    uint32_t m_hsClock;           //!< The high-speed mode SCL frequency in Hz
+    uint8_t m_masterCode;         //!< The high-speed master code byte
+    bool m_hsActive;              //!< The bus is held in high-speed mode
+};
+#endif /* I2C_BACKEND_LIB_H_ */
@@ -0,0 +1,372 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CBootCache.h 
+//!  @brief I2CBootCache class definition
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_BOOT_CACHE_LIB_H_
+#define I2C_BOOT_CACHE_LIB_H_
+
+#include "I2CDevice.h"
+#include "I2CTopologyScanner.h"
+
+#if defined(ARDUINO) && defined(E2END)
+#include <EEPROM.h>
+
+/**
+ * @brief Boot cache storage in the AVR style EEPROM.  Only changed bytes are 
+ *        written.
+ */
+class I2CEepromStorage {
+  public:
+    /**
+     * @brief Construct an EEPROM storage
+     * 
+     * @param base The first EEPROM address used
+     */
+    I2CEepromStorage(int base = 0): m_base(base){};
+
+    void read(size_t offset, void* data, size_t length) {
+      uint8_t* p = (uint8_t*)data;
+      for (size_t i = 0; i < length; i++) p[i] = EEPROM.read(m_base + offset + i);
+    }
+
+    void write(size_t offset, const void* data, size_t length) {
+      const uint8_t* p = (const uint8_t*)data;
+      for (size_t i = 0; i < length; i++) EEPROM.update(m_base + offset + i, p[i]);
+    }
+
+  protected:
+    int m_base; //!< The first EEPROM address used
+};
+#endif
+
+/**
+ * @brief Boot cache storage in a RAM buffer, e.g. backed by a file or a 
+ *        flash page written by the application
+ */
+class I2CMemoryStorage {
+  public:
+    /**
+     * @brief Construct a memory storage
+     * 
+     * @param memory The buffer
+     * @param size The buffer size
+     */
+    I2CMemoryStorage(uint8_t* memory, size_t size): m_memory(memory), m_size(size){};
+
+    void read(size_t offset, void* data, size_t length) {
+      if (offset + length > m_size) { memset(data, 0xFF, length); return; }
+      memcpy(data, m_memory + offset, length);
+    }
+
+    void write(size_t offset, const void* data, size_t length) {
+      if (offset + length > m_size) return;
+      memcpy(m_memory + offset, data, length);
+    }
+
+  protected:
+    uint8_t* m_memory; //!< The buffer
+    size_t m_size;     //!< The buffer size
+};
+
+/**
+ * @brief Compute a CRC-16/CCITT-FALSE checksum
+ * 
+ * @param data The data
+ * @param length The data length
+ * @param crc The initial value, or the result of a previous call to continue
+ * @return uint16_t 
+ */
+inline uint16_t i2cCrc16(const void* data, size_t length, uint16_t crc = 0xFFFF) {
+  const uint8_t* p = (const uint8_t*)data;
+  while (length--) {
+    crc ^= (uint16_t)(*p++) << 8;
+    for (uint8_t i = 0; i < 8; i++) {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+/**
+ * @brief Warm-start cache of bus presence, device identities and 
+ *        calibration blocks, kept in non-volatile memory.
+ * 
+ *        At boot, load() validates the cache (magic, key and CRC).  Each 
+ *        restore() call then checks the device with a single sentinel read 
+ *        of its identity register and, if the identity matches the cached 
+ *        one, returns the cached calibration block without reading it from 
+ *        the device.  Missing or stale entries are read from the device and 
+ *        updated; store() writes the cache back if anything changed.
+ * 
+ *        The key should change whenever the hardware or the cached layout 
+ *        changes, e.g. a board revision or firmware version.
+ * 
+ * @tparam Storage The storage policy, with read(offset, data, length) and 
+ *                 write(offset, data, length)
+ * @tparam Capacity The maximum number of calibration blocks
+ * @tparam BlockSize The maximum calibration block size
+ */
+template <class Storage, uint8_t Capacity = 8, uint8_t BlockSize = 32>
+class I2CBootCache : public I2CBusResult {
+  public:
+    static constexpr uint16_t MAGIC = 0xC2CA; //!< Cache header magic
+
+    /**
+     * @brief restore() results
+     */
+    enum Result : uint8_t {
+      HIT = 0,   //!< The block was taken from the cache
+      MISS = 1,  //!< The block was read from the device
+      FAILED = 2 //!< The device could not be read
+    };
+
+    /**
+     * @brief A cached calibration block
+     */
+    struct Entry {
+      uint8_t address;           //!< The 7-bit device address
+      uint8_t identity;          //!< The identity register value
+      uint16_t identityRegister; //!< The identity (sentinel) register
+      uint16_t blockRegister;    //!< The first calibration register
+      uint8_t length;            //!< The calibration block length
+      uint8_t data[BlockSize];   //!< The calibration block
+    };
+
+    /**
+     * @brief Cache header, as stored
+     */
+    struct Header {
+      uint16_t magic;          //!< MAGIC
+      uint16_t key;            //!< The validity key
+      uint16_t crc;            //!< CRC of the header (crc = 0) and entries
+      uint8_t count;           //!< The number of entries
+      uint8_t blockSize;       //!< BlockSize, to detect layout changes
+      I2CAddressMask presence; //!< Devices found by the last scan
+    };
+
+    /**
+     * @brief Construct a boot cache
+     * 
+     * @param storage The storage
+     * @param key The validity key
+     */
+    I2CBootCache(Storage& storage, uint16_t key): 
+      m_storage(storage), m_key(key), m_valid(false), m_dirty(false) {
+      m_header.count = 0;
+    };
+
+    /**
+     * @brief Load and validate the cache
+     * 
+     * @return bool True if a valid cache was loaded
+     */
+    bool load() {
+      m_storage.read(0, &m_header, sizeof(Header));
+      m_valid = m_header.magic == MAGIC && m_header.key == m_key && 
+                m_header.blockSize == BlockSize && m_header.count <= Capacity;
+      if (m_valid) {
+        m_storage.read(sizeof(Header), m_entries, m_header.count * sizeof(Entry));
+        m_valid = checksum() == m_header.crc;
+      }
+      if (!m_valid) {
+        m_header.count = 0;
+        m_header.presence.clear();
+      }
+      m_verified.clear();
+      m_dirty = false;
+      return m_valid;
+    }
+
+    /**
+     * @brief Write the cache back if it changed
+     * 
+     * @return bool True if the storage was written
+     */
+    bool store() {
+      if (!m_dirty) return false;
+      m_header.magic = MAGIC;
+      m_header.key = m_key;
+      m_header.blockSize = BlockSize;
+      m_header.crc = checksum();
+      m_storage.write(sizeof(Header), m_entries, m_header.count * sizeof(Entry));
+      m_storage.write(0, &m_header, sizeof(Header));
+      m_valid = true;
+      m_dirty = false;
+      return true;
+    }
+
+    /**
+     * @brief Check if load() found a valid cache
+     * 
+     * @return bool 
+     */
+    inline bool isValid() const { return m_valid; }
+
+    /**
+     * @brief Get the cached presence bitmap.  Only meaningful if isValid().
+     * 
+     * @return const I2CAddressMask& 
+     */
+    inline const I2CAddressMask& getPresence() const { return m_header.presence; }
+
+    /**
+     * @brief Set the presence bitmap, e.g. after a scan
+     * 
+     * @param presence The devices found
+     */
+    void setPresence(const I2CAddressMask& presence) {
+      if (memcmp(&presence, &m_header.presence, sizeof(I2CAddressMask)) == 0) return;
+      m_header.presence = presence;
+      m_dirty = true;
+    }
+
+    /**
+     * @brief Get a calibration block, from the cache if the device identity 
+     *        matches, or from the device otherwise.  The identity register 
+     *        is read once per device and boot.
+     * 
+     * @tparam Device The device type
+     * @param dev The device
+     * @param identityRegister The identity (e.g. chip ID) register
+     * @param blockRegister The first calibration register
+     * @param data Buffer for the calibration block
+     * @param length The calibration block length (at most BlockSize)
+     * @return Result HIT, MISS or FAILED
+     */
+    template <class Device>
+    Result restore(Device& dev, typename Device::RegisterType identityRegister,
+                   typename Device::RegisterType blockRegister, uint8_t* data, uint8_t length) {
+      if (length > BlockSize) return FAILED;
+      uint8_t address = (uint8_t)dev.getAddress();
+      Entry* e = find(address, blockRegister);
+      if (e && e->identityRegister == identityRegister && e->length == length) {
+        if (!m_verified.test(address)) {
+          uint8_t identity;
+          if (dev.readRegister(identityRegister, identity) != SUCCESS) return FAILED;
+          if (identity == e->identity) m_verified.set(address);
+        }
+        if (m_verified.test(address)) {
+          memcpy(data, e->data, length);
+          return HIT;
+        }
+      }
+      uint8_t identity;
+      if (dev.readRegister(identityRegister, identity) != SUCCESS) return FAILED;
+      if (dev.readRegisters(blockRegister, data, length) != SUCCESS) return FAILED;
+      if (!e) {
+        if (m_header.count >= Capacity) return MISS;
+        e = &m_entries[m_header.count++];
+        memset(e, 0, sizeof(Entry));
+      }
+      e->address = address;
+      e->identity = identity;
+      e->identityRegister = identityRegister;
+      e->blockRegister = blockRegister;
+      e->length = length;
+      memcpy(e->data, data, length);
+      m_verified.set(address);
+      m_dirty = true;
+      return MISS;
+    }
+
+    /**
+     * @brief Drop all entries and the presence bitmap
+     */
+    void clear() {
+      m_header.count = 0;
+      m_header.presence.clear();
+      m_verified.clear();
+      m_dirty = true;
+    }
+
+    /**
+     * @brief Get the number of bytes used in the storage
+     * 
+     * @return size_t 
+     */
+    inline size_t usedBytes() const { 
+      return sizeof(Header) + m_header.count * sizeof(Entry); 
+    }
+
+  protected:
+    Entry* find(uint8_t address, uint16_t blockRegister) {
+      for (uint8_t i = 0; i < m_header.count; i++) {
+        if (m_entries[i].address == address && m_entries[i].blockRegister == blockRegister) {
+          return &m_entries[i];
+        }
+      }
+      return nullptr;
+    }
+
+    uint16_t checksum() const {
+      Header h = m_header;
+      h.crc = 0;
+      uint16_t crc = i2cCrc16(&h, sizeof(Header));
+      return i2cCrc16(m_entries, m_header.count * sizeof(Entry), crc);
+    }
+
+    Storage& m_storage;          //!< The non-volatile storage
+    uint16_t m_key;              //!< The validity key
+    bool m_valid;                //!< A valid cache was loaded
+    bool m_dirty;                //!< The cache changed since load() or store()
+    I2CAddressMask m_verified;   //!< Devices whose identity was checked this boot
+    Header m_header;             //!< The cache header
+    Entry m_entries[Capacity];   //!< The cached calibration blocks
+};
+#endif /* I2C_BOOT_CACHE_LIB_H_ */
@@ -0,0 +1,402 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CBroker.h 
+//!  @brief I2CBroker class definition
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_BROKER_LIB_H_
+#define I2C_BROKER_LIB_H_
+
+#include "I2CBusEngine.h"
+
+#if !defined(ARDUINO) && defined(__linux__)
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * @brief Wire format between I2CBrokerClient and I2CBroker.  One request 
+ *        and one response per SOCK_SEQPACKET message, in host byte order.
+ * 
+ *        Request: Header, then count times (Op, txLength bytes).
+ *        Response: Header, then count times (Result, rxCount bytes).
+ */
+struct I2CBrokerProtocol {
+  static constexpr uint16_t MAGIC = 0x4249;      //!< "IB"
+  static constexpr uint8_t VERSION = 1;          //!< Protocol version
+  static constexpr size_t MAX_MESSAGE = 4096;    //!< Maximum message size
+  static constexpr uint8_t MAX_OPS = 32;         //!< Maximum transfers per batch
+
+  struct Header {
+    uint16_t magic;     //!< MAGIC
+    uint8_t version;    //!< VERSION
+    uint8_t priority;   //!< Request priority, higher runs first
+    uint16_t count;     //!< The number of transfers
+    uint16_t reserved;  //!< Zero
+  };
+
+  struct Op {
+    uint16_t address;   //!< The device address
+    uint8_t flags;      //!< I2CTransfer flags
+    uint8_t reserved;   //!< Zero
+    uint16_t txLength;  //!< Bytes written, following the Op
+    uint16_t rxLength;  //!< Bytes to read
+  };
+
+  struct Result {
+    uint8_t status;     //!< The I2C Bus result
+    uint8_t reserved;   //!< Zero
+    uint16_t rxCount;   //!< Bytes read, following the Result
+  };
+};
+
+/**
+ * @brief Broker statistics
+ */
+struct I2CBrokerStats {
+  uint32_t clients;   //!< Connections accepted
+  uint32_t requests;  //!< Batches received
+  uint32_t rejected;  //!< Malformed batches
+  uint32_t transfers; //!< Transfers requested
+  uint32_t dropped;   //!< Clients dropped because they stopped reading responses
+};
+
+/**
+ * @brief Local bus broker: owns a bus and serves batched transfer requests 
+ *        from I2CBrokerClient processes over a Unix domain socket.
+ * 
+ *        Each poll() collects one batch from every client with a request 
+ *        waiting, queues the batches in priority order (arrival order for 
+ *        equal priorities) on an I2CBusEngine, runs them and returns the 
+ *        results.  Identical reads from different clients in the same round 
+ *        are executed once (see I2CBusEngine), transfers of one batch run 
+ *        in order, and transfers losing arbitration are retried.
+ * 
+ * @tparam Bus The bus type, e.g. I2CLinuxBackend
+ * @tparam MaxClients The maximum number of connected clients
+ */
+template <class Bus, uint8_t MaxClients = 16>
+class I2CBroker : public I2CBusResult {
+  public:
+    typedef I2CBusEngine<Bus, I2CBrokerProtocol::MAX_OPS, 1> Engine; //!< FIFO engine
+
+    /**
+     * @brief Construct a broker
+     * 
+     * @param bus The bus
+     * @param clock The bus clock in Hz, for the engine's timing model
+     */
+    I2CBroker(Bus& bus, uint32_t clock = 100000): 
+      m_engine(bus, clock), m_listen(-1), m_stats() {
+      for (uint8_t i = 0; i < MaxClients; i++) m_clients[i].fd = -1;
+    };
+
+    ~I2CBroker() { close(); }
+
+    /**
+     * @brief Listen on a socket path, replacing a stale socket file
+     * 
+     * @param path The socket path
+     * @return bool False if the socket could not be created
+     */
+    bool listen(const char* path) {
+      close();
+      struct sockaddr_un addr;
+      memset(&addr, 0, sizeof(addr));
+      addr.sun_family = AF_UNIX;
+      if (strlen(path) >= sizeof(addr.sun_path)) return false;
+      strcpy(addr.sun_path, path);
+      m_listen = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+      if (m_listen < 0) return false;
+      unlink(path);
+      if (bind(m_listen, (struct sockaddr*)&addr, sizeof(addr)) < 0 || 
+          ::listen(m_listen, MaxClients) < 0) {
+        close();
+        return false;
+      }
+      return true;
+    }
+
+    /**
+     * @brief Serve an already connected socket, e.g. one end of a 
+     *        socketpair() or a socket inherited from a service manager
+     * 
+     * @param fd The SOCK_SEQPACKET socket, closed by the broker when the 
+     *           client is dropped
+     * @return bool False if all client entries are in use, fd is then closed
+     */
+    bool adopt(int fd) {
+      for (uint8_t i = 0; i < MaxClients; i++) {
+        if (m_clients[i].fd < 0) {
+          m_clients[i].fd = fd;
+          m_stats.clients++;
+          return true;
+        }
+      }
+      ::close(fd);
+      return false;
+    }
+
+    /**
+     * @brief Close the listening socket and all clients
+     */
+    void close() {
+      if (m_listen >= 0) ::close(m_listen);
+      m_listen = -1;
+      for (uint8_t i = 0; i < MaxClients; i++) drop(m_clients[i]);
+    }
+
+    /**
+     * @brief Serve requests until an error occurs
+     */
+    void run() {
+      while (poll(-1) >= 0) {}
+    }
+
+    /**
+     * @brief Accept new clients and serve one round of requests
+     * 
+     * @param timeoutMs The time to wait for activity, -1 to wait forever
+     * @return The number of batches served, -1 on error
+     */
+    int poll(int timeoutMs) {
+      struct pollfd fds[MaxClients + 1];
+      uint8_t index[MaxClients];
+      nfds_t count = 0;
+      fds[count].fd = m_listen;
+      fds[count].events = POLLIN;
+      count++;
+      for (uint8_t i = 0; i < MaxClients; i++) {
+        if (m_clients[i].fd < 0) continue;
+        index[count - 1] = i;
+        fds[count].fd = m_clients[i].fd;
+        fds[count].events = POLLIN;
+        count++;
+      }
+      if (::poll(fds, count, timeoutMs) < 0) return errno == EINTR ? 0 : -1;
+      if (fds[0].revents & POLLIN) accept();
+      uint8_t ready[MaxClients];
+      uint8_t readyCount = 0;
+      for (nfds_t f = 1; f < count; f++) {
+        if (!fds[f].revents) continue;
+        Client& c = m_clients[index[f - 1]];
+        if (receive(c)) ready[readyCount++] = index[f - 1];
+        else drop(c);
+      }
+      serve(ready, readyCount);
+      return readyCount;
+    }
+
+    /**
+     * @brief Get the bus engine, e.g. for its merge statistics
+     * 
+     * @return Engine& 
+     */
+    inline Engine& getEngine() { return m_engine; }
+
+    /**
+     * @brief Get the broker statistics
+     * 
+     * @return const I2CBrokerStats& 
+     */
+    inline const I2CBrokerStats& getStats() const { return m_stats; }
+
+  protected:
+    typedef I2CBrokerProtocol Protocol;
+
+    /**
+     * @brief A connected client and its current batch
+     */
+    struct Client {
+      int fd;                                    //!< The socket, -1 if unused
+      uint8_t priority;                          //!< Priority of the batch
+      uint16_t count;                            //!< Transfers in the batch
+      uint8_t request[Protocol::MAX_MESSAGE];    //!< The request message
+      uint8_t rx[Protocol::MAX_MESSAGE];         //!< Read buffers of the batch
+      I2CTransfer xfers[Protocol::MAX_OPS];      //!< The transfers of the batch
+    };
+
+    void accept() {
+      int fd = ::accept(m_listen, nullptr, nullptr);
+      if (fd >= 0) adopt(fd);
+    }
+
+    void drop(Client& c) {
+      if (c.fd >= 0) ::close(c.fd);
+      c.fd = -1;
+    }
+
+    /**
+     * @brief Receive and parse a batch.  The transfers point into the 
+     *        client's request and read buffers.
+     * 
+     * @return bool False if the client disconnected or sent a bad request
+     */
+    bool receive(Client& c) {
+      ssize_t length = recv(c.fd, c.request, sizeof(c.request), 0);
+      if (length <= 0) return false;
+      m_stats.requests++;
+      const Protocol::Header* h = (const Protocol::Header*)c.request;
+      if ((size_t)length < sizeof(Protocol::Header) || h->magic != Protocol::MAGIC ||
+          h->version != Protocol::VERSION || h->count > Protocol::MAX_OPS) {
+        m_stats.rejected++;
+        return false;
+      }
+      size_t pos = sizeof(Protocol::Header);
+      size_t rxPos = sizeof(Protocol::Header);
+      for (uint16_t i = 0; i < h->count; i++) {
+        Protocol::Op op;
+        if (pos + sizeof(op) > (size_t)length) break;
+        memcpy(&op, c.request + pos, sizeof(op));
+        pos += sizeof(op);
+        rxPos += sizeof(Protocol::Result);
+        if (pos + op.txLength > (size_t)length || rxPos + op.rxLength > sizeof(c.rx)) break;
+        I2CTransfer& x = c.xfers[i];
+        x = I2CTransfer(op.address, c.request + pos, op.txLength, c.rx + rxPos, op.rxLength);
+        x.flags = op.flags & I2CTransfer::TEN_BIT;
+        pos += op.txLength;
+        rxPos += op.rxLength;
+        if (i + 1 == h->count) {
+          c.priority = h->priority;
+          c.count = h->count;
+          m_stats.transfers += c.count;
+          return true;
+        }
+      }
+      if (h->count == 0) {
+        c.priority = h->priority;
+        c.count = 0;
+        return true;
+      }
+      m_stats.rejected++;
+      return false;
+    }
+
+    /**
+     * @brief Run the batches of the ready clients by priority and send the 
+     *        responses
+     */
+    void serve(uint8_t* ready, uint8_t count) {
+      for (uint8_t i = 1; i < count; i++) {
+        uint8_t c = ready[i];
+        uint8_t j = i;
+        while (j > 0 && m_clients[ready[j - 1]].priority < m_clients[c].priority) {
+          ready[j] = ready[j - 1];
+          j--;
+        }
+        ready[j] = c;
+      }
+      for (uint8_t i = 0; i < count; i++) {
+        Client& c = m_clients[ready[i]];
+        for (uint16_t k = 0; k < c.count; k++) {
+          while (!m_engine.submit(c.xfers[k])) drain();
+        }
+      }
+      drain();
+      for (uint8_t i = 0; i < count; i++) respond(m_clients[ready[i]]);
+    }
+
+    /**
+     * @brief Run the engine until all queued transfers completed
+     */
+    void drain() {
+      while (m_engine.pending()) {
+        if (!m_engine.poll()) usleep(50);
+      }
+    }
+
+    /**
+     * @brief Send the results of a client's batch, reusing its read buffer.  
+     *        The send never blocks: a client whose socket buffer is full 
+     *        stopped reading responses and is dropped, so it cannot stall 
+     *        the other clients.
+     */
+    void respond(Client& c) {
+      Protocol::Header h;
+      memset(&h, 0, sizeof(h));
+      h.magic = Protocol::MAGIC;
+      h.version = Protocol::VERSION;
+      h.count = c.count;
+      memcpy(c.rx, &h, sizeof(h));
+      size_t pos = sizeof(h);
+      for (uint16_t k = 0; k < c.count; k++) {
+        const I2CTransfer& x = c.xfers[k];
+        Protocol::Result r;
+        r.status = x.status;
+        r.reserved = 0;
+        r.rxCount = (uint16_t)(x.status == SUCCESS ? x.rxCount : 0);
+        memcpy(c.rx + pos, &r, sizeof(r));
+        pos += sizeof(r);
+        if (r.rxCount && c.rx + pos != x.rxData) memmove(c.rx + pos, x.rxData, r.rxCount);
+        pos += r.rxCount;
+      }
+      if (send(c.fd, c.rx, pos, MSG_NOSIGNAL | MSG_DONTWAIT) < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) m_stats.dropped++;
+        drop(c);
+      }
+    }
+
+    Engine m_engine;                //!< Runs the transfers
+    int m_listen;                   //!< The listening socket
+    Client m_clients[MaxClients];   //!< The clients
+    I2CBrokerStats m_stats;         //!< Statistics
+};
+#endif
+#endif /* I2C_BROKER_LIB_H_ */
@@ -0,0 +1,259 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CBrokerClient.h 
+//!  @brief I2CBrokerClient class definition
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_BROKER_CLIENT_LIB_H_
+#define I2C_BROKER_CLIENT_LIB_H_
+
+#include "I2CBroker.h"
+
+#if !defined(ARDUINO) && defined(__linux__)
+
+/**
+ * @brief Backend that sends transfers to an I2CBroker process instead of 
+ *        opening the bus, so BasicI2CDevice<I2CBrokerClient> works like a 
+ *        device on a local bus.
+ * 
+ *        transfer() sends a batch of one and waits for the result.  
+ *        startTransfer() only queues the transfer: queued transfers are 
+ *        sent as one batch by flush() (or when the batch is full) and 
+ *        complete through their callbacks when the response arrives.
+ */
+class I2CBrokerClient : public I2CBackend {
+  public:
+    typedef I2CBrokerProtocol Protocol;
+
+    I2CBrokerClient(): m_fd(-1), m_priority(0), m_count(0), m_bytes(0){};
+    ~I2CBrokerClient() { close(); }
+
+    /**
+     * @brief Connect to a broker
+     * 
+     * @param path The broker socket path
+     * @param priority The priority of this client's batches, higher runs first
+     * @return bool False if the broker could not be reached
+     */
+    bool connect(const char* path, uint8_t priority = 0) {
+      close();
+      struct sockaddr_un addr;
+      memset(&addr, 0, sizeof(addr));
+      addr.sun_family = AF_UNIX;
+      if (strlen(path) >= sizeof(addr.sun_path)) return false;
+      strcpy(addr.sun_path, path);
+      m_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+      if (m_fd < 0) return false;
+      if (::connect(m_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close();
+        return false;
+      }
+      m_priority = priority;
+      return true;
+    }
+
+    /**
+     * @brief Disconnect from the broker.  Queued transfers fail.
+     */
+    void close() {
+      if (m_fd >= 0) ::close(m_fd);
+      m_fd = -1;
+      I2CTransfer* batch[Protocol::MAX_OPS];
+      uint8_t count = take(batch);
+      fail(batch, count, 0);
+    }
+
+    /**
+     * @brief Set the priority of this client's batches
+     * 
+     * @param priority The priority, higher runs first
+     */
+    inline void setPriority(uint8_t priority) { m_priority = priority; }
+
+    uint8_t transfer(I2CTransfer& xfer) override {
+      I2CTransferCallback callback = xfer.onComplete;
+      xfer.onComplete = nullptr;
+      if (!queue(xfer)) {
+        xfer.onComplete = callback;
+        return xfer.status = DATA_TOO_LONG;
+      }
+      flush();
+      xfer.onComplete = callback;
+      return xfer.status;
+    }
+
+    bool startTransfer(I2CTransfer& xfer) override {
+      return queue(xfer);
+    }
+
+    bool isBusy() const override { return m_count > 0; }
+
+    /**
+     * @brief Send the queued transfers as one batch and wait for the results.  
+     *        The batch is taken off the queue first, so completion callbacks 
+     *        may queue new transfers.
+     * 
+     * @return bool False if the broker could not be reached, the transfers 
+     *         then complete with OTHER_ERROR
+     */
+    bool flush() {
+      if (!m_count) return true;
+      I2CTransfer* batch[Protocol::MAX_OPS];
+      uint8_t count = take(batch);
+      uint8_t message[Protocol::MAX_MESSAGE];
+      Protocol::Header h;
+      memset(&h, 0, sizeof(h));
+      h.magic = Protocol::MAGIC;
+      h.version = Protocol::VERSION;
+      h.priority = m_priority;
+      h.count = count;
+      memcpy(message, &h, sizeof(h));
+      size_t pos = sizeof(h);
+      for (uint8_t i = 0; i < count; i++) {
+        const I2CTransfer& x = *batch[i];
+        Protocol::Op op;
+        op.address = x.address;
+        op.flags = x.flags;
+        op.reserved = 0;
+        op.txLength = (uint16_t)x.txLength;
+        op.rxLength = (uint16_t)x.rxLength;
+        memcpy(message + pos, &op, sizeof(op));
+        pos += sizeof(op);
+        if (x.txLength) memcpy(message + pos, x.txData, x.txLength);
+        pos += x.txLength;
+      }
+      if (m_fd < 0 || send(m_fd, message, pos, MSG_NOSIGNAL) < 0) return fail(batch, count, 0);
+      ssize_t length = recv(m_fd, message, sizeof(message), 0);
+      if (length < (ssize_t)sizeof(h)) return fail(batch, count, 0);
+      memcpy(&h, message, sizeof(h));
+      if (h.magic != Protocol::MAGIC || h.count != count) return fail(batch, count, 0);
+      pos = sizeof(h);
+      uint8_t done = 0;
+      while (done < count) {
+        I2CTransfer& x = *batch[done];
+        Protocol::Result r;
+        if (pos + sizeof(r) > (size_t)length) break;
+        memcpy(&r, message + pos, sizeof(r));
+        pos += sizeof(r);
+        if (pos + r.rxCount > (size_t)length || r.rxCount > x.rxLength) break;
+        if (r.rxCount) memcpy(x.rxData, message + pos, r.rxCount);
+        pos += r.rxCount;
+        x.rxCount = r.rxCount;
+        done++;
+        complete(x, r.status);
+      }
+      return fail(batch, count, done);
+    }
+
+  protected:
+    /**
+     * @brief Add a transfer to the batch, flushing a full batch first
+     */
+    bool queue(I2CTransfer& xfer) {
+      xfer.rxCount = 0;
+      if (batchBytes(xfer) > Protocol::MAX_MESSAGE) return false;
+      if (m_count >= Protocol::MAX_OPS || m_bytes + batchBytes(xfer) > Protocol::MAX_MESSAGE) {
+        flush();
+      }
+      if (!m_count) m_bytes = sizeof(Protocol::Header);
+      m_batch[m_count++] = &xfer;
+      m_bytes += batchBytes(xfer);
+      return true;
+    }
+
+    /**
+     * @brief Get the largest message space a transfer needs in the request 
+     *        or the response
+     */
+    static size_t batchBytes(const I2CTransfer& xfer) {
+      size_t request = sizeof(Protocol::Op) + xfer.txLength;
+      size_t response = sizeof(Protocol::Result) + xfer.rxLength;
+      return request > response ? request : response;
+    }
+
+    /**
+     * @brief Move the queued transfers into a batch and clear the queue
+     * 
+     * @return The number of transfers moved
+     */
+    uint8_t take(I2CTransfer** batch) {
+      uint8_t count = m_count;
+      memcpy(batch, m_batch, count * sizeof(I2CTransfer*));
+      m_count = 0;
+      m_bytes = 0;
+      return count;
+    }
+
+    /**
+     * @brief Complete the transfers of a batch from an index on with 
+     *        OTHER_ERROR
+     * 
+     * @return bool True if no transfer failed
+     */
+    bool fail(I2CTransfer** batch, uint8_t count, uint8_t from) {
+      for (uint8_t i = from; i < count; i++) complete(*batch[i], OTHER_ERROR);
+      return from >= count;
+    }
+
+    int m_fd;                                   //!< The broker socket
+    uint8_t m_priority;                         //!< Batch priority
+    uint8_t m_count;                            //!< Queued transfers
+    size_t m_bytes;                             //!< Message space used by the batch
+    I2CTransfer* m_batch[Protocol::MAX_OPS];    //!< Queued transfers
+};
+#endif
+#endif /* I2C_BROKER_CLIENT_LIB_H_ */
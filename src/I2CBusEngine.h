@@ -0,0 +1,599 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CBusEngine.h 
+//!  @brief I2CBusEngine class definition
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_BUS_ENGINE_LIB_H_
+#define I2C_BUS_ENGINE_LIB_H_
+
+#include "I2CDevice.h"
+#include "I2CCostModel.h"
+#include "I2CClock.h"
+#include "I2CLatencyProfiler.h"
+
+/**
+ * @brief Bus engine statistics
+ */
+struct I2CEngineStats {
+  uint32_t submitted;       //!< Transfers submitted
+  uint32_t executed;        //!< Transfers executed on the bus
+  uint32_t readsMerged;     //!< Reads served by an identical pending read
+  uint32_t writesCollapsed; //!< Writes superseded by a later write
+  uint32_t savedUs;         //!< Predicted bus time saved by merging, in µs
+  uint32_t throttled;       //!< Polls with work pending but no device allowed to send
+  uint32_t overruns;        //!< service() calls that took longer than their budget
+  uint32_t deferred;        //!< Transfers left queued by service() for a later call
+  uint32_t arbitrationLost; //!< Executions that lost arbitration
+  uint32_t retries;         //!< Transfers re-queued after a lost arbitration
+};
+
+/**
+ * @brief Queues transfers from several modules and executes them on the 
+ *        bus from the main loop.  Submitted transfers complete later 
+ *        through their onComplete callback and status.
+ * 
+ *        A read that is identical to a pending read (same device, flags, 
+ *        written bytes and read length) is not executed again: the result 
+ *        of the pending read is copied to all waiters.  A write submitted 
+ *        with a collapse key replaces a pending write to the same register 
+ *        (last writer wins); the superseded transfer completes with the 
+ *        status of the write that replaced it.  Neither happens across 
+ *        another queued transfer to the same device, so ordering per device 
+ *        is kept.
+ * 
+ *        Devices (by address) share the bus by deficit round robin over 
+ *        bytes on the wire: each round, a device with queued work may send 
+ *        up to its quantum, so bus time is split in proportion to the 
+ *        quanta set with setShare().  A device can also be capped to a 
+ *        byte rate with a token bucket; while it is out of tokens, other 
+ *        devices use the bus.
+ * 
+ *        A transfer that loses arbitration to another controller is 
+ *        re-queued and retried after a random backoff that doubles with 
+ *        every attempt, keeping its place in its device's order.  After 
+ *        the maximum number of retries it completes with ARBITRATION_LOST.
+ * 
+ * @tparam Bus The bus type, TwoWire or a class derived from I2CBackend
+ * @tparam Capacity The maximum number of queued transfers, including waiters
+ * @tparam MaxFlows The maximum number of devices scheduled separately; 
+ *                  further devices share the last entry
+ * @tparam Clock The time source for rate limits, e.g. I2CArduinoClock
+ * @tparam Model The cost model predicting transfer times
+ */
+template <class Bus = TwoWire, uint8_t Capacity = 16, uint8_t MaxFlows = 8,
+          class Clock = I2CDefaultClock, class Model = I2CCostModel<> >
+class I2CBusEngine : public I2CBusResult {
+  public:
+    static constexpr uint16_t DEFAULT_QUANTUM = 32; //!< Bytes per round for devices without a share
+    static constexpr uint16_t DEFAULT_BACKOFF_US = 100; //!< Initial arbitration backoff window
+    static constexpr uint8_t DEFAULT_RETRIES = 8; //!< Retries after lost arbitration
+
+    /**
+     * @brief Construct a bus engine
+     * 
+     * @param bus The TwoWire object or backend
+     * @param busClock The bus clock in Hz, for the timing model
+     * @param clock The time source
+     */
+    I2CBusEngine(Bus& bus, uint32_t busClock = 100000, const Clock& clock = Clock()): 
+      m_bus(bus), m_model(busClock), m_clock(clock), m_observer(nullptr), m_count(0), m_flowCount(0), 
+      m_current(0), m_fresh(true), m_backoffUs(DEFAULT_BACKOFF_US), 
+      m_maxRetries(DEFAULT_RETRIES), m_seed(0x2545F491UL) {
+      memset(&m_stats, 0, sizeof(m_stats));
+    };
+
+    /**
+     * @brief Set the bus share of a device
+     * 
+     * @param address The device address
+     * @param quantum The bytes on the wire the device may send per round, 
+     *                relative to the other devices (at least 1)
+     * @param rate The maximum byte rate in bytes per second, 0 for no limit
+     * @param burst The token bucket size in bytes, when rate is not 0
+     * @return bool True if set, false if there are no free entries
+     */
+    bool setShare(uint16_t address, uint16_t quantum, uint32_t rate = 0, uint16_t burst = 64) {
+      uint8_t f = flow(address);
+      if (m_flows[f].address != address) return false;
+      Flow& fl = m_flows[f];
+      fl.quantum = quantum ? quantum : 1;
+      fl.rate = rate;
+      fl.burst = burst;
+      fl.tokens = (uint64_t)burst * 1000000UL;
+      fl.lastUs = m_clock.nowUs();
+      return true;
+    }
+
+    /**
+     * @brief Queue a transfer.  The transfer and its buffers must stay valid 
+     *        until it completes.
+     * 
+     * @param xfer The transfer
+     * @param collapseKey For writes that may be superseded, the number of 
+     *                    leading bytes identifying the register (e.g. 
+     *                    Device::RegisterTraits::BYTES), 0 otherwise
+     * @return bool True if queued, false if the queue is full
+     */
+    bool submit(I2CTransfer& xfer, uint8_t collapseKey = 0) {
+      if (m_count >= Capacity) return false;
+      m_stats.submitted++;
+      Slot& s = m_slots[m_count++];
+      s.xfer = &xfer;
+      s.leader = nullptr;
+      s.flow = flow(xfer.address);
+      s.retries = 0;
+      s.notBefore = 0;
+      s.collapseKey = (xfer.rxLength == 0 && collapseKey <= xfer.txLength) ? collapseKey : 0;
+      if (xfer.rxLength > 0) {
+        I2CTransfer* pending = findRead(xfer);
+        if (pending) {
+          s.leader = pending;
+          m_stats.readsMerged++;
+          m_stats.savedUs += costNs(xfer) / 1000;
+        }
+      } else if (s.collapseKey) {
+        uint8_t i = findWrite(xfer, s.collapseKey);
+        if (i < m_count - 1) {
+          I2CTransfer* old = m_slots[i].xfer;
+          m_slots[i].xfer = &xfer;
+          s.xfer = old;
+          for (uint8_t j = 0; j < m_count; j++) {
+            if (m_slots[j].leader == old) m_slots[j].leader = &xfer;
+          }
+          s.leader = &xfer;
+          m_stats.writesCollapsed++;
+          m_stats.savedUs += costNs(*old) / 1000;
+        }
+      }
+      return true;
+    }
+
+    /**
+     * @brief Execute the next queued transfer and complete it and its 
+     *        waiters
+     * 
+     * @return bool True if a transfer was executed
+     */
+    bool poll() {
+      uint8_t i = next();
+      if (i >= m_count) return false;
+      charge(i);
+      execute(i);
+      return true;
+    }
+
+    /**
+     * @brief Execute queued transfers while their predicted bus time fits 
+     *        in the remaining time budget.  Work that does not fit stays 
+     *        queued for the next call.  A transfer predicted to take longer 
+     *        than the whole budget is executed alone as the first transfer 
+     *        of a call, so it cannot be deferred forever.
+     * 
+     * @param budgetUs The time budget in microseconds
+     * @return size_t The number of transfers executed
+     */
+    size_t service(uint32_t budgetUs) {
+      uint32_t start = m_clock.nowUs();
+      size_t executed = 0;
+      for (;;) {
+        uint8_t i = next();
+        if (i >= m_count) break;
+        uint32_t elapsed = m_clock.nowUs() - start;
+        uint32_t cost = (costNs(*m_slots[i].xfer) + 999) / 1000;
+        if (elapsed + cost > budgetUs && (executed || cost <= budgetUs)) {
+          m_stats.deferred += queued();
+          break;
+        }
+        charge(i);
+        execute(i);
+        executed++;
+      }
+      if (m_clock.nowUs() - start > budgetUs) m_stats.overruns++;
+      return executed;
+    }
+
+    /**
+     * @brief Execute queued transfers until the queue is empty or the 
+     *        remaining devices are rate limited, including transfers 
+     *        submitted by completion callbacks
+     * 
+     * @return size_t The number of transfers executed
+     */
+    size_t run() {
+      size_t executed = 0;
+      while (poll()) executed++;
+      return executed;
+    }
+
+    /**
+     * @brief Get the number of queued transfers, including waiters
+     * 
+     * @return uint8_t 
+     */
+    inline uint8_t pending() const { return m_count; }
+
+    /**
+     * @brief Get the number of transfers that still need the bus, not 
+     *        counting waiters
+     * 
+     * @return uint8_t 
+     */
+    uint8_t queued() const {
+      uint8_t n = 0;
+      for (uint8_t i = 0; i < m_count; i++) {
+        if (!m_slots[i].leader) n++;
+      }
+      return n;
+    }
+
+    /**
+     * @brief Set the bus clock used by the timing model
+     * 
+     * @param clock The bus clock in Hz
+     */
+    inline void setClock(uint32_t clock) { m_model.setClock(clock); }
+
+    /**
+     * @brief Set the retry policy for transfers losing arbitration
+     * 
+     * @param backoffUs The initial backoff window in microseconds, doubled 
+     *                  with every retry
+     * @param maxRetries The maximum number of retries
+     */
+    inline void setBackoff(uint16_t backoffUs, uint8_t maxRetries) {
+      m_backoffUs = backoffUs ? backoffUs : 1;
+      m_maxRetries = maxRetries;
+    }
+
+    /**
+     * @brief Seed the random backoff, e.g. from a unique ID, so that 
+     *        controllers sharing a bus back off differently
+     * 
+     * @param seed The seed (not 0)
+     */
+    inline void setSeed(uint32_t seed) { m_seed = seed ? seed : 1; }
+
+    /**
+     * @brief Get the cost model, e.g. to set a stretch source
+     * 
+     * @return Model& 
+     */
+    inline Model& getCostModel() { return m_model; }
+
+    /**
+     * @brief Set an observer receiving the predicted and measured time of 
+     *        every executed transfer, e.g. an I2CLatencyProfiler
+     * 
+     * @param observer The observer, or nullptr
+     */
+    inline void setObserver(I2CTransferObserver* observer) { m_observer = observer; }
+
+    /**
+     * @brief Get the engine statistics
+     * 
+     * @return const I2CEngineStats& 
+     */
+    inline const I2CEngineStats& getStats() const { return m_stats; }
+
+  protected:
+    /**
+     * @brief A queued transfer
+     */
+    struct Slot {
+      I2CTransfer* xfer;   //!< The transfer
+      I2CTransfer* leader; //!< The transfer whose result this one takes, or nullptr
+      uint8_t collapseKey; //!< Register bytes for collapsible writes, 0 otherwise
+      uint8_t flow;        //!< The scheduling entry of the device
+      uint8_t retries;     //!< Retries after lost arbitration
+      uint32_t notBefore;  //!< Backoff end time in µs, when retries is not 0
+    };
+
+    /**
+     * @brief Scheduling state of a device
+     */
+    struct Flow {
+      uint16_t address;    //!< The device address
+      uint16_t quantum;    //!< Bytes added to the deficit per round
+      int32_t deficit;     //!< Bytes the device may still send this round
+      uint32_t rate;       //!< Byte rate limit, 0 for none
+      uint16_t burst;      //!< Token bucket size in bytes
+      uint64_t tokens;     //!< Available tokens, in byte-microseconds
+      uint32_t lastUs;     //!< Time of the last refill
+    };
+
+    /**
+     * @brief Get the scheduling entry of a device, adding it if needed
+     */
+    uint8_t flow(uint16_t address) {
+      for (uint8_t i = 0; i < m_flowCount; i++) {
+        if (m_flows[i].address == address) return i;
+      }
+      if (m_flowCount >= MaxFlows) return MaxFlows - 1;
+      Flow& f = m_flows[m_flowCount];
+      f.address = address;
+      f.quantum = DEFAULT_QUANTUM;
+      f.deficit = 0;
+      f.rate = 0;
+      f.burst = 0;
+      f.tokens = 0;
+      f.lastUs = 0;
+      return m_flowCount++;
+    }
+
+    /**
+     * @brief Get the number of bytes a transfer puts on the wire, including 
+     *        address bytes
+     */
+    static uint32_t wireBytes(const I2CTransfer& xfer) {
+      uint8_t addressBytes = (xfer.flags & I2CTransfer::TEN_BIT) ? 2 : 1;
+      uint8_t phases = (xfer.txLength && xfer.rxLength) ? 2 : 1;
+      return addressBytes * phases + xfer.txLength + xfer.rxLength;
+    }
+
+    /**
+     * @brief Check the token bucket of a device, refilling it first
+     */
+    bool allowed(Flow& f, uint32_t bytes, uint32_t now) {
+      if (!f.rate) return true;
+      uint64_t full = (uint64_t)f.burst * 1000000UL;
+      uint32_t elapsed = now - f.lastUs;
+      f.lastUs = now;
+      if (elapsed >= (full - f.tokens) / f.rate) f.tokens = full;
+      else f.tokens += (uint64_t)elapsed * f.rate;
+      uint64_t needed = (uint64_t)bytes * 1000000UL;
+      return f.tokens >= (needed < full ? needed : full);
+    }
+
+    /**
+     * @brief Take tokens for a transfer about to be executed
+     */
+    static void consume(Flow& f, uint32_t bytes) {
+      if (!f.rate) return;
+      uint64_t needed = (uint64_t)bytes * 1000000UL;
+      f.tokens = f.tokens > needed ? f.tokens - needed : 0;
+    }
+
+    /**
+     * @brief Get the predicted bus time of a transfer
+     */
+    inline uint32_t costNs(const I2CTransfer& xfer) const {
+      return m_model.transferNs(xfer);
+    }
+
+    /**
+     * @brief Get the first queued transfer of a device, m_count if none
+     */
+    uint8_t head(uint8_t f) const {
+      uint8_t i = 0;
+      while (i < m_count && (m_slots[i].leader || m_slots[i].flow != f)) i++;
+      return i;
+    }
+
+    /**
+     * @brief Pick the next transfer by deficit round robin, skipping devices 
+     *        out of tokens.  The transfer is charged with charge() when it 
+     *        is executed.
+     * 
+     * @return The slot index, m_count if nothing may be sent now
+     */
+    uint8_t next() {
+      if (!m_count || !m_flowCount) return m_count;
+      uint32_t now = m_clock.nowUs();
+      uint8_t blocked = 0;
+      while (blocked < m_flowCount) {
+        if (m_current >= m_flowCount) m_current = 0;
+        Flow& f = m_flows[m_current];
+        uint8_t i = head(m_current);
+        if (i >= m_count) {
+          f.deficit = 0;
+          blocked++;
+          advance();
+          continue;
+        }
+        uint32_t bytes = wireBytes(*m_slots[i].xfer);
+        bool backoff = m_slots[i].retries && (int32_t)(now - m_slots[i].notBefore) < 0;
+        if (backoff || !allowed(f, bytes, now)) {
+          blocked++;
+          advance();
+          continue;
+        }
+        if (m_fresh) {
+          f.deficit += f.quantum;
+          m_fresh = false;
+        }
+        if (f.deficit >= (int32_t)bytes) return i;
+        blocked = 0;
+        advance();
+      }
+      m_stats.throttled++;
+      return m_count;
+    }
+
+    /**
+     * @brief Charge a transfer picked by next() to the deficit and tokens 
+     *        of its device
+     */
+    void charge(uint8_t index) {
+      Flow& f = m_flows[m_slots[index].flow];
+      uint32_t bytes = wireBytes(*m_slots[index].xfer);
+      f.deficit -= bytes;
+      consume(f, bytes);
+    }
+
+    /**
+     * @brief Get a random backoff for a retry, from a window doubling with 
+     *        every retry
+     */
+    uint32_t backoffUs(uint8_t retries) {
+      m_seed ^= m_seed << 13;
+      m_seed ^= m_seed >> 17;
+      m_seed ^= m_seed << 5;
+      uint32_t window = (uint32_t)m_backoffUs << (retries < 12 ? retries - 1 : 11);
+      return 1 + m_seed % window;
+    }
+
+    /**
+     * @brief Move the round robin to the next device
+     */
+    inline void advance() {
+      m_current++;
+      m_fresh = true;
+    }
+
+    /**
+     * @brief Find a pending read with the same request, not followed by 
+     *        another transfer to the device
+     */
+    I2CTransfer* findRead(const I2CTransfer& xfer) const {
+      for (uint8_t i = m_count - 1; i-- > 0;) {
+        const Slot& s = m_slots[i];
+        if (s.xfer->address != xfer.address || s.leader) continue;
+        if (s.xfer->flags == xfer.flags && s.xfer->rxLength == xfer.rxLength &&
+            s.xfer->txLength == xfer.txLength && 
+            (xfer.txLength == 0 || memcmp(s.xfer->txData, xfer.txData, xfer.txLength) == 0)) {
+          return s.xfer;
+        }
+        return nullptr;
+      }
+      return nullptr;
+    }
+
+    /**
+     * @brief Find a pending collapsible write to the same register, not 
+     *        followed by another transfer to the device
+     * 
+     * @return The slot index, or m_count - 1 if none
+     */
+    uint8_t findWrite(const I2CTransfer& xfer, uint8_t key) const {
+      for (uint8_t i = m_count - 1; i-- > 0;) {
+        const Slot& s = m_slots[i];
+        if (s.xfer->address != xfer.address || s.leader) continue;
+        if (s.collapseKey == key && s.xfer->flags == xfer.flags && 
+            s.xfer->txLength == xfer.txLength && 
+            memcmp(s.xfer->txData, xfer.txData, key) == 0) {
+          return i;
+        }
+        break;
+      }
+      return m_count - 1;
+    }
+
+    /**
+     * @brief Execute a queued transfer, remove it and its waiters from the 
+     *        queue and call the completion callbacks
+     */
+    void execute(uint8_t index) {
+      I2CTransfer* leader = m_slots[index].xfer;
+      uint32_t start = m_clock.nowUs();
+      i2cTransfer(m_bus, *leader);
+      if (m_observer) {
+        uint32_t actualNs = (m_clock.nowUs() - start) * 1000UL;
+        m_observer->onTransfer(*leader, m_model.baseNs(*leader), actualNs);
+      }
+      m_stats.executed++;
+      if (leader->status == ARBITRATION_LOST) {
+        m_stats.arbitrationLost++;
+        Slot& s = m_slots[index];
+        if (s.retries < m_maxRetries) {
+          s.retries++;
+          s.notBefore = m_clock.nowUs() + backoffUs(s.retries);
+          m_stats.retries++;
+          return;
+        }
+      }
+      I2CTransfer* done[Capacity];
+      uint8_t doneCount = 0;
+      uint8_t kept = 0;
+      for (uint8_t i = 0; i < m_count; i++) {
+        Slot& s = m_slots[i];
+        if (i == index || s.leader == leader) {
+          done[doneCount++] = s.xfer;
+        } else {
+          m_slots[kept++] = s;
+        }
+      }
+      m_count = kept;
+      for (uint8_t i = 0; i < doneCount; i++) {
+        I2CTransfer* x = done[i];
+        if (x != leader) {
+          x->status = leader->status;
+          if (x->rxLength) {
+            x->rxCount = leader->rxCount;
+            memcpy(x->rxData, leader->rxData, leader->rxCount);
+          }
+        }
+        if (x->onComplete) x->onComplete(*x);
+      }
+    }
+
+    Bus& m_bus;                 //!< The bus
+    Model m_model;              //!< The cost model
+    Clock m_clock;              //!< The time source
+    I2CTransferObserver* m_observer; //!< Receives transfer timings, or nullptr
+    uint8_t m_count;            //!< The number of queued transfers
+    uint8_t m_flowCount;        //!< The number of scheduling entries in use
+    uint8_t m_current;          //!< The device whose round it is
+    bool m_fresh;               //!< The current round has not added its quantum yet
+    uint16_t m_backoffUs;       //!< Initial arbitration backoff window
+    uint8_t m_maxRetries;       //!< Retries after lost arbitration
+    uint32_t m_seed;            //!< Random state for the backoff
+    Slot m_slots[Capacity];     //!< The queued transfers, in submission order
+    Flow m_flows[MaxFlows];     //!< The scheduling entries
+    I2CEngineStats m_stats;     //!< Statistics
+};
+#endif /* I2C_BUS_ENGINE_LIB_H_ */
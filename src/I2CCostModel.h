@@ -0,0 +1,235 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CCostModel.h 
+//!  @brief I2CCostModel class definition
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_COST_MODEL_LIB_H_
+#define I2C_COST_MODEL_LIB_H_
+
+#include "I2CBackend.h"
+#include "I2CTiming.h"
+
+/**
+ * @brief Stretch correction that adds nothing, the default for I2CCostModel
+ */
+struct I2CNoStretch {
+  inline uint32_t stretchNs(uint16_t address) const { (void)address; return 0; }
+};
+
+/**
+ * @brief Predicts the bus time of transactions before they are issued, for 
+ *        schedulers, time budgets and capacity planning.
+ * 
+ *        Predictions use the I2CTiming model for the bus clock and the 
+ *        address width, and handle high-speed transfers.  If a stretch 
+ *        source is set, its per-device average clock stretching is added.
+ * 
+ * @tparam Stretch A stretch source with stretchNs(address), returning the 
+ *                 average extra time of a transaction with a device
+ */
+template <class Stretch = I2CNoStretch>
+class I2CCostModel {
+  public:
+    /**
+     * @brief Construct a cost model
+     * 
+     * @param clock The SCL frequency in Hz
+     * @param hsClock The high-speed SCL frequency in Hz
+     * @param stretch The stretch source, or nullptr for no correction
+     */
+    I2CCostModel(uint32_t clock = 100000, uint32_t hsClock = 3400000, 
+                 const Stretch* stretch = nullptr):
+      m_clock(clock), m_hsClock(hsClock), m_stretch(stretch){};
+
+    /**
+     * @brief Set the SCL frequency
+     * 
+     * @param clock The SCL frequency in Hz
+     */
+    inline void setClock(uint32_t clock) { m_clock = clock; }
+
+    /**
+     * @brief Get the SCL frequency
+     * 
+     * @return uint32_t The SCL frequency in Hz
+     */
+    inline uint32_t getClock() const { return m_clock; }
+
+    /**
+     * @brief Set the high-speed SCL frequency
+     * 
+     * @param hsClock The high-speed SCL frequency in Hz
+     */
+    inline void setHighSpeedClock(uint32_t hsClock) { m_hsClock = hsClock; }
+
+    /**
+     * @brief Set the stretch source
+     * 
+     * @param stretch The stretch source, or nullptr for no correction
+     */
+    inline void setStretch(const Stretch* stretch) { m_stretch = stretch; }
+
+    /**
+     * @brief Predict the bus time of a transfer
+     * 
+     * @param xfer The transfer
+     * @return The duration in nanoseconds
+     */
+    uint32_t transferNs(const I2CTransfer& xfer) const {
+      return wireNs(xfer.address, xfer.flags, xfer.txLength, xfer.rxLength);
+    }
+
+    /**
+     * @brief Predict the bus time of a transfer without stretch correction, 
+     *        e.g. to measure stretching against
+     * 
+     * @param xfer The transfer
+     * @return The duration in nanoseconds
+     */
+    uint32_t baseNs(const I2CTransfer& xfer) const {
+      return wireNs(xfer.address, xfer.flags, xfer.txLength, xfer.rxLength, false);
+    }
+
+    /**
+     * @brief Predict the bus time of a plain write to a device
+     * 
+     * @param dev The device
+     * @param length The number of bytes written
+     * @return The duration in nanoseconds
+     */
+    template <class Device>
+    uint32_t writeNs(const Device& dev, size_t length) const {
+      return deviceNs(dev, length, 0);
+    }
+
+    /**
+     * @brief Predict the bus time of a plain read from a device
+     * 
+     * @param dev The device
+     * @param length The number of bytes read
+     * @return The duration in nanoseconds
+     */
+    template <class Device>
+    uint32_t readNs(const Device& dev, size_t length) const {
+      return deviceNs(dev, 0, length);
+    }
+
+    /**
+     * @brief Predict the bus time of a combined transaction: a write, a 
+     *        repeated start and a read
+     * 
+     * @param dev The device
+     * @param txLength The number of bytes written
+     * @param rxLength The number of bytes read
+     * @return The duration in nanoseconds
+     */
+    template <class Device>
+    uint32_t combinedNs(const Device& dev, size_t txLength, size_t rxLength) const {
+      return deviceNs(dev, txLength, rxLength);
+    }
+
+    /**
+     * @brief Predict the bus time of writeRegisters(), a burst write to 
+     *        consecutive registers
+     * 
+     * @param dev The device
+     * @param length The number of data bytes
+     * @return The duration in nanoseconds
+     */
+    template <class Device>
+    uint32_t writeRegistersNs(const Device& dev, size_t length) const {
+      return deviceNs(dev, Device::RegisterTraits::BYTES + length, 0);
+    }
+
+    /**
+     * @brief Predict the bus time of readRegisters(), a burst read from 
+     *        consecutive registers
+     * 
+     * @param dev The device
+     * @param length The number of data bytes
+     * @return The duration in nanoseconds
+     */
+    template <class Device>
+    uint32_t readRegistersNs(const Device& dev, size_t length) const {
+      return deviceNs(dev, Device::RegisterTraits::BYTES, length);
+    }
+
+  protected:
+    template <class Device>
+    uint32_t deviceNs(const Device& dev, size_t txLength, size_t rxLength) const {
+      return wireNs(dev.getAddress(), Device::AddressTraits::FLAGS, txLength, rxLength);
+    }
+
+    uint32_t wireNs(uint16_t address, uint8_t flags, size_t txLength, size_t rxLength,
+                    bool stretch = true) const {
+      uint8_t addressBytes = (flags & I2CTransfer::TEN_BIT) ? 2 : 1;
+      uint32_t ns;
+      if (flags & I2CTransfer::HIGH_SPEED) {
+        ns = I2CTiming::highSpeedNs(m_clock, m_hsClock, true, addressBytes, 
+                                    txLength, rxLength, !(flags & I2CTransfer::NO_STOP));
+      } else {
+        ns = I2CTiming::transferNs(m_clock, addressBytes, txLength, rxLength);
+      }
+      return (stretch && m_stretch) ? ns + m_stretch->stretchNs(address) : ns;
+    }
+
+    uint32_t m_clock;          //!< The SCL frequency in Hz
+    uint32_t m_hsClock;        //!< The high-speed SCL frequency in Hz
+    const Stretch* m_stretch;  //!< The stretch source, or nullptr
+};
+#endif /* I2C_COST_MODEL_LIB_H_ */
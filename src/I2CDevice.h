@@ -63,55 +63,133 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include "I2CBackend.h"
+#include "I2CAddress.h"
+#include "I2CRegister.h"
+
+/**
+ * @brief Execute a complete transfer on a TwoWire bus
+ * 
+ * @param wire The TwoWire object
+ * @param xfer The transfer to execute
+ * @return The I2C Bus result, DATA_TOO_LONG if more than the 255 bytes 
+ *         requestFrom() can take are to be read
+ */
+inline uint8_t i2cTransfer(TwoWire& wire, I2CTransfer& xfer) {
+  uint8_t sendStop = (xfer.flags & I2CTransfer::NO_STOP) ? 0 : 1;
+  bool tenBit = (xfer.flags & I2CTransfer::TEN_BIT) != 0;
+  uint8_t address = tenBit ? I2CAddress10::prefix(xfer.address) : (uint8_t)xfer.address;
+  xfer.rxCount = 0;
+  if (xfer.rxLength > 255) return xfer.status = I2CBusResult::DATA_TOO_LONG;
+  if (xfer.txLength > 0 || xfer.rxLength == 0 || tenBit) {
+    wire.beginTransmission(address);
+    if (tenBit) wire.write(I2CAddress10::low(xfer.address));
+    if (xfer.txLength) wire.write(xfer.txData, xfer.txLength);
+    xfer.status = wire.endTransmission(xfer.rxLength ? 0 : sendStop);
+    if (xfer.status != I2CBusResult::SUCCESS || xfer.rxLength == 0) {
+      return xfer.status;
+    }
+  }
+  uint8_t received = wire.requestFrom(address, (uint8_t)xfer.rxLength, sendStop);
+  while (xfer.rxCount < received && wire.available()) {
+    xfer.rxData[xfer.rxCount++] = (uint8_t)wire.read();
+  }
+  xfer.status = (xfer.rxCount == xfer.rxLength) ? 
+                I2CBusResult::SUCCESS : I2CBusResult::NACK_ON_ADDRESS;
+  return xfer.status;
+}
+
+/**
+ * @brief Execute a complete transfer on an I2CBackend
+ * 
+ * @param backend The backend
+ * @param xfer The transfer to execute
+ * @return The I2C Bus result
+ */
+inline uint8_t i2cTransfer(I2CBackend& backend, I2CTransfer& xfer) {
+  return backend.transfer(xfer);
+}
+
+/**
+ * @brief Start a transfer on a TwoWire bus.  TwoWire is blocking, so the 
+ *        transfer is complete when this returns.
+ * 
+ * @param wire The TwoWire object
+ * @param xfer The transfer to execute
+ * @return bool Always true
+ */
+inline bool i2cStartTransfer(TwoWire& wire, I2CTransfer& xfer) {
+  i2cTransfer(wire, xfer);
+  if (xfer.onComplete) xfer.onComplete(xfer);
+  return true;
+}
+
+/**
+ * @brief Start a transfer on an I2CBackend without waiting for completion
+ * 
+ * @param backend The backend
+ * @param xfer The transfer, must stay valid until completion.
+ * @return bool True if the transfer was started
+ */
+inline bool i2cStartTransfer(I2CBackend& backend, I2CTransfer& xfer) {
+  return backend.startTransfer(xfer);
+}
 
 /**
  * @brief Class wrapping the Arduino Wire library that also stores the 
  *        I2C device address to make transmission simpler and allow for 
  *        individual devices to be managed in a more object-oriented style.
  * 
+ * @tparam Bus The bus type, TwoWire or a class derived from I2CBackend
+ * @tparam Address The address width traits, I2CAddress7 or I2CAddress10
+ * @tparam Register The register address traits, I2CRegister8, 
+ *         I2CRegister16, ...
  */
-class I2CDevice {
+template <class Bus = TwoWire, class Address = I2CAddress7, 
+          class Register = I2CRegister8>
+class BasicI2CDevice : public I2CBusResult {
   public:
-    //Bus result constants
-    /**
-     * @brief I2C Bus reutrn value on successful transmission.
-     */
-    static constexpr uint8_t SUCCESS = 0x0;
-    /**
-     * @brief I2C Bus return value on data overrun (data longer than expected)
-     */
-    static constexpr uint8_t DATA_TOO_LONG = 0x1;
-    /**
-     * @brief I2C Bus return value on device NACK on address transmission
-     */
-    static constexpr uint8_t NACK_ON_ADDRESS = 0x2;
-    /**
-     * @brief I2C Bus return value on device NACK on data transmission
-     */
-    static constexpr uint8_t NACK_ON_DATA = 0x3;
+    typedef Bus BusType; //!< The bus type managed by this class
+    typedef Address AddressTraits; //!< The address width traits
+    typedef typename Address::Type AddressType; //!< The address storage type
+    typedef Register RegisterTraits; //!< The register address traits
+    typedef typename Register::Type RegisterType; //!< The register address type
+
     /**
-     * @brief I2C Bus return value for all other errors
+     * @brief The most data bytes writeRegisters() can send in one 
+     *        transaction: the 32-byte Wire buffer minus the second address 
+     *        byte of 10-bit addresses and the register address bytes
      */
-    static constexpr uint8_t OTHER_ERROR = 0x4;
+    static constexpr uint8_t MAX_WRITE = 32 - (Address::BYTES - 1) - Register::BYTES;
 
     /**
      * @brief Standard I2CDevice constructor
      * 
-     * @param tw A reference to the TwoWire object that will manage hardware 
-     *           transmission.  Defaults to "Wire".
-     * @param address The 7-bit I2C device address, defaults to 0x0
+     * @param tw A reference to the TwoWire object (or backend) that will 
+     *           manage hardware transmission.  Defaults to "Wire".
+     * @param address The 7-bit (or 10-bit) I2C device address, defaults to 0x0
      */
-    I2CDevice(TwoWire& tw = Wire, uint8_t address = 0x0):
-      wire(tw), dev_address(address){};
+    constexpr BasicI2CDevice(Bus& tw = Wire, AddressType address = 0x0):
+      wire(tw), dev_address(address), m_status(SUCCESS){};
 
     /**
      * @brief Get the I2C device address
      * 
-     * @return The 7-bit I2C device address 
+     * @return The 7-bit (or 10-bit) I2C device address 
      */
-    inline uint8_t getAddress() const {
+    inline AddressType getAddress() const {
       return dev_address;
     }
+
+    /**
+     * @brief Change the I2C device address, after the device itself has 
+     *        been reprogrammed to respond to it (see I2CAddressAssigner).
+     * 
+     * @param address The new 7-bit (or 10-bit) I2C device address
+     */
+    inline void setAddress(AddressType address) {
+      dev_address = address;
+    }
     
     /**
      * @brief Get the I2C bus return status
@@ -128,7 +206,7 @@ class I2CDevice {
      * 
      */
     inline void beginTransmission() {
-      wire.beginTransmission(getAddress());
+      Address::begin(wire, getAddress());
     }
 
     /**
@@ -208,13 +286,110 @@ class I2CDevice {
     }
 
     /**
-     * @brief Call to requiest bytes from the I2C device
+     * @brief Call to requiest bytes from the I2C device.  For 10-bit 
+     *        devices the full address phase is repeated first, use 
+     *        transfer() for write-then-read transactions.
      * 
      * @param noBytes The number of bytes to request
      * @return The number of bytes returned and stored in the buffer 
      */
     inline uint8_t requestBytes(uint8_t noBytes) {
-      return wire.requestFrom(getAddress(), noBytes);
+      return Address::request(wire, getAddress(), noBytes);
+    }
+
+    /**
+     * @brief Execute a complete write-then-read transaction.  Backends 
+     *        that support it (e.g. DMA) run the whole transaction without 
+     *        CPU involvement.
+     * 
+     * @param txData The data to write, may be nullptr if txLength is 0
+     * @param txLength The number of bytes to write
+     * @param rxData The buffer to read into, may be nullptr if rxLength is 0
+     * @param rxLength The number of bytes to read
+     * @return The I2C Bus result
+     */
+    inline uint8_t transfer(const uint8_t* txData, size_t txLength,
+                            uint8_t* rxData = nullptr, size_t rxLength = 0) {
+      I2CTransfer xfer(getAddress(), txData, txLength, rxData, rxLength);
+      xfer.flags = Address::FLAGS;
+      m_status = i2cTransfer(wire, xfer);
+      return m_status;
+    }
+
+    /**
+     * @brief Start an asynchronous transaction with this device.  The 
+     *        transfer's address is set to the device address and its 
+     *        onComplete callback is called on completion.
+     * 
+     * @param xfer The transfer, must stay valid until completion.
+     * @return bool True if the transfer was started
+     */
+    inline bool startTransfer(I2CTransfer& xfer) {
+      xfer.address = getAddress();
+      xfer.flags |= Address::FLAGS;
+      return i2cStartTransfer(wire, xfer);
+    }
+
+    /**
+     * @brief Write a block of registers starting at a register address.  
+     *        The device must auto-increment its register pointer.
+     * 
+     * @param reg The first register address
+     * @param data A pointer to the data buffer to write
+     * @param size The size of the data buffer in bytes, at most MAX_WRITE
+     * @return The I2C Bus result
+     */
+    inline uint8_t writeRegisters(RegisterType reg, const uint8_t* data, size_t size) {
+      if (size > MAX_WRITE) {
+        m_status = DATA_TOO_LONG;
+        return m_status;
+      }
+      uint8_t encoded[Register::BYTES];
+      Register::encode(reg, encoded);
+      beginTransmission();
+      write(encoded, Register::BYTES);
+      if (write(data, size) != size) {
+        m_status = DATA_TOO_LONG; // nothing is sent, the buffer is dropped
+        return m_status;
+      }
+      return endTransmission();
+    }
+
+    /**
+     * @brief Write a single register
+     * 
+     * @param reg The register address
+     * @param value The value to write
+     * @return The I2C Bus result
+     */
+    inline uint8_t writeRegister(RegisterType reg, uint8_t value) {
+      return writeRegisters(reg, &value, 1);
+    }
+
+    /**
+     * @brief Read a block of registers starting at a register address in 
+     *        one write-then-read transaction.
+     * 
+     * @param reg The first register address
+     * @param data The buffer to read into
+     * @param size The number of bytes to read
+     * @return The I2C Bus result
+     */
+    inline uint8_t readRegisters(RegisterType reg, uint8_t* data, size_t size) {
+      uint8_t encoded[Register::BYTES];
+      Register::encode(reg, encoded);
+      return transfer(encoded, Register::BYTES, data, size);
+    }
+
+    /**
+     * @brief Read a single register
+     * 
+     * @param reg The register address
+     * @param value Set to the register value
+     * @return The I2C Bus result
+     */
+    inline uint8_t readRegister(RegisterType reg, uint8_t& value) {
+      return readRegisters(reg, &value, 1);
     }
 
     /**
@@ -244,9 +419,9 @@ class I2CDevice {
     /**
      * @brief Get the TwoWire object that is managed by this class.
      * 
-     * @return TwoWire& A reference to the TwoWire object
+     * @return Bus& A reference to the TwoWire object (or backend)
      */
-    TwoWire& getWireInstance() const {
+    Bus& getWireInstance() const {
       return wire;
     }
 
@@ -256,7 +431,7 @@ class I2CDevice {
      * @return uint16_t 
      */
     uintptr_t getWireHardwareAddress() const {
-      TwoWire* ptr = &wire;
+      Bus* ptr = &wire;
       return reinterpret_cast<uintptr_t>(ptr);
     }
 
@@ -268,23 +443,32 @@ class I2CDevice {
      * @return bool True if there is an ACK on address transmission
      */
     inline bool detect() {
-      this->wire.beginTransmission(dev_address);
+      Address::begin(this->wire, dev_address);
       return (this->wire.endTransmission() == 0);
     }
 
     protected:
-      const uint8_t dev_address; //!< The 7-bit device I2C slave address
-      TwoWire& wire; //!< A reference to the TwoWire object that manages hardware transmission
+      Bus& wire; //!< A reference to the TwoWire object that manages hardware transmission
+      AddressType dev_address; //!< The 7-bit (or 10-bit) device I2C slave address
       uint8_t m_status; //!< The stored bus status (set after each transmission)
 };
 
+/**
+ * @brief I2C device on a TwoWire bus
+ */
+typedef BasicI2CDevice<TwoWire> I2CDevice;
+
 /**
  * @brief Simple class designed to be inherited by classes that have 
  *        I2C devices as one of their components.
+ * 
+ * @tparam Device The I2C device type, an instance of BasicI2CDevice
  */
-class HasI2CDevice {
+template <class Device = I2CDevice>
+class BasicHasI2CDevice {
   public:
-    HasI2CDevice(TwoWire& tw = Wire, uint8_t address = 0x0):
+    BasicHasI2CDevice(typename Device::BusType& tw = Wire, 
+                      typename Device::AddressType address = 0x0):
         bus(tw, address){};
 
     /**
@@ -320,7 +504,21 @@ class HasI2CDevice {
     inline bool detect() {
       return this->bus.detect();
     }
+
+    /**
+     * @brief Get the I2C device object managed by this class
+     * 
+     * @return Device& 
+     */
+    inline Device& getI2CDevice() {
+      return this->bus;
+    }
   protected:
-    I2CDevice bus; //!< The I2C Device object this class manages
+    Device bus; //!< The I2C Device object this class manages
 };
+
+/**
+ * @brief Base class for drivers of I2C devices on a TwoWire bus
+ */
+typedef BasicHasI2CDevice<I2CDevice> HasI2CDevice;
 #endif /* I2C_DEVICE_LIB_H_ */
@@ -0,0 +1,258 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CDeviceGroup.h 
+//!  @brief I2CDeviceGroup class definition
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_DEVICE_GROUP_LIB_H_
+#define I2C_DEVICE_GROUP_LIB_H_
+
+#include "I2CDevice.h"
+
+/**
+ * @brief A group of I2C devices on the same bus that can be written to at 
+ *        once, either with a general call (address 0) or through a 
+ *        device-specific broadcast address (e.g. the PCA9685 ALLCALL 
+ *        address).  All members see the same bus transaction, so a trigger 
+ *        command reaches them at the same time instead of one after another.
+ * 
+ * @tparam Device The I2C device type, an instance of BasicI2CDevice
+ * @tparam Capacity The maximum number of members
+ */
+template <class Device = I2CDevice, uint8_t Capacity = 8>
+class I2CDeviceGroup : public I2CBusResult {
+  public:
+    typedef typename Device::BusType BusType; //!< The bus type of the members
+
+    /**
+     * @brief The general call address
+     */
+    static constexpr uint8_t GENERAL_CALL_ADDRESS = 0x00;
+    /**
+     * @brief General call command: reset and write the programmable part 
+     *        of the slave address
+     */
+    static constexpr uint8_t GENERAL_CALL_RESET = 0x06;
+    /**
+     * @brief General call command: write the programmable part of the 
+     *        slave address
+     */
+    static constexpr uint8_t GENERAL_CALL_LATCH = 0x04;
+    /**
+     * @brief Value of getBroadcastAddress() when the group has none
+     */
+    static constexpr uint8_t NO_BROADCAST_ADDRESS = 0xFF;
+
+    /**
+     * @brief Construct an empty device group
+     * 
+     * @param broadcastAddress The 7-bit broadcast address all members 
+     *                         respond to, or NO_BROADCAST_ADDRESS to use 
+     *                         the general call address.
+     */
+    I2CDeviceGroup(uint8_t broadcastAddress = NO_BROADCAST_ADDRESS):
+      m_count(0), m_broadcast(broadcastAddress), m_status(SUCCESS){};
+
+    /**
+     * @brief Add a device to the group.  All members must share a bus.
+     * 
+     * @param device The device to add
+     * @return bool True if the device was added or already was a member
+     */
+    bool add(Device& device) {
+      if (contains(device)) return true;
+      if (m_count >= Capacity) return false;
+      if (m_count && &device.getWireInstance() != &m_devices[0]->getWireInstance()) {
+        return false;
+      }
+      m_devices[m_count++] = &device;
+      return true;
+    }
+
+    /**
+     * @brief Remove a device from the group
+     * 
+     * @param device The device to remove
+     * @return bool True if the device was a member
+     */
+    bool remove(Device& device) {
+      for (uint8_t i = 0; i < m_count; i++) {
+        if (m_devices[i] == &device) {
+          m_devices[i] = m_devices[--m_count];
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /**
+     * @brief Check if a device is a member of the group
+     * 
+     * @param device The device
+     * @return bool 
+     */
+    bool contains(const Device& device) const {
+      for (uint8_t i = 0; i < m_count; i++) {
+        if (m_devices[i] == &device) return true;
+      }
+      return false;
+    }
+
+    /**
+     * @brief Get the number of members
+     * 
+     * @return uint8_t 
+     */
+    inline uint8_t size() const { return m_count; }
+
+    /**
+     * @brief Get a member
+     * 
+     * @param index The member index, less than size()
+     * @return Device& 
+     */
+    inline Device& get(uint8_t index) const { return *m_devices[index]; }
+
+    /**
+     * @brief Get the broadcast address used by write()
+     * 
+     * @return The 7-bit broadcast address or NO_BROADCAST_ADDRESS
+     */
+    inline uint8_t getBroadcastAddress() const { return m_broadcast; }
+
+    /**
+     * @brief Set the broadcast address used by write()
+     * 
+     * @param address The 7-bit broadcast address or NO_BROADCAST_ADDRESS to
+     *                use the general call address
+     */
+    inline void setBroadcastAddress(uint8_t address) { m_broadcast = address; }
+
+    /**
+     * @brief Write data to all members in a single bus transaction, using the
+     *        broadcast address if set, the general call address otherwise.
+     * 
+     * @param data A pointer to the data buffer to write
+     * @param size The size of the data buffer in bytes
+     * @return The I2C Bus result
+     */
+    uint8_t write(const uint8_t* data, size_t size) {
+      if (m_broadcast == NO_BROADCAST_ADDRESS) return generalCall(data, size);
+      return writeTo(m_broadcast, data, size);
+    }
+
+    /**
+     * @brief Send a general call write (address 0).  The first data byte is 
+     *        the general call command.
+     * 
+     * @param data A pointer to the data buffer to write
+     * @param size The size of the data buffer in bytes
+     * @return The I2C Bus result
+     */
+    uint8_t generalCall(const uint8_t* data, size_t size) {
+      return writeTo(GENERAL_CALL_ADDRESS, data, size);
+    }
+
+    /**
+     * @brief Send the general call reset command.  Resets every device on 
+     *        the bus that supports it, not only the members.
+     * 
+     * @return The I2C Bus result
+     */
+    uint8_t generalCallReset() {
+      uint8_t command = GENERAL_CALL_RESET;
+      return generalCall(&command, 1);
+    }
+
+    /**
+     * @brief Write data to each member in turn.  Fallback for devices that 
+     *        support neither general call nor a broadcast address.
+     * 
+     * @param data A pointer to the data buffer to write
+     * @param size The size of the data buffer in bytes
+     * @return The I2C Bus result of the first failing member, or SUCCESS
+     */
+    uint8_t writeEach(const uint8_t* data, size_t size) {
+      m_status = SUCCESS;
+      for (uint8_t i = 0; i < m_count; i++) {
+        uint8_t status = m_devices[i]->transfer(data, size);
+        if (m_status == SUCCESS) m_status = status;
+      }
+      return m_status;
+    }
+
+    /**
+     * @brief Get the result of the last group write
+     * 
+     * @return The I2C Bus result
+     */
+    inline uint8_t getBusStatus() const { return m_status; }
+
+  protected:
+    uint8_t writeTo(uint8_t address, const uint8_t* data, size_t size) {
+      if (!m_count) return m_status = OTHER_ERROR;
+      I2CTransfer xfer(address, data, size);
+      m_status = i2cTransfer(m_devices[0]->getWireInstance(), xfer);
+      return m_status;
+    }
+
+    Device* m_devices[Capacity]; //!< The group members
+    uint8_t m_count;             //!< The number of members
+    uint8_t m_broadcast;         //!< The broadcast address or NO_BROADCAST_ADDRESS
+    uint8_t m_status;            //!< The result of the last group write
+};
+#endif /* I2C_DEVICE_GROUP_LIB_H_ */
@@ -0,0 +1,176 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CDmaBackend.h 
+//!  @brief I2CDmaBackend class definition
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_DMA_BACKEND_LIB_H_
+#define I2C_DMA_BACKEND_LIB_H_
+
+#include "I2CBackend.h"
+
+/**
+ * @brief Transfer statistics kept by DMA backends
+ */
+struct I2CDmaStats {
+  uint32_t transfers;   //!< Transfers handed to the DMA engine
+  uint32_t bytes;       //!< Data bytes moved by the DMA engine
+  uint32_t interrupts;  //!< Completion interrupts handled
+  uint32_t rejected;    //!< Transfers refused because the engine was busy
+};
+
+/**
+ * @brief Base class for backends that hand a whole write-then-read 
+ *        transaction to a DMA engine and are notified by a completion 
+ *        interrupt.
+ * 
+ *        Platform ports implement dmaStart() to program the peripheral 
+ *        (address, write length, read length, DMA channels) and call 
+ *        handleCompletion() from the transfer complete / error interrupt.
+ *        The CPU is only involved at the start and the end of a transaction.
+ */
+class I2CDmaBackend : public I2CBackend {
+  public:
+    I2CDmaBackend(): m_active(nullptr), m_stats(){};
+
+    /**
+     * @brief Execute a transfer, waiting for the completion interrupt.
+     * 
+     * @param xfer The transfer to execute
+     * @return The I2C Bus result
+     */
+    uint8_t transfer(I2CTransfer& xfer) override {
+      if (!startTransfer(xfer)) return xfer.status;
+      while (isBusy()) waitForCompletion();
+      return xfer.status;
+    }
+
+    /**
+     * @brief Hand a transfer to the DMA engine.  Returns immediately, the
+     *        transfer's onComplete callback is called from the completion 
+     *        interrupt.
+     * 
+     * @param xfer The transfer, must stay valid until completion.
+     * @return bool True if the transfer was started, false if the engine is
+     *         busy or rejected it (xfer.status is set to OTHER_ERROR)
+     */
+    bool startTransfer(I2CTransfer& xfer) override {
+      if (m_active) {
+        m_stats.rejected++;
+        xfer.status = OTHER_ERROR;
+        return false;
+      }
+      xfer.rxCount = 0;
+      m_active = &xfer;
+      if (!dmaStart(xfer)) {
+        m_active = nullptr;
+        xfer.status = OTHER_ERROR;
+        return false;
+      }
+      m_stats.transfers++;
+      m_stats.bytes += xfer.txLength + xfer.rxLength;
+      return true;
+    }
+
+    /**
+     * @brief Check if a DMA transfer is in progress
+     * 
+     * @return bool True if the DMA engine is busy
+     */
+    bool isBusy() const override { return m_active != nullptr; }
+
+    /**
+     * @brief Call from the transfer complete or error interrupt
+     * 
+     * @param status The I2C Bus result of the transfer
+     * @param rxCount The number of bytes received
+     */
+    void handleCompletion(uint8_t status, size_t rxCount) {
+      I2CTransfer* xfer = m_active;
+      if (!xfer) return;
+      m_active = nullptr;
+      m_stats.interrupts++;
+      xfer->rxCount = rxCount;
+      complete(*xfer, status);
+    }
+
+    /**
+     * @brief Get the DMA transfer statistics
+     * 
+     * @return const I2CDmaStats& 
+     */
+    inline const I2CDmaStats& getStats() const { return m_stats; }
+
+  protected:
+    /**
+     * @brief Program the peripheral and DMA channels for a transfer.
+     * 
+     * @param xfer The transfer to start
+     * @return bool True if the transfer was started
+     */
+    virtual bool dmaStart(I2CTransfer& xfer) = 0;
+
+    /**
+     * @brief Called while a blocking transfer waits for completion.  
+     *        Ports may sleep until the next interrupt here.
+     */
+    virtual void waitForCompletion() {}
+
+    I2CTransfer* volatile m_active; //!< The transfer owned by the DMA engine
+    I2CDmaStats m_stats;            //!< Transfer statistics
+};
+#endif /* I2C_DMA_BACKEND_LIB_H_ */
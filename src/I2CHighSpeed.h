@@ -0,0 +1,126 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CHighSpeed.h 
+//!  @brief I2CHighSpeedSession class definition
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_HIGH_SPEED_LIB_H_
+#define I2C_HIGH_SPEED_LIB_H_
+
+#include "I2CDevice.h"
+
+/**
+ * @brief A run of high-speed mode (Hs-mode, up to 3.4 MHz) transactions 
+ *        with one device.
+ * 
+ *        The first transfer sends the master code at the normal (Fast-mode)
+ *        clock and switches the bus to the high-speed clock.  Following 
+ *        transfers are joined by repeated starts and stay in high-speed 
+ *        mode.  end() (or the destructor) sends the STOP, which drops the 
+ *        bus back to the normal clock.
+ * 
+ *        The device must be on a backend derived from I2CBackend.  Backends 
+ *        without high-speed support run the transfers at the normal clock.
+ * 
+ * @tparam Device The I2C device type, an instance of BasicI2CDevice
+ */
+template <class Device>
+class I2CHighSpeedSession : public I2CBusResult {
+  public:
+    I2CHighSpeedSession(Device& device): m_device(device), m_status(SUCCESS){};
+
+    ~I2CHighSpeedSession() { end(); }
+
+    /**
+     * @brief Execute a write-then-read transaction in high-speed mode, 
+     *        keeping the bus for the next one.
+     * 
+     * @param txData The data to write, may be nullptr if txLength is 0
+     * @param txLength The number of bytes to write
+     * @param rxData The buffer to read into, may be nullptr if rxLength is 0
+     * @param rxLength The number of bytes to read
+     * @return The I2C Bus result.  On failure the bus is released.
+     */
+    uint8_t transfer(const uint8_t* txData, size_t txLength,
+                     uint8_t* rxData = nullptr, size_t rxLength = 0) {
+      I2CTransfer xfer(m_device.getAddress(), txData, txLength, rxData, rxLength);
+      xfer.flags = Device::AddressTraits::FLAGS | I2CTransfer::HIGH_SPEED | 
+                   I2CTransfer::NO_STOP;
+      m_status = i2cTransfer(m_device.getWireInstance(), xfer);
+      if (m_status != SUCCESS) end();
+      return m_status;
+    }
+
+    /**
+     * @brief Send the STOP and leave high-speed mode
+     */
+    void end() {
+      m_device.getWireInstance().releaseBus();
+    }
+
+    /**
+     * @brief Get the result of the last transfer
+     * 
+     * @return The I2C Bus result
+     */
+    inline uint8_t getBusStatus() const { return m_status; }
+
+  protected:
+    Device& m_device;  //!< The device
+    uint8_t m_status;  //!< The result of the last transfer
+};
+#endif /* I2C_HIGH_SPEED_LIB_H_ */
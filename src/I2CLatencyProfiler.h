@@ -0,0 +1,253 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CLatencyProfiler.h 
+//!  @brief I2CLatencyProfiler class definition
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_LATENCY_PROFILER_LIB_H_
+#define I2C_LATENCY_PROFILER_LIB_H_
+
+#include "I2CBackend.h"
+
+/**
+ * @brief Receives the measured time of executed transfers, e.g. from 
+ *        I2CBusEngine
+ */
+class I2CTransferObserver {
+  public:
+    virtual ~I2CTransferObserver() = default;
+
+    /**
+     * @brief Called after a transfer was executed
+     * 
+     * @param xfer The finished transfer
+     * @param predictedNs The predicted bus time without stretch correction
+     * @param actualNs The measured time
+     */
+    virtual void onTransfer(const I2CTransfer& xfer, uint32_t predictedNs, 
+                            uint32_t actualNs) = 0;
+};
+
+/**
+ * @brief Latency profile of a device: the time its transfers take beyond 
+ *        the predicted wire time (clock stretching and driver overhead)
+ */
+struct I2CLatencyProfile {
+  static constexpr uint8_t BUCKETS = 16; //!< Histogram buckets
+
+  uint16_t address;           //!< The device address
+  uint32_t count;             //!< Transfers measured
+  uint32_t totalExcessUs;     //!< Sum of the excess times in µs
+  uint32_t maxExcessUs;       //!< Largest excess time in µs
+  /**
+   * @brief Excess time histogram.  Bucket 0 counts excess times below 1 µs, 
+   *        bucket k times from 2^(k-1) to 2^k µs, the last bucket anything 
+   *        longer.
+   */
+  uint16_t histogram[BUCKETS];
+
+  /**
+   * @brief Get the mean excess time
+   * 
+   * @return The mean excess time in nanoseconds
+   */
+  inline uint32_t meanExcessNs() const {
+    return count ? (uint32_t)((uint64_t)totalExcessUs * 1000 / count) : 0;
+  }
+
+  /**
+   * @brief Get the 99th percentile excess time, as the upper bound of its 
+   *        histogram bucket
+   * 
+   * @return The 99th percentile excess time in nanoseconds
+   */
+  uint32_t p99ExcessNs() const {
+    uint32_t total = 0;
+    for (uint8_t k = 0; k < BUCKETS; k++) total += histogram[k];
+    uint32_t rank = total - total / 100;
+    uint32_t seen = 0;
+    for (uint8_t k = 0; k < BUCKETS; k++) {
+      seen += histogram[k];
+      if (seen >= rank && seen) {
+        uint32_t bound = (uint32_t)1000 << k;
+        return (k == BUCKETS - 1 || bound > maxExcessUs * 1000) ? maxExcessUs * 1000 : bound;
+      }
+    }
+    return 0;
+  }
+};
+
+/**
+ * @brief Measures the actual against the predicted time of transfers per 
+ *        device and keeps a latency profile for each.  Attach it to a bus 
+ *        engine with setObserver().  
+ * 
+ *        The profiler is also a stretch source for I2CCostModel: with 
+ *        setStretch(&profiler), predictions include the mean excess time of 
+ *        each device.
+ * 
+ * @tparam MaxDevices The maximum number of devices profiled
+ */
+template <uint8_t MaxDevices = 8>
+class I2CLatencyProfiler : public I2CTransferObserver {
+  public:
+    I2CLatencyProfiler(): m_count(0){};
+
+    void onTransfer(const I2CTransfer& xfer, uint32_t predictedNs, 
+                    uint32_t actualNs) override {
+      if (xfer.status == I2CBusResult::SUCCESS) record(xfer.address, predictedNs, actualNs);
+    }
+
+    /**
+     * @brief Record a measured transfer
+     * 
+     * @param address The device address
+     * @param predictedNs The predicted bus time
+     * @param actualNs The measured time
+     */
+    void record(uint16_t address, uint32_t predictedNs, uint32_t actualNs) {
+      I2CLatencyProfile* p = find(address);
+      if (!p) {
+        if (m_count >= MaxDevices) return;
+        p = &m_profiles[m_count++];
+        memset(p, 0, sizeof(I2CLatencyProfile));
+        p->address = address;
+      }
+      uint32_t excessUs = actualNs > predictedNs ? (actualNs - predictedNs) / 1000 : 0;
+      p->count++;
+      p->totalExcessUs += excessUs;
+      if (excessUs > p->maxExcessUs) p->maxExcessUs = excessUs;
+      uint8_t k = 0;
+      while (excessUs && k < I2CLatencyProfile::BUCKETS - 1) {
+        excessUs >>= 1;
+        k++;
+      }
+      if (p->histogram[k] == 0xFFFF) {
+        for (uint8_t i = 0; i < I2CLatencyProfile::BUCKETS; i++) p->histogram[i] >>= 1;
+      }
+      p->histogram[k]++;
+    }
+
+    /**
+     * @brief Get the mean excess time of a device, for I2CCostModel
+     * 
+     * @param address The device address
+     * @return The mean excess time in nanoseconds, 0 if not profiled
+     */
+    uint32_t stretchNs(uint16_t address) const {
+      const I2CLatencyProfile* p = getProfile(address);
+      return p ? p->meanExcessNs() : 0;
+    }
+
+    /**
+     * @brief Get the profile of a device
+     * 
+     * @param address The device address
+     * @return The profile, or nullptr if the device was not profiled
+     */
+    const I2CLatencyProfile* getProfile(uint16_t address) const {
+      for (uint8_t i = 0; i < m_count; i++) {
+        if (m_profiles[i].address == address) return &m_profiles[i];
+      }
+      return nullptr;
+    }
+
+    /**
+     * @brief Get the number of devices profiled
+     * 
+     * @return uint8_t 
+     */
+    inline uint8_t size() const { return m_count; }
+
+    /**
+     * @brief Get a profile by index
+     * 
+     * @param index The index, less than size()
+     * @return const I2CLatencyProfile& 
+     */
+    inline const I2CLatencyProfile& get(uint8_t index) const { return m_profiles[index]; }
+
+    /**
+     * @brief Get the device costing the most bus time beyond prediction
+     * 
+     * @return The profile, or nullptr if nothing was profiled
+     */
+    const I2CLatencyProfile* worst() const {
+      const I2CLatencyProfile* w = nullptr;
+      for (uint8_t i = 0; i < m_count; i++) {
+        if (!w || m_profiles[i].totalExcessUs > w->totalExcessUs) w = &m_profiles[i];
+      }
+      return w;
+    }
+
+    /**
+     * @brief Drop all profiles
+     */
+    inline void reset() { m_count = 0; }
+
+  protected:
+    I2CLatencyProfile* find(uint16_t address) {
+      for (uint8_t i = 0; i < m_count; i++) {
+        if (m_profiles[i].address == address) return &m_profiles[i];
+      }
+      return nullptr;
+    }
+
+    uint8_t m_count;                            //!< Devices profiled
+    I2CLatencyProfile m_profiles[MaxDevices];   //!< The profiles
+};
+#endif /* I2C_LATENCY_PROFILER_LIB_H_ */
@@ -0,0 +1,361 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CLcd.h 
+//!  @brief HD44780 character LCD on a PCF8574 I2C backpack
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_LCD_LIB_H_
+#define I2C_LCD_LIB_H_
+
+#include "I2CDevice.h"
+
+/**
+ * @brief LCD transfer statistics
+ */
+struct I2CLcdStats {
+  uint32_t charsSent;     //!< Characters written to the display
+  uint32_t charsSkipped;  //!< Characters skipped because they were unchanged
+  uint32_t transactions;  //!< Bus transactions used
+  uint32_t busyUs;        //!< Time spent in bus transactions
+
+  /**
+   * @brief Get the character throughput while the bus was busy
+   * 
+   * @return Characters per second
+   */
+  inline uint32_t charsPerSecond() const {
+    return busyUs ? (uint32_t)((uint64_t)charsSent * 1000000UL / busyUs) : 0;
+  }
+};
+
+/**
+ * @brief Driver for HD44780 character LCDs on PCF8574 I2C backpacks 
+ *        (P0 = RS, P1 = RW, P2 = EN, P3 = backlight, P4-P7 = D4-D7).
+ * 
+ *        Every 4-bit nibble needs two expander writes (EN high, EN low).  
+ *        Instead of a transaction per expander write, whole strings are 
+ *        encoded into one buffer and sent in bursts of up to BurstSize 
+ *        bytes.  A shadow copy of the display contents is kept so that 
+ *        characters that are already shown are not sent again.
+ * 
+ * @tparam Cols The number of display columns
+ * @tparam Rows The number of display rows (1 to 4)
+ * @tparam Device The I2C device type, an instance of BasicI2CDevice
+ * @tparam BurstSize The maximum transaction length (the Wire buffer size)
+ */
+template <uint8_t Cols = 16, uint8_t Rows = 2, class Device = I2CDevice, 
+          uint8_t BurstSize = 32>
+class I2CLcd : public BasicHasI2CDevice<Device>, public Print {
+  public:
+    static constexpr uint8_t PIN_RS = 0x01;         //!< Register select expander bit
+    static constexpr uint8_t PIN_RW = 0x02;         //!< Read/write expander bit
+    static constexpr uint8_t PIN_EN = 0x04;         //!< Enable expander bit
+    static constexpr uint8_t PIN_BACKLIGHT = 0x08;  //!< Backlight expander bit
+
+    static constexpr uint8_t CMD_CLEAR = 0x01;          //!< Clear display command
+    static constexpr uint8_t CMD_HOME = 0x02;           //!< Return home command
+    static constexpr uint8_t CMD_ENTRY_MODE = 0x06;     //!< Increment, no shift
+    static constexpr uint8_t CMD_DISPLAY = 0x08;        //!< Display control command
+    static constexpr uint8_t DISPLAY_ON = 0x04;         //!< Display control: display on
+    static constexpr uint8_t CMD_FUNCTION_SET = 0x28;   //!< 4-bit, 2 lines, 5x8 font
+    static constexpr uint8_t CMD_SET_DDRAM = 0x80;      //!< Set DDRAM address command
+
+    /**
+     * @brief Construct an LCD driver
+     * 
+     * @param tw A reference to the TwoWire object (or backend)
+     * @param address The 7-bit backpack address, typically 0x27 or 0x3F
+     */
+    I2CLcd(typename Device::BusType& tw = Wire, 
+           typename Device::AddressType address = 0x27):
+      BasicHasI2CDevice<Device>(tw, address), m_length(0), 
+      m_backlight(PIN_BACKLIGHT), m_display(DISPLAY_ON), m_col(0), m_row(0),
+      m_lcdPosition(0xFF), m_pendingCount(0), m_failed(false), m_stats(){
+      memset(m_shadow, ' ', sizeof(m_shadow));
+      memset(m_known, 0xFF, sizeof(m_known));
+    };
+
+    /**
+     * @brief Initialize the display in 4-bit mode and clear it
+     * 
+     * @return The I2C Bus result
+     */
+    uint8_t begin() {
+      delay(50);
+      static const uint8_t wake[] = { 0x30, 0x30, 0x30, 0x20 };
+      static const uint16_t wait[] = { 4500, 150, 150, 150 };
+      for (uint8_t i = 0; i < 4; i++) {
+        queueNibble(wake[i], 0);
+        if (transmit() != I2CBusResult::SUCCESS) return this->getBusStatus();
+        delayMicroseconds(wait[i]);
+      }
+      command(CMD_FUNCTION_SET);
+      command(CMD_DISPLAY | m_display);
+      command(CMD_ENTRY_MODE);
+      return clear();
+    }
+
+    /**
+     * @brief Clear the display and return the cursor home
+     * 
+     * @return The I2C Bus result
+     */
+    uint8_t clear() {
+      command(CMD_CLEAR);
+      uint8_t status = transmit();
+      delayMicroseconds(1600);
+      m_col = m_row = 0;
+      if (status != I2CBusResult::SUCCESS) return status;
+      memset(m_shadow, ' ', sizeof(m_shadow));
+      memset(m_known, 0xFF, sizeof(m_known));
+      m_lcdPosition = 0;
+      return status;
+    }
+
+    /**
+     * @brief Move the cursor.  No bus traffic happens until the next write.
+     * 
+     * @param col The column
+     * @param row The row
+     */
+    void setCursor(uint8_t col, uint8_t row) {
+      m_col = (col < Cols) ? col : Cols - 1;
+      m_row = (row < Rows) ? row : Rows - 1;
+    }
+
+    /**
+     * @brief Switch the backlight
+     * 
+     * @param on True to switch the backlight on
+     * @return The I2C Bus result
+     */
+    uint8_t backlight(bool on) {
+      m_backlight = on ? PIN_BACKLIGHT : 0;
+      queue(m_backlight);
+      return transmit();
+    }
+
+    /**
+     * @brief Switch the display on or off (contents are kept)
+     * 
+     * @param on True to switch the display on
+     * @return The I2C Bus result
+     */
+    uint8_t display(bool on) {
+      m_display = on ? DISPLAY_ON : 0;
+      command(CMD_DISPLAY | m_display);
+      return transmit();
+    }
+
+    /**
+     * @brief Write a character at the cursor
+     * 
+     * @param c The character
+     * @return The number of characters written, 0 on a bus error
+     */
+    size_t write(uint8_t c) override {
+      m_failed = false;
+      put(c);
+      transmit();
+      return m_failed ? 0 : 1;
+    }
+
+    /**
+     * @brief Write a string at the cursor in as few transactions as possible.
+     *        Characters that are already on the display are skipped.  
+     *        '\n' moves the cursor to the start of the next row.
+     * 
+     * @param buffer The characters to write
+     * @param size The number of characters
+     * @return The number of characters written, 0 on a bus error
+     */
+    size_t write(const uint8_t* buffer, size_t size) override {
+      m_failed = false;
+      for (size_t i = 0; i < size; i++) put(buffer[i]);
+      transmit();
+      return m_failed ? 0 : size;
+    }
+
+    using Print::write;
+
+    /**
+     * @brief Send a raw HD44780 command.  Every command but entry mode and 
+     *        display control may move the LCD's address counter (clear, 
+     *        home, cursor/display shift, set CGRAM or DDRAM address), so 
+     *        the next write sets the DDRAM address again.
+     * 
+     * @param value The command byte
+     */
+    void command(uint8_t value) {
+      queueByte(value, 0);
+      bool entryMode = (value & 0xFC) == 0x04;
+      bool displayControl = (value & 0xF8) == CMD_DISPLAY;
+      if (!entryMode && !displayControl) m_lcdPosition = 0xFF;
+    }
+
+    /**
+     * @brief Send all queued expander writes (Print interface)
+     */
+    void flush() override { transmit(); }
+
+    /**
+     * @brief Send all queued expander writes.  The shadow copy is updated 
+     *        once the characters reached the display; after a bus error the 
+     *        contents and the LCD cursor are unknown, so no character is 
+     *        skipped as unchanged until it was written again (or clear()).
+     * 
+     * @return The I2C Bus result
+     */
+    uint8_t transmit() {
+      if (!m_length) return I2CBusResult::SUCCESS;
+      uint32_t start = micros();
+      uint8_t status = this->bus.transfer(m_buffer, m_length);
+      m_stats.busyUs += micros() - start;
+      m_stats.transactions++;
+      m_length = 0;
+      if (status == I2CBusResult::SUCCESS) {
+        for (uint8_t i = 0; i < m_pendingCount; i++) {
+          uint8_t index = m_pendingIndex[i];
+          m_shadow[index] = m_pendingChar[i];
+          m_known[index >> 3] |= (uint8_t)(1 << (index & 0x07));
+        }
+      } else {
+        memset(m_known, 0, sizeof(m_known));
+        m_lcdPosition = 0xFF;
+        m_failed = true;
+      }
+      m_pendingCount = 0;
+      return status;
+    }
+
+    /**
+     * @brief Get the shadow copy of the display contents
+     * 
+     * @param col The column
+     * @param row The row
+     * @return The character shown at the position
+     */
+    inline uint8_t getChar(uint8_t col, uint8_t row) const { 
+      return m_shadow[row * Cols + col]; 
+    }
+
+    /**
+     * @brief Get the transfer statistics
+     * 
+     * @return const I2CLcdStats& 
+     */
+    inline const I2CLcdStats& getStats() const { return m_stats; }
+
+  protected:
+    void put(uint8_t c) {
+      if (c == '\n') {
+        m_col = 0;
+        m_row = (m_row + 1) % Rows;
+        return;
+      }
+      if (m_col >= Cols) return;
+      uint8_t index = m_row * Cols + m_col;
+      uint8_t position = rowOffset(m_row) + m_col;
+      m_col++;
+      if ((m_known[index >> 3] & (1 << (index & 0x07))) && m_shadow[index] == c) {
+        m_stats.charsSkipped++;
+        return;
+      }
+      if (m_lcdPosition != position) queueByte(CMD_SET_DDRAM | position, 0);
+      queueByte(c, PIN_RS);
+      m_pendingIndex[m_pendingCount] = index;
+      m_pendingChar[m_pendingCount++] = c;
+      m_lcdPosition = position + 1;
+      m_stats.charsSent++;
+    }
+
+    static inline uint8_t rowOffset(uint8_t row) {
+      return (row & 0x01 ? 0x40 : 0x00) + (row & 0x02 ? Cols : 0);
+    }
+
+    inline void queue(uint8_t value) {
+      if (m_length >= BurstSize) transmit();
+      m_buffer[m_length++] = value;
+    }
+
+    inline void queueNibble(uint8_t nibble, uint8_t mode) {
+      uint8_t value = (nibble & 0xF0) | mode | m_backlight;
+      queue(value | PIN_EN);
+      queue(value);
+    }
+
+    inline void queueByte(uint8_t value, uint8_t mode) {
+      queueNibble(value, mode);
+      queueNibble((uint8_t)(value << 4), mode);
+    }
+
+    uint8_t m_buffer[BurstSize];   //!< Expander writes waiting to be sent
+    uint8_t m_length;              //!< The number of queued expander writes
+    uint8_t m_shadow[Cols * Rows]; //!< Copy of the display contents
+    uint8_t m_backlight;           //!< Backlight expander bit state
+    uint8_t m_display;             //!< Display control flags
+    uint8_t m_col;                 //!< Cursor column
+    uint8_t m_row;                 //!< Cursor row
+    uint8_t m_lcdPosition;         //!< DDRAM address of the LCD's own cursor, 0xFF if unknown
+    uint8_t m_pendingIndex[BurstSize / 4 + 1]; //!< Shadow positions of the queued characters
+    uint8_t m_pendingChar[BurstSize / 4 + 1];  //!< The queued characters
+    uint8_t m_pendingCount;        //!< The number of queued characters
+    uint8_t m_known[(Cols * Rows + 7) / 8]; //!< Shadow positions known to match the display
+    bool m_failed;                 //!< A flush failed during the current write()
+    I2CLcdStats m_stats;           //!< Transfer statistics
+};
+#endif /* I2C_LCD_LIB_H_ */
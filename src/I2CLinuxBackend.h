@@ -0,0 +1,182 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CLinuxBackend.h 
+//!  @brief I2CLinuxBackend class definition
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_LINUX_BACKEND_LIB_H_
+#define I2C_LINUX_BACKEND_LIB_H_
+
+#include "I2CBackend.h"
+
+#if defined(__linux__) && !defined(ARDUINO)
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+/**
+ * @brief Backend for Linux i2c-dev bus devices (/dev/i2c-N).  Each transfer 
+ *        is one I2C_RDWR ioctl, so the write and read phases are joined by 
+ *        a repeated start.  The kernel cannot hold the bus between ioctls, 
+ *        NO_STOP is ignored, and the bus clock is set by the system.
+ */
+class I2CLinuxBackend : public I2CBackend {
+  public:
+    I2CLinuxBackend(): m_fd(-1){};
+    ~I2CLinuxBackend() { close(); }
+
+    /**
+     * @brief Open a bus by number
+     * 
+     * @param bus The bus number N of /dev/i2c-N
+     * @return bool False if the device could not be opened
+     */
+    bool open(int bus) {
+      char path[24];
+      snprintf(path, sizeof(path), "/dev/i2c-%d", bus);
+      return open(path);
+    }
+
+    /**
+     * @brief Open a bus device
+     * 
+     * @param path The device path
+     * @return bool False if the device could not be opened
+     */
+    bool open(const char* path) {
+      close();
+      m_fd = ::open(path, O_RDWR | O_CLOEXEC);
+      return m_fd >= 0;
+    }
+
+    /**
+     * @brief Close the bus device
+     */
+    void close() {
+      if (m_fd >= 0) ::close(m_fd);
+      m_fd = -1;
+    }
+
+    /**
+     * @brief Check if a bus device is open
+     * 
+     * @return bool 
+     */
+    inline bool isOpen() const { return m_fd >= 0; }
+
+    void setClock(uint32_t frequency) override { (void)frequency; }
+
+    uint8_t transfer(I2CTransfer& xfer) override {
+      xfer.rxCount = 0;
+      if (m_fd < 0) return xfer.status = OTHER_ERROR;
+      if (xfer.txLength > 0xFFFF || xfer.rxLength > 0xFFFF) return xfer.status = DATA_TOO_LONG;
+      uint16_t flags = (xfer.flags & I2CTransfer::TEN_BIT) ? I2C_M_TEN : 0;
+      struct i2c_msg msgs[2];
+      uint8_t count = 0;
+      if (xfer.txLength > 0 || xfer.rxLength == 0) {
+        msgs[count].addr = xfer.address;
+        msgs[count].flags = flags;
+        msgs[count].len = (uint16_t)xfer.txLength;
+        msgs[count].buf = (uint8_t*)xfer.txData;
+        count++;
+      }
+      if (xfer.rxLength > 0) {
+        msgs[count].addr = xfer.address;
+        msgs[count].flags = flags | I2C_M_RD;
+        msgs[count].len = (uint16_t)xfer.rxLength;
+        msgs[count].buf = xfer.rxData;
+        count++;
+      }
+      struct i2c_rdwr_ioctl_data data;
+      data.msgs = msgs;
+      data.nmsgs = count;
+      if (ioctl(m_fd, I2C_RDWR, &data) < 0) return xfer.status = errorStatus(errno);
+      xfer.rxCount = xfer.rxLength;
+      return xfer.status = SUCCESS;
+    }
+
+    /**
+     * @brief Get the file descriptor of the bus device
+     * 
+     * @return int The descriptor, -1 if not open
+     */
+    inline int getFd() const { return m_fd; }
+
+  protected:
+    /**
+     * @brief Map an i2c-dev error (see the kernel's i2c fault codes) to an 
+     *        I2C Bus result.  The kernel does not tell address and data 
+     *        NACKs apart.
+     */
+    static uint8_t errorStatus(int error) {
+      switch (error) {
+        case ENXIO:
+        case EREMOTEIO: return NACK_ON_ADDRESS;
+        case EAGAIN: return ARBITRATION_LOST;
+        case EMSGSIZE: return DATA_TOO_LONG;
+        default: return OTHER_ERROR;
+      }
+    }
+
+    int m_fd;   //!< The bus device descriptor
+};
+#endif
+#endif /* I2C_LINUX_BACKEND_LIB_H_ */
@@ -0,0 +1,150 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CMux.h 
+//!  @brief I2CMux class definition
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_MUX_LIB_H_
+#define I2C_MUX_LIB_H_
+
+#include "I2CDevice.h"
+
+/**
+ * @brief Driver for TCA9548A/PCA9548A style I2C multiplexers: a single 
+ *        control register where each bit enables one downstream channel.
+ * 
+ * @tparam Device The I2C device type, an instance of BasicI2CDevice
+ */
+template <class Device = I2CDevice>
+class I2CMux : public BasicHasI2CDevice<Device> {
+  public:
+    static constexpr uint8_t CHANNELS = 8;  //!< The number of channels
+
+    /**
+     * @brief Construct a multiplexer driver
+     * 
+     * @param tw A reference to the TwoWire object (or backend)
+     * @param address The 7-bit multiplexer address (0x70 to 0x77)
+     */
+    I2CMux(typename Device::BusType& tw = Wire, 
+           typename Device::AddressType address = 0x70):
+      BasicHasI2CDevice<Device>(tw, address), m_mask(0), m_known(false){};
+
+    /**
+     * @brief Enable a set of channels.  Nothing is sent if the mask is 
+     *        already selected.
+     * 
+     * @param mask One bit per channel
+     * @return The I2C Bus result
+     */
+    uint8_t select(uint8_t mask) {
+      if (m_known && mask == m_mask) return I2CBusResult::SUCCESS;
+      uint8_t status = this->bus.transfer(&mask, 1);
+      m_known = (status == I2CBusResult::SUCCESS);
+      m_mask = mask;
+      return status;
+    }
+
+    /**
+     * @brief Enable a single channel
+     * 
+     * @param channel The channel (0 to 7)
+     * @return The I2C Bus result
+     */
+    inline uint8_t selectChannel(uint8_t channel) {
+      return select((uint8_t)(1 << channel));
+    }
+
+    /**
+     * @brief Disable all channels
+     * 
+     * @return The I2C Bus result
+     */
+    inline uint8_t disable() { return select(0); }
+
+    /**
+     * @brief Read the channel mask back from the multiplexer
+     * 
+     * @param mask Set to the channel mask
+     * @return The I2C Bus result
+     */
+    uint8_t readSelected(uint8_t& mask) {
+      uint8_t status = this->bus.transfer(nullptr, 0, &mask, 1);
+      if (status == I2CBusResult::SUCCESS) {
+        m_mask = mask;
+        m_known = true;
+      }
+      return status;
+    }
+
+    /**
+     * @brief Get the last selected channel mask
+     * 
+     * @return uint8_t 
+     */
+    inline uint8_t getSelected() const { return m_mask; }
+
+    /**
+     * @brief Forget the cached channel mask, e.g. after a multiplexer reset
+     */
+    inline void invalidate() { m_known = false; }
+
+  protected:
+    uint8_t m_mask;  //!< The selected channel mask
+    bool m_known;    //!< m_mask matches the multiplexer register
+};
+#endif /* I2C_MUX_LIB_H_ */
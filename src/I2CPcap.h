@@ -0,0 +1,303 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CPcap.h 
+//!  @brief I2CPcapWriter class definitions
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_PCAP_LIB_H_
+#define I2C_PCAP_LIB_H_
+
+#include "I2CDevice.h"
+#include "I2CClock.h"
+#include "I2CLatencyProfiler.h"
+
+#if !defined(ARDUINO)
+#include <stdio.h>
+
+/**
+ * @brief Output for I2CPcapWriter on hosted builds, writing to a stdio file.
+ *        On Arduino any Print (Serial, an SD card File) is an output.
+ */
+class I2CFileOutput {
+  public:
+    I2CFileOutput(FILE* file): m_file(file){};
+
+    inline size_t write(const uint8_t* data, size_t length) {
+      return fwrite(data, 1, length, m_file);
+    }
+
+    inline void flush() { fflush(m_file); }
+
+  protected:
+    FILE* m_file; //!< The file written to
+};
+#endif
+
+/**
+ * @brief Streams transfers as a Wireshark capture (pcap or pcapng, link 
+ *        type DLT_I2C_LINUX).  Each transfer phase is one packet: the Linux 
+ *        pseudo-header (bus number, i2c_msg flags), the address byte with 
+ *        the direction bit, then the data.  Nothing is buffered, packets go 
+ *        to the output as they are recorded, so captures can be of any 
+ *        length.
+ * 
+ *        Timestamps come from a 32-bit microsecond clock and are extended 
+ *        to 64 bits, so they are correct across clock wraparounds as long 
+ *        as transfers are recorded at least every 35 minutes.
+ * 
+ * @tparam Output Has size_t write(const uint8_t*, size_t), e.g. Print
+ * @tparam Clock The clock used for the timestamps of observed transfers
+ */
+template <class Output, class Clock = I2CDefaultClock>
+class I2CPcapWriter : public I2CTransferObserver {
+  public:
+    static constexpr uint16_t LINKTYPE_I2C_LINUX = 209; //!< DLT_I2C_LINUX
+    static constexpr uint32_t FLAG_READ = 0x0001;       //!< i2c_msg I2C_M_RD
+    static constexpr uint32_t FLAG_TEN = 0x0010;        //!< i2c_msg I2C_M_TEN
+    static constexpr uint32_t SNAPLEN = 65535;          //!< Largest packet saved
+
+    /**
+     * @brief The file format
+     */
+    enum Format : uint8_t {
+      PCAP,     //!< Classic libpcap format
+      PCAPNG    //!< pcapng, one section and one interface
+    };
+
+    I2CPcapWriter(Output& output, uint8_t bus = 0, Format format = PCAP, 
+                  Clock clock = Clock()):
+      m_output(output), m_clock(clock), m_format(format), m_bus(bus & 0x7F), 
+      m_lastUs(0), m_timeUs(0), m_packets(0), m_bytes(0){};
+
+    /**
+     * @brief Write the file header.  Call once before recording.
+     * 
+     * @param epochUs The wall clock time of now in microseconds since 1970, 
+     *                0 to start the capture at the epoch
+     */
+    void begin(uint64_t epochUs = 0) {
+      m_lastUs = m_clock.nowUs();
+      m_timeUs = epochUs;
+      if (m_format == PCAPNG) {
+        put32(0x0A0D0D0AUL); put32(28); put32(0x1A2B3C4DUL);
+        put16(1); put16(0);
+        put32(0xFFFFFFFFUL); put32(0xFFFFFFFFUL);
+        put32(28);
+        put32(1); put32(20); put16(LINKTYPE_I2C_LINUX); put16(0); put32(SNAPLEN); put32(20);
+      } else {
+        put32(0xA1B2C3D4UL); put16(2); put16(4);
+        put32(0); put32(0); put32(SNAPLEN); put32(LINKTYPE_I2C_LINUX);
+      }
+    }
+
+    /**
+     * @brief Record a finished transfer: a write packet at its start if it 
+     *        has a write phase (or no phase, an address probe), and a read 
+     *        packet at its end if the read phase was reached.
+     * 
+     * @param xfer The transfer
+     * @param startUs The clock time when the transfer started
+     * @param endUs The clock time when the transfer finished
+     */
+    void record(const I2CTransfer& xfer, uint32_t startUs, uint32_t endUs) {
+      if (xfer.txLength || !xfer.rxLength) {
+        size_t length = xfer.status == I2CBusResult::NACK_ON_ADDRESS ? 0 : xfer.txLength;
+        writePacket(timestamp(startUs), xfer.address, xfer.flags, false, xfer.txData, length);
+      }
+      if (xfer.rxLength && (!xfer.txLength || xfer.status == I2CBusResult::SUCCESS || xfer.rxCount)) {
+        writePacket(timestamp(endUs), xfer.address, xfer.flags, true, xfer.rxData, xfer.rxCount);
+      }
+    }
+
+    /**
+     * @brief Record a transfer executed by an I2CBusEngine, which ended now
+     */
+    void onTransfer(const I2CTransfer& xfer, uint32_t predictedNs, uint32_t actualNs) override {
+      (void)predictedNs;
+      uint32_t endUs = m_clock.nowUs();
+      record(xfer, endUs - actualNs / 1000, endUs);
+    }
+
+    /**
+     * @brief Get the clock
+     * 
+     * @return const Clock& 
+     */
+    inline const Clock& getClock() const { return m_clock; }
+
+    /**
+     * @brief Get the number of packets written
+     * 
+     * @return uint32_t 
+     */
+    inline uint32_t getPackets() const { return m_packets; }
+
+    /**
+     * @brief Get the number of bytes written, including the file header
+     * 
+     * @return uint32_t 
+     */
+    inline uint32_t getBytes() const { return m_bytes; }
+
+  protected:
+    /**
+     * @brief Convert a clock time to the capture time, extending it to 64 
+     *        bits.  Times slightly before the last one are allowed.
+     */
+    uint64_t timestamp(uint32_t us) {
+      m_timeUs += (int32_t)(us - m_lastUs);
+      m_lastUs = us;
+      return m_timeUs;
+    }
+
+    void writePacket(uint64_t timeUs, uint16_t address, uint8_t xferFlags, 
+                     bool read, const uint8_t* data, size_t length) {
+      uint8_t header[7];
+      size_t headerLength = 6;
+      uint32_t flags = read ? FLAG_READ : 0;
+      header[0] = m_bus;
+      if (xferFlags & I2CTransfer::TEN_BIT) {
+        flags |= FLAG_TEN;
+        header[5] = 0xF0 | ((address >> 7) & 0x06) | (read ? 1 : 0);
+        header[6] = (uint8_t)address;
+        headerLength = 7;
+      } else {
+        header[5] = (uint8_t)(address << 1) | (read ? 1 : 0);
+      }
+      header[1] = (uint8_t)(flags >> 24);
+      header[2] = (uint8_t)(flags >> 16);
+      header[3] = (uint8_t)(flags >> 8);
+      header[4] = (uint8_t)flags;
+      if (!data) length = 0;
+      uint32_t original = (uint32_t)(headerLength + length);
+      if (length > SNAPLEN - headerLength) length = SNAPLEN - headerLength;
+      uint32_t captured = (uint32_t)(headerLength + length);
+      if (m_format == PCAPNG) {
+        uint32_t padding = (4 - (captured & 3)) & 3;
+        uint32_t total = 32 + captured + padding;
+        put32(6); put32(total); put32(0);
+        put32((uint32_t)(timeUs >> 32)); put32((uint32_t)timeUs);
+        put32(captured); put32(original);
+        put(header, headerLength); put(data, length);
+        static const uint8_t zeros[3] = {0, 0, 0};
+        put(zeros, padding);
+        put32(total);
+      } else {
+        put32((uint32_t)(timeUs / 1000000)); put32((uint32_t)(timeUs % 1000000));
+        put32(captured); put32(original);
+        put(header, headerLength); put(data, length);
+      }
+      m_packets++;
+    }
+
+    inline void put(const uint8_t* data, size_t length) {
+      if (length) m_bytes += m_output.write(data, length);
+    }
+
+    inline void put16(uint16_t value) {
+      uint8_t b[2] = {(uint8_t)value, (uint8_t)(value >> 8)};
+      put(b, 2);
+    }
+
+    inline void put32(uint32_t value) {
+      uint8_t b[4] = {(uint8_t)value, (uint8_t)(value >> 8), 
+                      (uint8_t)(value >> 16), (uint8_t)(value >> 24)};
+      put(b, 4);
+    }
+
+    Output& m_output;    //!< Where the capture is written
+    Clock m_clock;       //!< The timestamp clock
+    Format m_format;     //!< The file format
+    uint8_t m_bus;       //!< The bus number in the pseudo-header
+    uint32_t m_lastUs;   //!< The last clock time seen
+    uint64_t m_timeUs;   //!< The capture time of m_lastUs
+    uint32_t m_packets;  //!< Packets written
+    uint32_t m_bytes;    //!< Bytes written
+};
+
+/**
+ * @brief Backend that passes transfers to another bus and records them 
+ *        with an I2CPcapWriter, e.g. 
+ *        BasicI2CDevice<I2CPcapBackend<TwoWire, Print>> to capture a 
+ *        driver's traffic to Serial.
+ * 
+ * @tparam Bus The bus executing the transfers, TwoWire or a backend
+ * @tparam Output The writer's output
+ * @tparam Clock The writer's clock
+ */
+template <class Bus, class Output, class Clock = I2CDefaultClock>
+class I2CPcapBackend : public I2CBackend {
+  public:
+    I2CPcapBackend(Bus& bus, I2CPcapWriter<Output, Clock>& writer): m_bus(bus), m_writer(writer){};
+
+    uint8_t transfer(I2CTransfer& xfer) override {
+      uint32_t startUs = m_writer.getClock().nowUs();
+      i2cTransfer(m_bus, xfer);
+      m_writer.record(xfer, startUs, m_writer.getClock().nowUs());
+      return xfer.status;
+    }
+
+    void setClock(uint32_t frequency) override {
+      I2CBackend::setClock(frequency);
+      m_bus.setClock(frequency);
+    }
+
+  protected:
+    Bus& m_bus;                             //!< The traced bus
+    I2CPcapWriter<Output, Clock>& m_writer; //!< Records the transfers
+};
+#endif /* I2C_PCAP_LIB_H_ */
@@ -0,0 +1,115 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CRegister.h 
+//!  @brief I2C register address width traits
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_REGISTER_LIB_H_
+#define I2C_REGISTER_LIB_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Register address traits: the width and byte order of the register 
+ *        address sent at the start of register reads and writes.
+ * 
+ *        The register address format is a template parameter of 
+ *        BasicI2CDevice, so the encoding is resolved at compile time and 
+ *        the common 8-bit case compiles to a single byte store.
+ * 
+ * @tparam T The register address storage type
+ * @tparam Bytes The number of address bytes sent on the bus
+ * @tparam BigEndian True to send the most significant byte first
+ */
+template <typename T, uint8_t Bytes, bool BigEndian = true>
+struct I2CRegisterTraits {
+  typedef T Type;                          //!< Storage type of the register address
+  static constexpr uint8_t BYTES = Bytes;  //!< Register address bytes sent on the bus
+
+  /**
+   * @brief Encode a register address in bus order
+   * 
+   * @param reg The register address
+   * @param out The output buffer, at least BYTES long
+   */
+  static inline void encode(Type reg, uint8_t* out) {
+    for (uint8_t i = 0; i < Bytes; i++) {
+      out[i] = (uint8_t)(reg >> (8 * (BigEndian ? (Bytes - 1 - i) : i)));
+    }
+  }
+
+  /**
+   * @brief Decode a register address from bus order
+   * 
+   * @param in The encoded register address, BYTES long
+   * @return The register address
+   */
+  static inline Type decode(const uint8_t* in) {
+    Type reg = 0;
+    for (uint8_t i = 0; i < Bytes; i++) {
+      reg |= (Type)in[i] << (8 * (BigEndian ? (Bytes - 1 - i) : i));
+    }
+    return reg;
+  }
+};
+
+typedef I2CRegisterTraits<uint8_t, 1> I2CRegister8;           //!< 8-bit register addresses
+typedef I2CRegisterTraits<uint16_t, 2> I2CRegister16;         //!< 16-bit big-endian register addresses (24C512, camera sensors)
+typedef I2CRegisterTraits<uint16_t, 2, false> I2CRegister16LE; //!< 16-bit little-endian register addresses
+typedef I2CRegisterTraits<uint32_t, 4> I2CRegister32;         //!< 32-bit big-endian register addresses
+#endif /* I2C_REGISTER_LIB_H_ */
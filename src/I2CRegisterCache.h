@@ -0,0 +1,235 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CRegisterCache.h 
+//!  @brief I2CRegisterCache class definition
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_REGISTER_CACHE_LIB_H_
+#define I2C_REGISTER_CACHE_LIB_H_
+
+#include "I2CDevice.h"
+
+#if defined(__has_include)
+#if __has_include(<atomic>)
+#define I2C_HAS_ATOMIC 1
+#endif
+#endif
+
+#if defined(I2C_HAS_ATOMIC)
+#include <atomic>
+
+/**
+ * @brief Update bytes held in atomic words under a sequence lock.  Only one 
+ *        writer may update the same words at a time.
+ * 
+ * @param seq The sequence number, odd during updates
+ * @param words The words holding the data
+ * @param data The new data
+ * @param length The data length
+ * @param offset The byte offset in the words
+ */
+inline void i2cSeqlockWrite(std::atomic<uint32_t>& seq, std::atomic<uint32_t>* words,
+                            const uint8_t* data, size_t length, size_t offset) {
+  uint32_t s = seq.load(std::memory_order_relaxed);
+  seq.store(s + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  size_t last = (offset + length + 3) / 4;
+  for (size_t w = offset / 4; w < last; w++) {
+    uint8_t bytes[4];
+    uint32_t word = words[w].load(std::memory_order_relaxed);
+    memcpy(bytes, &word, 4);
+    for (uint8_t b = 0; b < 4; b++) {
+      size_t pos = w * 4 + b;
+      if (pos >= offset && pos < offset + length) bytes[b] = data[pos - offset];
+    }
+    memcpy(&word, bytes, 4);
+    words[w].store(word, std::memory_order_relaxed);
+  }
+  seq.store(s + 2, std::memory_order_release);
+}
+
+/**
+ * @brief Try to copy bytes held in atomic words under a sequence lock
+ * 
+ * @param seq The sequence number, odd during updates
+ * @param words The words holding the data
+ * @param out The output buffer
+ * @param length The number of bytes
+ * @param offset The byte offset in the words
+ * @param version Set to the number of completed updates, may be nullptr
+ * @return bool False if an update overlapped the copy, out may then hold 
+ *         torn data
+ */
+inline bool i2cSeqlockTryRead(const std::atomic<uint32_t>& seq, 
+                              const std::atomic<uint32_t>* words, uint8_t* out, 
+                              size_t length, size_t offset, uint32_t* version = nullptr) {
+  uint32_t s = seq.load(std::memory_order_acquire);
+  if (s & 0x01) return false;
+  size_t first = offset / 4;
+  size_t last = (offset + length + 3) / 4;
+  for (size_t w = first; w < last; w++) {
+    uint8_t bytes[4];
+    uint32_t word = words[w].load(std::memory_order_relaxed);
+    memcpy(bytes, &word, 4);
+    for (uint8_t b = 0; b < 4; b++) {
+      size_t pos = w * 4 + b;
+      if (pos >= offset && pos < offset + length) out[pos - offset] = bytes[b];
+    }
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (seq.load(std::memory_order_relaxed) != s) return false;
+  if (version) *version = s >> 1;
+  return true;
+}
+
+/**
+ * @brief Register cache shared between one bus thread and any number of 
+ *        reader threads, protected by a sequence lock.
+ * 
+ *        The bus thread updates the cache with refresh() or write(); readers 
+ *        copy it out with read() without taking a lock and without ever 
+ *        blocking the writer: a reader that overlaps an update sees an odd 
+ *        or changed sequence number and simply copies again.  The data is 
+ *        held in relaxed atomic words, so concurrent access is race-free.
+ * 
+ *        Only one thread may write at a time.
+ * 
+ * @tparam Size The cache size in bytes
+ */
+template <size_t Size>
+class I2CRegisterCache : public I2CBusResult {
+  public:
+    static constexpr size_t WORDS = (Size + 3) / 4; //!< Atomic words holding the data
+
+    I2CRegisterCache(): m_seq(0) {
+      for (size_t i = 0; i < WORDS; i++) m_words[i].store(0, std::memory_order_relaxed);
+    };
+
+    /**
+     * @brief Read registers from a device into the cache (bus thread only)
+     * 
+     * @param dev The device
+     * @param reg The first register
+     * @param length The number of bytes read
+     * @param offset The cache offset to store them at
+     * @return The I2C Bus result, the cache is unchanged on failure
+     */
+    template <class Device>
+    uint8_t refresh(Device& dev, typename Device::RegisterType reg, size_t length, 
+                    size_t offset = 0) {
+      if (offset + length > Size) return DATA_TOO_LONG;
+      uint8_t data[Size];
+      uint8_t status = dev.readRegisters(reg, data, length);
+      if (status == SUCCESS) write(data, length, offset);
+      return status;
+    }
+
+    /**
+     * @brief Update the cache (bus thread only)
+     * 
+     * @param data The new data
+     * @param length The data length
+     * @param offset The cache offset
+     */
+    void write(const uint8_t* data, size_t length, size_t offset = 0) {
+      if (offset + length > Size) return;
+      i2cSeqlockWrite(m_seq, m_words, data, length, offset);
+    }
+
+    /**
+     * @brief Try to copy a consistent snapshot out of the cache once
+     * 
+     * @param out The output buffer
+     * @param length The number of bytes
+     * @param offset The cache offset
+     * @return bool False if an update overlapped the copy
+     */
+    bool tryRead(uint8_t* out, size_t length, size_t offset = 0) const {
+      if (offset + length > Size) return false;
+      return i2cSeqlockTryRead(m_seq, m_words, out, length, offset);
+    }
+
+    /**
+     * @brief Copy a consistent snapshot out of the cache, retrying while 
+     *        updates overlap.  Never blocks the bus thread.
+     * 
+     * @param out The output buffer
+     * @param length The number of bytes
+     * @param offset The cache offset
+     * @return bool False if the range is outside the cache
+     */
+    bool read(uint8_t* out, size_t length, size_t offset = 0) const {
+      if (offset + length > Size) return false;
+      while (!tryRead(out, length, offset)) {}
+      return true;
+    }
+
+    /**
+     * @brief Get the number of completed updates
+     * 
+     * @return uint32_t 
+     */
+    inline uint32_t getVersion() const { 
+      return m_seq.load(std::memory_order_acquire) >> 1; 
+    }
+
+  protected:
+    std::atomic<uint32_t> m_seq;            //!< Sequence number, odd during updates
+    std::atomic<uint32_t> m_words[WORDS];   //!< The cached data
+};
+#endif
+#endif /* I2C_REGISTER_CACHE_LIB_H_ */
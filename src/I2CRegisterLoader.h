@@ -0,0 +1,254 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CRegisterLoader.h 
+//!  @brief I2CRegisterLoader class definition
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_REGISTER_LOADER_LIB_H_
+#define I2C_REGISTER_LOADER_LIB_H_
+
+#include "I2CDevice.h"
+#include "I2CClock.h"
+
+/**
+ * @brief One entry of a register initialization table
+ * 
+ * @tparam Reg The register address type
+ */
+template <typename Reg>
+struct I2CRegisterEntry {
+  Reg reg;        //!< The register address, or the delay marker
+  uint8_t value;  //!< The register value, or the delay in milliseconds
+};
+
+/**
+ * @brief Register loader statistics, of the last load() only
+ */
+struct I2CRegisterLoaderStats {
+  uint32_t entries;       //!< Register writes loaded
+  uint32_t transactions;  //!< Bus transactions used
+  uint32_t delays;        //!< Delay markers honored
+  uint32_t elapsedUs;     //!< Time taken by the last load()
+};
+
+/**
+ * @brief Loads (register, value) initialization tables into a device, as 
+ *        needed by audio codecs and camera sensors.
+ * 
+ *        Runs of ascending consecutive register addresses are merged into 
+ *        auto-increment bursts so that a table of hundreds of entries needs 
+ *        only a few transactions.  An entry whose register is the delay 
+ *        marker (all ones by default) waits for value milliseconds instead.
+ *        Tables may be in RAM or in PROGMEM.
+ * 
+ *        With SORT, entries between delay markers are sorted by register 
+ *        address (in windows of SortWindow entries) before merging, for 
+ *        devices where the write order within a block does not matter.  
+ *        Repeated writes to a register within a window collapse into the 
+ *        last one.  Without SORT every entry is written in table order, a 
+ *        register written twice (e.g. reset, then configure) is written 
+ *        twice.
+ * 
+ * @tparam Device The I2C device type, an instance of BasicI2CDevice
+ * @tparam SortWindow The number of entries sorted at once (0 disables sorting)
+ * @tparam Clock The time source, e.g. I2CArduinoClock or I2CSimClock
+ */
+template <class Device = I2CDevice, uint8_t SortWindow = 0, class Clock = I2CDefaultClock>
+class I2CRegisterLoader : public I2CBusResult {
+  public:
+    typedef typename Device::RegisterType RegisterType;   //!< The register address type
+    typedef I2CRegisterEntry<RegisterType> Entry;         //!< The table entry type
+
+    static constexpr uint8_t AUTO_INCREMENT = 0x01; //!< Merge consecutive registers into bursts
+    static constexpr uint8_t SORT = 0x02;           //!< Sort entries between delay markers
+    static constexpr uint8_t PROGMEM_TABLE = 0x04;  //!< The table is stored in PROGMEM
+
+    /**
+     * @brief The longest burst, limited by the Wire buffer minus the 
+     *        extra 10-bit address byte and the register address bytes
+     */
+    static constexpr uint8_t MAX_BURST = Device::MAX_WRITE;
+
+    /**
+     * @brief Construct a register loader
+     * 
+     * @param device The device to load the table into
+     * @param clock The time source used for delay markers
+     * @param delayMarker The register address value marking a delay entry
+     */
+    I2CRegisterLoader(Device& device, const Clock& clock = Clock(), 
+                      RegisterType delayMarker = (RegisterType)~(RegisterType)0):
+      m_device(device), m_clock(clock), m_delayMarker(delayMarker), 
+      m_length(0), m_status(SUCCESS), m_stats(){};
+
+    /**
+     * @brief Load a table into the device
+     * 
+     * @param table The table
+     * @param count The number of entries in the table
+     * @param options AUTO_INCREMENT, SORT and PROGMEM_TABLE flags
+     * @return The I2C Bus result of the first failing transaction, or SUCCESS
+     */
+    uint8_t load(const Entry* table, size_t count, uint8_t options = AUTO_INCREMENT) {
+      uint32_t start = m_clock.nowUs();
+      m_stats = I2CRegisterLoaderStats();
+      m_status = SUCCESS;
+      m_options = options;
+      m_length = 0;
+      size_t i = 0;
+      while (i < count && m_status == SUCCESS) {
+        if (SortWindow && (options & SORT)) i = loadSorted(table, i, count);
+        else add(readEntry(table + i++));
+      }
+      flush();
+      m_stats.elapsedUs = m_clock.nowUs() - start;
+      return m_status;
+    }
+
+    /**
+     * @brief Get the statistics of the last load()
+     * 
+     * @return const I2CRegisterLoaderStats& 
+     */
+    inline const I2CRegisterLoaderStats& getStats() const { return m_stats; }
+
+  protected:
+    inline Entry readEntry(const Entry* p) const {
+      Entry e;
+#if defined(__AVR__)
+      if (m_options & PROGMEM_TABLE) {
+        memcpy_P(&e, p, sizeof(Entry));
+        return e;
+      }
+#endif
+      e = *p;
+      return e;
+    }
+
+    /**
+     * @brief Sort and load up to SortWindow entries, stopping at a delay 
+     *        marker.  A later write to a register already in the window 
+     *        replaces the earlier one.  Returns the index of the next entry 
+     *        to load.
+     */
+    size_t loadSorted(const Entry* table, size_t i, size_t count) {
+      Entry window[SortWindow ? SortWindow : 1];
+      uint8_t n = 0;
+      while (i < count && n < SortWindow) {
+        Entry e = readEntry(table + i);
+        if (e.reg == m_delayMarker) break;
+        i++;
+        uint8_t k = 0;
+        while (k < n && window[k].reg != e.reg) k++;
+        if (k < n) {
+          window[k].value = e.value;
+          m_stats.entries++;
+          continue;
+        }
+        uint8_t j = n++;
+        while (j > 0 && window[j - 1].reg > e.reg) {
+          window[j] = window[j - 1];
+          j--;
+        }
+        window[j] = e;
+      }
+      for (uint8_t j = 0; j < n; j++) add(window[j]);
+      if (n == 0) add(readEntry(table + i++));
+      return i;
+    }
+
+    void add(const Entry& e) {
+      if (e.reg == m_delayMarker) {
+        flush();
+        m_clock.delayUs((uint32_t)e.value * 1000);
+        m_stats.delays++;
+        return;
+      }
+      m_stats.entries++;
+      if (m_length && (m_options & AUTO_INCREMENT)) {
+        RegisterType last = (RegisterType)(m_start + m_length - 1);
+        if (e.reg == (RegisterType)(last + 1) && m_length < MAX_BURST) {
+          m_buffer[m_length++] = e.value;
+          return;
+        }
+      }
+      flush();
+      m_start = e.reg;
+      m_buffer[0] = e.value;
+      m_length = 1;
+    }
+
+    void flush() {
+      if (!m_length) return;
+      if (m_status == SUCCESS) {
+        m_status = m_device.writeRegisters(m_start, m_buffer, m_length);
+        m_stats.transactions++;
+      }
+      m_length = 0;
+    }
+
+    Device& m_device;             //!< The device being loaded
+    Clock m_clock;                //!< The time source for delays
+    RegisterType m_delayMarker;   //!< Register value marking a delay entry
+    RegisterType m_start;         //!< First register of the pending burst
+    uint8_t m_buffer[MAX_BURST];  //!< Values of the pending burst
+    uint8_t m_length;             //!< Length of the pending burst
+    uint8_t m_options;            //!< Options of the current load()
+    uint8_t m_status;             //!< The first failing bus result
+    I2CRegisterLoaderStats m_stats; //!< Loader statistics
+};
+#endif /* I2C_REGISTER_LOADER_LIB_H_ */
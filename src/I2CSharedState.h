@@ -0,0 +1,420 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CSharedState.h 
+//!  @brief I2CSharedState class definitions
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_SHARED_STATE_LIB_H_
+#define I2C_SHARED_STATE_LIB_H_
+
+#include "I2CRegisterCache.h"
+
+#if defined(I2C_HAS_ATOMIC) && !defined(ARDUINO) && (defined(__unix__) || defined(__APPLE__))
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sched.h>
+#include <unistd.h>
+#include <new>
+
+/**
+ * @brief Layout of a shared device state segment.  The segment is a header 
+ *        followed by slotCount slots of slotStride bytes.  Each slot is an 
+ *        I2CSharedSlot followed by the device data in atomic words, updated 
+ *        under the slot's sequence lock.
+ */
+struct I2CSharedHeader {
+  static constexpr uint32_t MAGIC = 0x53433249UL; //!< "I2CS"
+  static constexpr uint16_t SCHEMA_VERSION = 2;   //!< Layout version
+
+  std::atomic<uint32_t> magic; //!< MAGIC, written once the header and the empty slots are initialized
+  uint16_t schema;             //!< SCHEMA_VERSION
+  uint16_t slotCount;          //!< The number of slots
+  uint16_t dataBytes;          //!< Data bytes per slot
+  uint16_t reserved;           //!< Zero
+  uint32_t slotStride;         //!< Bytes per slot, including the slot header
+};
+
+/**
+ * @brief Header of a slot in a shared device state segment
+ */
+struct I2CSharedSlot {
+  std::atomic<uint32_t> seq;   //!< Sequence number, odd during updates
+  std::atomic<uint32_t> ready; //!< Nonzero once address, bus and length are set
+  uint16_t address;            //!< The device address, 0xFFFF if unused
+  uint8_t bus;                 //!< The bus number
+  uint8_t length;              //!< The number of valid data bytes
+};
+
+/**
+ * @brief A mapped POSIX shared memory segment, the common mapping code of 
+ *        the shared state publisher and reader
+ */
+class I2CSharedSegment {
+  public:
+    I2CSharedSegment(): m_base(nullptr), m_size(0), m_slotCount(0), m_slotStride(0){};
+    ~I2CSharedSegment() { unmap(); }
+
+    /**
+     * @brief Check if a segment is mapped
+     * 
+     * @return bool 
+     */
+    inline bool isOpen() const { return m_base != nullptr; }
+
+    /**
+     * @brief Get the number of slots
+     * 
+     * @return uint16_t 
+     */
+    inline uint16_t slotCount() const { return m_slotCount; }
+
+    /**
+     * @brief Find the slot of a device
+     * 
+     * @param address The device address
+     * @param bus The bus number
+     * @return The slot index, or -1 if not found
+     */
+    int find(uint16_t address, uint8_t bus = 0) const {
+      for (uint16_t i = 0; i < slotCount(); i++) {
+        const I2CSharedSlot* s = slot(i);
+        if (isReady(i) && s->address == address && s->bus == bus) return i;
+      }
+      return -1;
+    }
+
+    /**
+     * @brief Check if a slot was assigned to a device
+     * 
+     * @param index The slot index
+     * @return bool False if the index is invalid or the slot is unused
+     */
+    inline bool isReady(int index) const {
+      return m_base && index >= 0 && index < slotCount() &&
+             slot(index)->ready.load(std::memory_order_acquire) != 0;
+    }
+
+  protected:
+    inline I2CSharedHeader* header() const { return (I2CSharedHeader*)m_base; }
+
+    inline I2CSharedSlot* slot(uint16_t index) const {
+      return (I2CSharedSlot*)(m_base + sizeof(I2CSharedHeader) + 
+                              (size_t)index * m_slotStride);
+    }
+
+    /**
+     * @brief Get the data length of a slot, limited to the slot stride
+     */
+    inline uint8_t dataLength(uint16_t index) const {
+      uint32_t length = slot(index)->length;
+      uint32_t room = m_slotStride - sizeof(I2CSharedSlot);
+      return (uint8_t)(length < room ? length : room);
+    }
+
+    inline std::atomic<uint32_t>* words(uint16_t index) const {
+      return (std::atomic<uint32_t>*)((uint8_t*)slot(index) + sizeof(I2CSharedSlot));
+    }
+
+    /**
+     * @brief Map a named segment
+     * 
+     * @param name The segment name
+     * @param size The size to create the segment with, 0 to map an 
+     *             existing segment whole.  An existing segment is unlinked 
+     *             and a new one created, processes that still map the old 
+     *             one keep it until they open the name again.
+     * @param writable Map for writing
+     * @return bool False if the segment could not be created or mapped
+     */
+    bool map(const char* name, size_t size, bool writable) {
+      unmap();
+      if (size) shm_unlink(name);
+      int fd = size ? shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644) :
+                      shm_open(name, writable ? O_RDWR : O_RDONLY, 0);
+      if (fd < 0) return false;
+      bool ok;
+      if (size) {
+        ok = ftruncate(fd, (off_t)size) == 0;
+      }
+      else {
+        struct stat st;
+        ok = fstat(fd, &st) == 0 && st.st_size > 0;
+        size = ok ? (size_t)st.st_size : 0;
+      }
+      void* base = ok ? mmap(nullptr, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, 
+                             MAP_SHARED, fd, 0) : MAP_FAILED;
+      ::close(fd);
+      if (base == MAP_FAILED) return false;
+      m_base = (uint8_t*)base;
+      m_size = size;
+      return true;
+    }
+
+    void unmap() {
+      if (m_base) munmap(m_base, m_size);
+      m_base = nullptr;
+      m_size = 0;
+      m_slotCount = 0;
+      m_slotStride = 0;
+    }
+
+    uint8_t* m_base;        //!< The mapped segment
+    size_t m_size;          //!< The mapped size
+    uint16_t m_slotCount;   //!< The number of slots, checked against the mapping
+    uint32_t m_slotStride;  //!< Bytes per slot, checked against the mapping
+};
+
+/**
+ * @brief Publishes the state of selected devices into a POSIX shared memory 
+ *        segment, so other processes can read it without opening the bus.
+ *        Run it in the process owning the bus; updates never wait for 
+ *        readers.
+ */
+class I2CSharedStatePublisher : public I2CSharedSegment, public I2CBusResult {
+  public:
+    I2CSharedStatePublisher(): m_used(0){};
+
+    /**
+     * @brief Create (or replace) the shared memory segment
+     * 
+     * @param name The segment name, e.g. "/i2c-state"
+     * @param slots The number of device slots
+     * @param dataBytes The maximum data bytes per slot
+     * @return bool False if the segment could not be created
+     */
+    bool create(const char* name, uint16_t slots, uint16_t dataBytes) {
+      uint32_t stride = sizeof(I2CSharedSlot) + ((dataBytes + 3u) & ~3u);
+      size_t size = sizeof(I2CSharedHeader) + (size_t)slots * stride;
+      if (!map(name, size, true)) return false;
+      I2CSharedHeader* h = new (m_base) I2CSharedHeader;
+      h->magic.store(0, std::memory_order_relaxed);
+      h->schema = I2CSharedHeader::SCHEMA_VERSION;
+      h->slotCount = slots;
+      h->dataBytes = dataBytes;
+      h->reserved = 0;
+      h->slotStride = stride;
+      m_slotCount = slots;
+      m_slotStride = stride;
+      for (uint16_t i = 0; i < slots; i++) {
+        I2CSharedSlot* s = new (slot(i)) I2CSharedSlot;
+        s->seq.store(0, std::memory_order_relaxed);
+        s->ready.store(0, std::memory_order_relaxed);
+        s->address = 0xFFFF;
+        s->bus = 0;
+        s->length = 0;
+        std::atomic<uint32_t>* w = words(i);
+        for (uint32_t k = 0; k < stride / 4 - sizeof(I2CSharedSlot) / 4; k++) {
+          new (&w[k]) std::atomic<uint32_t>(0);
+        }
+      }
+      m_used = 0;
+      h->magic.store(I2CSharedHeader::MAGIC, std::memory_order_release);
+      return true;
+    }
+
+    /**
+     * @brief Assign the next free slot to a device.  Readers do not see the 
+     *        slot until it is fully set up, devices may be added at any time.
+     * 
+     * @param address The device address
+     * @param length The number of data bytes published
+     * @param bus The bus number
+     * @return The slot index, or -1 if there is no free slot or the data is 
+     *         too long
+     */
+    int addDevice(uint16_t address, uint8_t length, uint8_t bus = 0) {
+      if (!m_base || m_used >= m_slotCount || length > header()->dataBytes) return -1;
+      I2CSharedSlot* s = slot(m_used);
+      s->bus = bus;
+      s->length = length;
+      s->address = address;
+      s->ready.store(1, std::memory_order_release);
+      return m_used++;
+    }
+
+    /**
+     * @brief Publish new data for a slot
+     * 
+     * @param index The slot index
+     * @param data The data, the slot length long
+     */
+    void publish(int index, const uint8_t* data) {
+      if (index < 0 || index >= m_used) return;
+      i2cSeqlockWrite(slot(index)->seq, words(index), data, slot(index)->length, 0);
+    }
+
+    /**
+     * @brief Publish a snapshot of a register cache
+     * 
+     * @param index The slot index
+     * @param cache The cache, holding at least the slot length
+     * @param offset The cache offset of the published data
+     */
+    template <size_t Size>
+    void publish(int index, const I2CRegisterCache<Size>& cache, size_t offset = 0) {
+      if (index < 0 || index >= m_used) return;
+      uint8_t data[Size];
+      if (cache.read(data, slot(index)->length, offset)) publish(index, data);
+    }
+
+    /**
+     * @brief Read registers from a device and publish them
+     * 
+     * @param index The slot index
+     * @param dev The device
+     * @param reg The first register, the slot length is read
+     * @return The I2C Bus result, nothing is published on failure
+     */
+    template <class Device>
+    uint8_t refresh(int index, Device& dev, typename Device::RegisterType reg) {
+      if (index < 0 || index >= m_used) return OTHER_ERROR;
+      uint8_t data[255];
+      uint8_t status = dev.readRegisters(reg, data, slot(index)->length);
+      if (status == SUCCESS) publish(index, data);
+      return status;
+    }
+
+    /**
+     * @brief Unmap the segment, optionally removing it
+     * 
+     * @param name The segment name to remove, or nullptr to keep it
+     */
+    void close(const char* name = nullptr) {
+      unmap();
+      if (name) shm_unlink(name);
+    }
+
+  protected:
+    uint16_t m_used; //!< Slots assigned
+};
+
+/**
+ * @brief Reads device state published by an I2CSharedStatePublisher.  
+ *        After open(), reads are plain memory accesses: no system calls and 
+ *        no bus transactions.
+ */
+class I2CSharedStateReader : public I2CSharedSegment {
+  public:
+    /**
+     * @brief Attempts of read() before it gives up on a slot that stays in 
+     *        the middle of an update, e.g. because the publisher died
+     */
+    static constexpr uint32_t MAX_TRIES = 10000;
+
+    /**
+     * @brief Map a published segment read-only.  The layout is checked 
+     *        against the mapping once and kept, so a publisher re-creating 
+     *        the segment cannot make later reads leave the mapping.
+     * 
+     * @param name The segment name
+     * @return bool False if the segment does not exist, is not ready or has 
+     *         another schema version
+     */
+    bool open(const char* name) {
+      if (!map(name, 0, false)) return false;
+      const I2CSharedHeader* h = header();
+      bool valid = m_size >= sizeof(I2CSharedHeader) && 
+                   h->magic.load(std::memory_order_acquire) == I2CSharedHeader::MAGIC &&
+                   h->schema == I2CSharedHeader::SCHEMA_VERSION;
+      uint16_t slots = valid ? h->slotCount : 0;
+      uint32_t stride = valid ? h->slotStride : 0;
+      valid = valid && stride >= sizeof(I2CSharedSlot) && stride % 4 == 0 &&
+              sizeof(I2CSharedHeader) + (size_t)slots * stride <= m_size;
+      if (!valid) {
+        unmap();
+        return false;
+      }
+      m_slotCount = slots;
+      m_slotStride = stride;
+      return true;
+    }
+
+    /**
+     * @brief Get the data length of a slot
+     * 
+     * @param index The slot index
+     * @return The number of data bytes, 0 if the slot is unused
+     */
+    inline uint8_t length(int index) const { return isReady(index) ? dataLength(index) : 0; }
+
+    /**
+     * @brief Copy a consistent snapshot of a slot
+     * 
+     * @param index The slot index
+     * @param out The output buffer, the slot length long
+     * @param version Set to the number of updates published, may be nullptr
+     * @return bool False if the slot index is invalid, the slot is unused, or 
+     *         no consistent snapshot was seen in MAX_TRIES attempts
+     */
+    bool read(int index, uint8_t* out, uint32_t* version = nullptr) const {
+      if (!isReady(index)) return false;
+      const I2CSharedSlot* s = slot(index);
+      for (uint32_t tries = 0; tries < MAX_TRIES; tries++) {
+        if (i2cSeqlockTryRead(s->seq, words(index), out, dataLength(index), 0, version)) return true;
+        if (tries >= 16) sched_yield();
+      }
+      return false;
+    }
+
+    /**
+     * @brief Unmap the segment
+     */
+    inline void close() { unmap(); }
+};
+#endif
+#endif /* I2C_SHARED_STATE_LIB_H_ */
@@ -0,0 +1,344 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CShmBus.h 
+//!  @brief I2CShmBus class definitions
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_SHM_BUS_LIB_H_
+#define I2C_SHM_BUS_LIB_H_
+
+#include "I2CSharedState.h"
+#include "I2CDevice.h"
+#include "I2CClock.h"
+
+#if defined(I2C_HAS_ATOMIC) && !defined(ARDUINO) && (defined(__unix__) || defined(__APPLE__))
+#include <sched.h>
+
+/**
+ * @brief A transfer request or response passed through an I2CShmRing
+ */
+struct I2CShmMessage {
+  static constexpr size_t DATA_BYTES = 256; //!< Maximum bytes written or read
+
+  uint32_t sequence;  //!< Request number, echoed in the response
+  uint16_t address;   //!< The device address
+  uint8_t flags;      //!< I2CTransfer flags
+  uint8_t status;     //!< The I2C Bus result (responses), SUCCESS in requests
+  uint16_t txLength;  //!< Bytes written, in data (requests)
+  uint16_t rxLength;  //!< Bytes to read (requests) or read (responses), in data
+  uint8_t data[DATA_BYTES]; //!< Written or read bytes
+};
+
+/**
+ * @brief Lock-free single-producer single-consumer ring of messages, placed 
+ *        in shared memory.  The indices sit on separate cache lines.
+ */
+struct I2CShmRing {
+  static constexpr uint32_t SLOTS = 16; //!< Ring size, a power of two
+
+  alignas(64) std::atomic<uint32_t> head;  //!< Next slot to write, producer only
+  alignas(64) std::atomic<uint32_t> tail;  //!< Next slot to read, consumer only
+  alignas(64) I2CShmMessage slots[SLOTS];  //!< The messages
+
+  void init() {
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Append a message (producer only)
+   * 
+   * @param msg The message
+   * @return bool False if the ring is full
+   */
+  bool push(const I2CShmMessage& msg) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= SLOTS) return false;
+    I2CShmMessage& slot = slots[h & (SLOTS - 1)];
+    memcpy(&slot, &msg, offsetof(I2CShmMessage, data));
+    size_t length = msg.txLength > msg.rxLength ? msg.txLength : msg.rxLength;
+    memcpy(slot.data, msg.data, length);
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Remove the oldest message (consumer only).  The ring is shared 
+   *        with another process, so a message with a length above 
+   *        DATA_BYTES is returned with its lengths clamped and its status 
+   *        set to DATA_TOO_LONG.
+   * 
+   * @param msg Set to the message
+   * @return bool False if the ring is empty
+   */
+  bool pop(I2CShmMessage& msg) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    const I2CShmMessage& slot = slots[t & (SLOTS - 1)];
+    memcpy(&msg, &slot, offsetof(I2CShmMessage, data));
+    if (msg.txLength > I2CShmMessage::DATA_BYTES || msg.rxLength > I2CShmMessage::DATA_BYTES) {
+      if (msg.txLength > I2CShmMessage::DATA_BYTES) msg.txLength = I2CShmMessage::DATA_BYTES;
+      if (msg.rxLength > I2CShmMessage::DATA_BYTES) msg.rxLength = I2CShmMessage::DATA_BYTES;
+      msg.status = I2CBusResult::DATA_TOO_LONG;
+    }
+    size_t length = msg.txLength > msg.rxLength ? msg.txLength : msg.rxLength;
+    memcpy(msg.data, slot.data, length);
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+};
+
+/**
+ * @brief Layout of a shared memory virtual bus segment
+ */
+struct I2CShmBusLayout {
+  static constexpr uint32_t MAGIC = 0x42533249UL; //!< "I2SB"
+  static constexpr uint32_t VERSION = 1;          //!< Layout version
+
+  std::atomic<uint32_t> magic;   //!< MAGIC, written last when the segment is ready
+  uint32_t version;              //!< VERSION
+  I2CShmRing requests;           //!< Client to server
+  I2CShmRing responses;          //!< Server to client
+};
+
+/**
+ * @brief Target side of a shared memory virtual bus: executes requests from 
+ *        an I2CShmBusClient in another process on a local bus, typically an 
+ *        I2CSimBus with the simulated devices attached.
+ */
+class I2CShmBusServer : protected I2CSharedSegment {
+  public:
+    using I2CSharedSegment::isOpen;
+
+    /**
+     * @brief Create (or replace) the virtual bus segment.  A replaced 
+     *        segment stays mapped by clients still attached to it: their 
+     *        transfers time out with OTHER_ERROR until they open() again.
+     * 
+     * @param name The segment name, e.g. "/i2c-vbus"
+     * @return bool False if the segment could not be created
+     */
+    bool create(const char* name) {
+      if (!map(name, sizeof(I2CShmBusLayout), true)) return false;
+      I2CShmBusLayout* l = new (m_base) I2CShmBusLayout;
+      l->magic.store(0, std::memory_order_relaxed);
+      l->version = I2CShmBusLayout::VERSION;
+      l->requests.init();
+      l->responses.init();
+      l->magic.store(I2CShmBusLayout::MAGIC, std::memory_order_release);
+      return true;
+    }
+
+    /**
+     * @brief Execute all waiting requests.  Requests that are too long are 
+     *        answered with DATA_TOO_LONG without reaching the bus.
+     * 
+     * @param bus The bus executing the requests
+     * @return size_t The number of requests executed
+     */
+    template <class Bus>
+    size_t serve(Bus& bus) {
+      if (!m_base) return 0;
+      I2CShmBusLayout* l = (I2CShmBusLayout*)m_base;
+      size_t served = 0;
+      while (l->requests.pop(m_msg)) {
+        if (m_msg.status == I2CBusResult::SUCCESS) {
+          uint8_t tx[I2CShmMessage::DATA_BYTES];
+          memcpy(tx, m_msg.data, m_msg.txLength);
+          I2CTransfer xfer(m_msg.address, tx, m_msg.txLength, m_msg.data, m_msg.rxLength);
+          xfer.flags = m_msg.flags;
+          m_msg.status = i2cTransfer(bus, xfer);
+          m_msg.rxLength = (uint16_t)xfer.rxCount;
+        }
+        else {
+          m_msg.rxLength = 0;
+        }
+        m_msg.txLength = 0;
+        while (!l->responses.push(m_msg)) sched_yield();
+        served++;
+      }
+      return served;
+    }
+
+    /**
+     * @brief Serve requests until stop is set
+     * 
+     * @param bus The bus executing the requests
+     * @param stop Polled between requests
+     */
+    template <class Bus>
+    void run(Bus& bus, const std::atomic<bool>& stop) {
+      while (!stop.load(std::memory_order_relaxed)) {
+        if (!serve(bus)) sched_yield();
+      }
+    }
+
+    /**
+     * @brief Unmap the segment, optionally removing it
+     * 
+     * @param name The segment name to remove, or nullptr to keep it
+     */
+    void close(const char* name = nullptr) {
+      unmap();
+      if (name) shm_unlink(name);
+    }
+
+  protected:
+    I2CShmMessage m_msg; //!< The message being handled
+};
+
+/**
+ * @brief Controller side of a shared memory virtual bus: a backend whose 
+ *        transfers are executed by an I2CShmBusServer in another process, 
+ *        so host-built firmware can talk to separately running device 
+ *        simulators.  One client per segment.
+ */
+class I2CShmBusClient : public I2CBackend, protected I2CSharedSegment {
+  public:
+    using I2CSharedSegment::isOpen;
+
+    I2CShmBusClient(): m_sequence(0), m_timeoutUs(1000000), 
+      m_spinUs(sysconf(_SC_NPROCESSORS_ONLN) > 1 ? 20 : 0){};
+
+    /**
+     * @brief Attach to a virtual bus created by a server
+     * 
+     * @param name The segment name
+     * @return bool False if the segment does not exist or is not ready
+     */
+    bool open(const char* name) {
+      if (!map(name, 0, true)) return false;
+      I2CShmBusLayout* l = (I2CShmBusLayout*)m_base;
+      if (m_size < sizeof(I2CShmBusLayout) || 
+          l->magic.load(std::memory_order_acquire) != I2CShmBusLayout::MAGIC ||
+          l->version != I2CShmBusLayout::VERSION) {
+        unmap();
+        return false;
+      }
+      return true;
+    }
+
+    /**
+     * @brief Detach from the virtual bus
+     */
+    inline void close() { unmap(); }
+
+    /**
+     * @brief Set how long a transfer waits for the server
+     * 
+     * @param us The timeout in microseconds
+     */
+    inline void setTimeout(uint32_t us) { m_timeoutUs = us; }
+
+    /**
+     * @brief Set how long a transfer busy-waits before yielding the CPU.  
+     *        Spinning lowers the latency when the server runs on another 
+     *        core, but only delays it on a single core, where it is 0.
+     * 
+     * @param us The spin time in microseconds
+     */
+    inline void setSpin(uint32_t us) { m_spinUs = us; }
+
+    uint8_t transfer(I2CTransfer& xfer) override {
+      xfer.rxCount = 0;
+      if (!m_base) return xfer.status = OTHER_ERROR;
+      if (xfer.txLength > I2CShmMessage::DATA_BYTES || xfer.rxLength > I2CShmMessage::DATA_BYTES) {
+        return xfer.status = DATA_TOO_LONG;
+      }
+      I2CShmBusLayout* l = (I2CShmBusLayout*)m_base;
+      m_msg.sequence = ++m_sequence;
+      m_msg.address = xfer.address;
+      m_msg.flags = xfer.flags;
+      m_msg.status = SUCCESS;
+      m_msg.txLength = (uint16_t)xfer.txLength;
+      m_msg.rxLength = (uint16_t)xfer.rxLength;
+      if (xfer.txLength) memcpy(m_msg.data, xfer.txData, xfer.txLength);
+      I2CSteadyClock clock;
+      uint32_t start = clock.nowUs();
+      while (!l->requests.push(m_msg)) {
+        if (!wait(clock, start)) return xfer.status = OTHER_ERROR;
+      }
+      for (;;) {
+        if (l->responses.pop(m_msg)) {
+          if (m_msg.sequence != m_sequence) continue;
+          size_t count = m_msg.rxLength < xfer.rxLength ? m_msg.rxLength : xfer.rxLength;
+          if (count) memcpy(xfer.rxData, m_msg.data, count);
+          xfer.rxCount = count;
+          return xfer.status = m_msg.status;
+        }
+        if (!wait(clock, start)) return xfer.status = OTHER_ERROR;
+      }
+    }
+
+  protected:
+    /**
+     * @brief Spin briefly, then yield, until the timeout
+     */
+    bool wait(const I2CSteadyClock& clock, uint32_t start) {
+      uint32_t elapsed = clock.nowUs() - start;
+      if (elapsed >= m_timeoutUs) return false;
+      if (elapsed >= m_spinUs) sched_yield();
+      return true;
+    }
+
+    uint32_t m_sequence;   //!< Number of the last request
+    uint32_t m_timeoutUs;  //!< Time to wait for the server
+    uint32_t m_spinUs;     //!< Time to busy-wait before yielding
+    I2CShmMessage m_msg;   //!< The message being sent or received
+};
+#endif
+#endif /* I2C_SHM_BUS_LIB_H_ */
@@ -0,0 +1,786 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CSimBus.h 
+//!  @brief Host-side I2C bus simulator
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_SIM_BUS_LIB_H_
+#define I2C_SIM_BUS_LIB_H_
+
+#include "I2CBackend.h"
+#include "I2CTiming.h"
+
+/**
+ * @brief Base class for simulated I2C target devices.  Override the 
+ *        callbacks to model a chip.
+ */
+class I2CSimTarget {
+  public:
+    I2CSimTarget(uint16_t address = 0x0, bool tenBit = false): 
+      next(nullptr), m_address(address), m_tenBit(tenBit), m_upstream(nullptr),
+      m_channel(0), m_stretchNs(0){};
+
+    /**
+     * @brief Get the simulated device address
+     * 
+     * @return The 7-bit (or 10-bit) I2C device address
+     */
+    inline uint16_t getAddress() const { return m_address; }
+
+    /**
+     * @brief Check if the device uses a 10-bit address
+     * 
+     * @return bool 
+     */
+    inline bool isTenBit() const { return m_tenBit; }
+
+    /**
+     * @brief Change the simulated device address
+     * 
+     * @param address The new 7-bit (or 10-bit) I2C device address
+     */
+    inline void setAddress(uint16_t address) { m_address = address; }
+
+    /**
+     * @brief Check if the device responds to an address.  Override to add 
+     *        broadcast or secondary addresses.
+     * 
+     * @param address The 7-bit (or 10-bit) I2C address on the bus
+     * @param tenBit True if address is a 10-bit address
+     * @return bool 
+     */
+    virtual bool matches(uint16_t address, bool tenBit) const {
+      return address == m_address && tenBit == m_tenBit;
+    }
+
+    /**
+     * @brief Check if the device listens to general call writes (address 0)
+     * 
+     * @return bool 
+     */
+    virtual bool acceptsGeneralCall() const { return false; }
+
+    /**
+     * @brief Check if a downstream channel is connected (multiplexers)
+     * 
+     * @param channel The channel
+     * @return bool 
+     */
+    virtual bool channelEnabled(uint8_t channel) const { (void)channel; return false; }
+
+    /**
+     * @brief Get the clock stretching the device adds to a transaction
+     * 
+     * @return The extra time in nanoseconds
+     */
+    virtual uint32_t stretchNs() { return m_stretchNs; }
+
+    /**
+     * @brief Set a fixed clock stretching time per transaction
+     * 
+     * @param ns The extra time in nanoseconds
+     */
+    inline void setStretch(uint32_t ns) { m_stretchNs = ns; }
+
+    /**
+     * @brief Place the device behind a multiplexer channel
+     * 
+     * @param mux The simulated multiplexer, or nullptr for the bus itself
+     * @param channel The multiplexer channel
+     */
+    inline void setUpstream(const I2CSimTarget* mux, uint8_t channel) {
+      m_upstream = mux;
+      m_channel = channel;
+    }
+
+    /**
+     * @brief Check if the device is currently reachable from the bus, i.e. 
+     *        all multiplexer channels on its path are enabled
+     * 
+     * @return bool 
+     */
+    bool isConnected() const {
+      return !m_upstream || 
+             (m_upstream->isConnected() && m_upstream->channelEnabled(m_channel));
+    }
+
+    /**
+     * @brief Called on (repeated) start when the device is addressed
+     * 
+     * @param read True for a read, false for a write
+     * @return bool True to ACK the address
+     */
+    virtual bool onStart(bool read) { (void)read; return true; }
+
+    /**
+     * @brief Called for each byte written to the device
+     * 
+     * @param data The data byte
+     * @return bool True to ACK the byte
+     */
+    virtual bool onWrite(uint8_t data) { (void)data; return true; }
+
+    /**
+     * @brief Called for each byte read from the device
+     * 
+     * @return The data byte to return
+     */
+    virtual uint8_t onRead() { return 0xFF; }
+
+    /**
+     * @brief Called on a stop condition that ends a transaction with 
+     *        the device.
+     */
+    virtual void onStop() {}
+
+    I2CSimTarget* next; //!< Next target on the simulated bus
+  protected:
+    uint16_t m_address; //!< The 7-bit (or 10-bit) device address
+    bool m_tenBit;      //!< The device uses a 10-bit address
+    const I2CSimTarget* m_upstream; //!< The multiplexer the device is behind
+    uint8_t m_channel;  //!< The multiplexer channel the device is on
+    uint32_t m_stretchNs; //!< Clock stretching per transaction
+};
+
+/**
+ * @brief Simulated TCA9548A style multiplexer.  Devices placed behind it 
+ *        with setUpstream() are only reachable while their channel is 
+ *        enabled.
+ */
+class I2CSimMuxTarget : public I2CSimTarget {
+  public:
+    I2CSimMuxTarget(uint8_t address = 0x70): I2CSimTarget(address), m_mask(0){};
+
+    bool onWrite(uint8_t data) override { m_mask = data; return true; }
+    uint8_t onRead() override { return m_mask; }
+    bool channelEnabled(uint8_t channel) const override { 
+      return (m_mask >> channel) & 0x01; 
+    }
+
+  protected:
+    uint8_t m_mask; //!< The enabled channels
+};
+
+/**
+ * @brief Simulated memory or register file device (EEPROM, FRAM, sensor 
+ *        registers).  The first bytes of a write set the address pointer, 
+ *        following bytes are stored.  Reads and writes auto-increment.
+ */
+class I2CSimMemoryTarget : public I2CSimTarget {
+  public:
+    /**
+     * @brief Construct a simulated memory device
+     * 
+     * @param address The 7-bit (or 10-bit) I2C device address
+     * @param memory The backing memory
+     * @param size The size of the backing memory in bytes
+     * @param pointerBytes The number of address pointer bytes (big-endian)
+     * @param tenBit True if address is a 10-bit address
+     */
+    I2CSimMemoryTarget(uint16_t address, uint8_t* memory, size_t size, 
+                       uint8_t pointerBytes = 1, bool tenBit = false):
+      I2CSimTarget(address, tenBit), m_memory(memory), m_size(size), 
+      m_pointerBytes(pointerBytes), m_pointer(0), m_received(0){};
+
+    bool onStart(bool read) override {
+      if (!read) m_received = 0;
+      return true;
+    }
+
+    bool onWrite(uint8_t data) override {
+      if (m_received < m_pointerBytes) {
+        m_pointer = (m_received == 0) ? data : ((m_pointer << 8) | data);
+        m_received++;
+        if (m_received == m_pointerBytes) m_pointer %= m_size;
+        return true;
+      }
+      m_memory[m_pointer] = data;
+      m_pointer = (m_pointer + 1) % m_size;
+      return true;
+    }
+
+    uint8_t onRead() override {
+      uint8_t data = m_memory[m_pointer];
+      m_pointer = (m_pointer + 1) % m_size;
+      return data;
+    }
+
+    /**
+     * @brief Get the current address pointer
+     * 
+     * @return uint32_t 
+     */
+    inline uint32_t getPointer() const { return m_pointer; }
+
+  protected:
+    uint8_t* m_memory;       //!< The backing memory
+    size_t m_size;           //!< The size of the backing memory
+    uint8_t m_pointerBytes;  //!< The number of address pointer bytes
+    uint32_t m_pointer;      //!< The address pointer
+    uint8_t m_received;      //!< Pointer bytes received in this write
+};
+
+/**
+ * @brief Simulated bus statistics
+ */
+struct I2CSimStats {
+  uint32_t transfers; //!< Transactions executed
+  uint32_t nacks;     //!< Transactions ended by a NACK
+  uint32_t highSpeed; //!< Transactions run in high-speed mode
+  uint64_t busyNs;    //!< Total bus time used by transactions
+  uint32_t arbitrationLost; //!< Transactions that lost arbitration
+  uint64_t waitNs;    //!< Time spent waiting for another controller's transaction
+};
+
+/**
+ * @brief Statistics of a simulated competing controller
+ */
+struct I2CSimMasterStats {
+  uint32_t transfers;       //!< Transactions completed
+  uint32_t arbitrationLost; //!< Transactions that lost arbitration and were retried
+  uint64_t waitNs;          //!< Time spent waiting for the bus
+};
+
+/**
+ * @brief A second controller on a simulated bus, for multi-master 
+ *        simulation.  It writes the same bytes to one address every period 
+ *        (plus a random jitter), waits while the bus is busy and retries 
+ *        right after a lost arbitration.  Its writes occupy the bus but are 
+ *        not delivered to the simulated devices.
+ */
+class I2CSimMaster {
+  public:
+    /**
+     * @brief Construct a simulated controller
+     * 
+     * @param address The 7-bit address written to
+     * @param data The bytes written
+     * @param length The number of bytes written
+     * @param periodNs The time between transaction starts
+     * @param jitterNs The maximum random delay added to each period
+     * @param seed The random seed (not 0)
+     */
+    I2CSimMaster(uint8_t address, const uint8_t* data, size_t length, 
+                 uint32_t periodNs, uint32_t jitterNs = 0, uint32_t seed = 1):
+      m_address(address), m_data(data), m_length(length), m_periodNs(periodNs),
+      m_jitterNs(jitterNs), m_seed(seed ? seed : 1), m_start(0), m_planned(0), 
+      m_stats(){};
+
+    /**
+     * @brief Get the start time of the next (or current) transaction
+     * 
+     * @return The time in nanoseconds
+     */
+    inline uint64_t getStart() const { return m_start; }
+
+    /**
+     * @brief Get the wire time of a transaction
+     * 
+     * @param clock The SCL frequency in Hz
+     * @return The duration in nanoseconds
+     */
+    inline uint32_t durationNs(uint32_t clock) const {
+      return I2CTiming::transferNs(clock, 1, m_length, 0);
+    }
+
+    /**
+     * @brief Get a byte of the controller's transaction, as sent on SDA
+     * 
+     * @param index The byte index, 0 for the address byte
+     * @return The byte, or -1 past the end of the transaction
+     */
+    inline int16_t byteAt(size_t index) const {
+      if (index == 0) return (int16_t)(m_address << 1);
+      return index <= m_length ? m_data[index - 1] : -1;
+    }
+
+    /**
+     * @brief Complete the current transaction and plan the next one
+     * 
+     * @param end The time the current transaction ended
+     */
+    void complete(uint64_t end) {
+      m_stats.transfers++;
+      m_stats.waitNs += m_start - m_planned;
+      m_seed ^= m_seed << 13;
+      m_seed ^= m_seed >> 17;
+      m_seed ^= m_seed << 5;
+      m_planned += m_periodNs + (m_jitterNs ? m_seed % m_jitterNs : 0);
+      m_start = m_planned > end ? m_planned : end;
+      if (m_planned < end) m_planned = end;
+    }
+
+    /**
+     * @brief Delay the current transaction until the bus is free
+     * 
+     * @param end The time the bus is free
+     * @param lost True if the controller lost arbitration
+     */
+    inline void defer(uint64_t end, bool lost) {
+      if (lost) m_stats.arbitrationLost++;
+      if (m_start < end) m_start = end;
+    }
+
+    /**
+     * @brief Get the controller statistics
+     * 
+     * @return const I2CSimMasterStats& 
+     */
+    inline const I2CSimMasterStats& getStats() const { return m_stats; }
+
+  protected:
+    uint8_t m_address;        //!< The address written to
+    const uint8_t* m_data;    //!< The bytes written
+    size_t m_length;          //!< The number of bytes written
+    uint32_t m_periodNs;      //!< The time between transactions
+    uint32_t m_jitterNs;      //!< The maximum random delay
+    uint32_t m_seed;          //!< The random state
+    uint64_t m_start;         //!< Start of the current transaction
+    uint64_t m_planned;       //!< Planned start of the current transaction
+    I2CSimMasterStats m_stats; //!< Statistics
+};
+
+/**
+ * @brief Host-side I2C bus simulator.  Executes transfers against attached
+ *        I2CSimTarget objects and advances a simulated clock by the wire 
+ *        time of every transaction (see I2CTiming).
+ */
+class I2CSimBus : public I2CBackend {
+  public:
+    I2CSimBus(): m_targets(nullptr), m_selected10(nullptr), m_contender(nullptr), 
+      m_now(0), m_stretch(0), m_held(false), m_open(nullptr), m_openBroadcast(false),
+      m_openAddress(0), m_stats(){};
+
+    /**
+     * @brief Attach a simulated device to the bus
+     * 
+     * @param target The simulated device
+     */
+    void attach(I2CSimTarget& target) {
+      target.next = m_targets;
+      m_targets = &target;
+    }
+
+    /**
+     * @brief Remove a simulated device from the bus
+     * 
+     * @param target The simulated device
+     */
+    void detach(I2CSimTarget& target) {
+      for (I2CSimTarget** p = &m_targets; *p; p = &(*p)->next) {
+        if (*p == &target) {
+          *p = target.next;
+          target.next = nullptr;
+          return;
+        }
+      }
+    }
+
+    /**
+     * @brief Add a competing controller.  Transfers that start within one 
+     *        SCL period of the controller's transaction arbitrate with it 
+     *        bit by bit; transfers starting while it holds the bus wait.
+     * 
+     * @param master The simulated controller, or nullptr to remove it
+     */
+    inline void setContender(I2CSimMaster* master) { m_contender = master; }
+
+    /**
+     * @brief Find the device responding to an address
+     * 
+     * @param address The 7-bit (or 10-bit) I2C device address
+     * @param tenBit True if address is a 10-bit address
+     * @return I2CSimTarget* The device or nullptr if none is attached
+     */
+    I2CSimTarget* find(uint16_t address, bool tenBit = false) const {
+      for (I2CSimTarget* t = m_targets; t; t = t->next) {
+        if (t->isConnected() && t->matches(address, tenBit)) return t;
+      }
+      return nullptr;
+    }
+
+    /**
+     * @brief Check if a 10-bit address prefix matches any attached device
+     * 
+     * @param prefix The 7-bit prefix 11110XX
+     * @return bool 
+     */
+    bool hasTenBitPrefix(uint8_t prefix) const {
+      for (I2CSimTarget* t = m_targets; t; t = t->next) {
+        if (t->isTenBit() && ((t->getAddress() >> 8) & 0x03) == (prefix & 0x03)) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /**
+     * @brief Get the 10-bit device that was last selected by a full 
+     *        address phase.  A read addressed with only the 10-bit prefix 
+     *        goes to this device.
+     * 
+     * @return I2CSimTarget* 
+     */
+    inline I2CSimTarget* getSelectedTenBit() const { return m_selected10; }
+
+    /**
+     * @brief Record the 10-bit device selected by a full address phase
+     * 
+     * @param target The selected device or nullptr
+     */
+    inline void setSelectedTenBit(I2CSimTarget* target) { m_selected10 = target; }
+
+    /**
+     * @brief Execute a transfer without advancing the simulated clock
+     * 
+     * @param xfer The transfer to execute
+     * @param durationNs Set to the wire time of the transfer
+     * @return The I2C Bus result
+     */
+    uint8_t execute(I2CTransfer& xfer, uint32_t& durationNs) {
+      size_t written = 0;
+      size_t read = 0;
+      uint8_t addressBytes = 1;
+      m_stretch = 0;
+      m_open = nullptr;
+      m_openBroadcast = false;
+      uint8_t status = run(xfer, written, read, addressBytes);
+      xfer.rxCount = read;
+      bool stop = !(xfer.flags & I2CTransfer::NO_STOP) || status != SUCCESS;
+      if (xfer.flags & I2CTransfer::HIGH_SPEED) {
+        durationNs = I2CTiming::highSpeedNs(getClock(), m_hsClock, !m_hsActive,
+                                            addressBytes, written, read, stop);
+        m_hsActive = !stop;
+        m_stats.highSpeed++;
+      }
+      else durationNs = I2CTiming::transferNs(getClock(), addressBytes, written, read);
+      durationNs += m_stretch;
+      m_stats.transfers++;
+      m_stats.busyNs += durationNs;
+      if (status == NACK_ON_ADDRESS || status == NACK_ON_DATA) m_stats.nacks++;
+      return status;
+    }
+
+    bool supportsHighSpeed() const override { return true; }
+
+    /**
+     * @brief End a session kept open with NO_STOP (or in high-speed mode): 
+     *        send the stop to the devices still addressed and let the 
+     *        competing controller contend for the bus again.
+     */
+    void releaseBus() override {
+      if (m_hsActive) m_now += I2CTiming::periodsToNs(1, m_hsClock);
+      if (m_openBroadcast) stopListeners(m_openAddress);
+      else if (m_open) m_open->onStop();
+      m_open = nullptr;
+      m_openBroadcast = false;
+      m_held = false;
+      I2CBackend::releaseBus();
+    }
+
+    uint8_t transfer(I2CTransfer& xfer) override {
+      if (m_contender && !m_held && !m_hsActive && contend(xfer) != SUCCESS) {
+        xfer.rxCount = 0;
+        xfer.status = ARBITRATION_LOST;
+        return xfer.status;
+      }
+      uint32_t ns;
+      xfer.status = execute(xfer, ns);
+      m_now += ns;
+      m_held = xfer.status == SUCCESS && (xfer.flags & I2CTransfer::NO_STOP);
+      if (m_contender) m_contender->defer(m_now, false);
+      return xfer.status;
+    }
+
+    /**
+     * @brief Get the simulated time
+     * 
+     * @return The simulated time in nanoseconds
+     */
+    inline uint64_t now() const { return m_now; }
+
+    /**
+     * @brief Advance the simulated time, e.g. to model CPU work between 
+     *        transactions.
+     * 
+     * @param ns The time to advance in nanoseconds
+     */
+    inline void advance(uint64_t ns) { m_now += ns; }
+
+    /**
+     * @brief Get the simulated bus statistics
+     * 
+     * @return const I2CSimStats& 
+     */
+    inline const I2CSimStats& getStats() const { return m_stats; }
+
+  protected:
+    /**
+     * @brief Resolve bus access against the competing controller: wait 
+     *        while it holds the bus, arbitrate on a simultaneous start
+     * 
+     * @return SUCCESS if the transfer may run now, ARBITRATION_LOST otherwise
+     */
+    uint8_t contend(const I2CTransfer& xfer) {
+      I2CSimMaster& c = *m_contender;
+      uint32_t window = I2CTiming::periodsToNs(1, getClock());
+      for (;;) {
+        uint64_t end = c.getStart() + c.durationNs(getClock());
+        if (end <= m_now) {
+          c.complete(end);
+          continue;
+        }
+        if (c.getStart() + window <= m_now) {
+          m_stats.waitNs += end - m_now;
+          m_now = end;
+          continue;
+        }
+        if (c.getStart() >= m_now + window) return SUCCESS;
+        uint32_t lostAt = arbitrate(xfer, c);
+        if (!lostAt) {
+          c.defer(m_now, true);
+          return SUCCESS;
+        }
+        m_now += I2CTiming::periodsToNs(lostAt, getClock());
+        m_stats.arbitrationLost++;
+        return ARBITRATION_LOST;
+      }
+    }
+
+    /**
+     * @brief Compare the bits of a transfer with the competing controller's
+     * 
+     * @return 0 if the transfer wins, otherwise the SCL periods until it 
+     *         loses (the start condition, then 9 per byte)
+     */
+    uint32_t arbitrate(const I2CTransfer& xfer, const I2CSimMaster& c) const {
+      bool tenBit = (xfer.flags & I2CTransfer::TEN_BIT) != 0;
+      uint8_t first = tenBit ? (uint8_t)(0xF0 | ((xfer.address >> 7) & 0x06)) :
+                               (uint8_t)(xfer.address << 1);
+      if (!tenBit && xfer.txLength == 0 && xfer.rxLength > 0) first |= 0x01;
+      size_t length = 1 + (tenBit ? 1 : 0) + xfer.txLength;
+      for (size_t i = 0; i < length; i++) {
+        int16_t theirs = c.byteAt(i);
+        if (theirs < 0) return 0;
+        uint8_t ours;
+        if (i == 0) ours = first;
+        else if (tenBit && i == 1) ours = (uint8_t)xfer.address;
+        else ours = xfer.txData[i - (tenBit ? 2 : 1)];
+        uint8_t diff = ours ^ (uint8_t)theirs;
+        if (!diff) continue;
+        uint8_t bit = 0;
+        while (!(diff & (0x80 >> bit))) bit++;
+        if (!(ours & (0x80 >> bit))) return 0;
+        return 1 + 9 * (uint32_t)i + bit + 1;
+      }
+      return 0;
+    }
+
+    uint8_t run(I2CTransfer& xfer, size_t& written, size_t& read, 
+                uint8_t& addressBytes) {
+      const uint8_t* tx = xfer.txData;
+      size_t txLength = xfer.txLength;
+      bool tenBit = (xfer.flags & I2CTransfer::TEN_BIT) != 0;
+      uint16_t address = xfer.address;
+      if (!tenBit && (address & 0x7C) == 0x78) {
+        // 10-bit address phase sent as a 7-bit prefix plus a data byte
+        if (txLength == 0) return runPrefixRead(xfer, read);
+        tenBit = true;
+        address = (uint16_t)(((address & 0x03) << 8) | tx[0]);
+        tx++;
+        txLength--;
+      }
+      if (tenBit) addressBytes = 2;
+      else if (xfer.rxLength == 0 && (address == 0 || listeners(address) >= 1)) {
+        return runBroadcast(xfer, address, written);
+      }
+      I2CSimTarget* target = find(address, tenBit);
+      if (tenBit) m_selected10 = target;
+      bool writePhase = (txLength > 0) || (xfer.rxLength == 0) || tenBit;
+      if (writePhase) {
+        if (!target || !target->onStart(false)) return NACK_ON_ADDRESS;
+        for (size_t i = 0; i < txLength; i++) {
+          written++;
+          if (!target->onWrite(tx[i])) {
+            target->onStop();
+            return NACK_ON_DATA;
+          }
+        }
+      }
+      return runRead(xfer, target, read);
+    }
+
+    /**
+     * @brief Count the devices listening to a 7-bit write address
+     */
+    uint8_t listeners(uint16_t address) const {
+      uint8_t count = 0;
+      for (I2CSimTarget* t = m_targets; t; t = t->next) {
+        if (t->isConnected() && 
+            (address == 0 ? t->acceptsGeneralCall() : t->matches(address, false))) count++;
+      }
+      return count;
+    }
+
+    /**
+     * @brief Deliver a write to every listening device (general call or a 
+     *        shared broadcast address).  Bytes are ACKed if any device ACKs, 
+     *        the slowest device sets the clock stretching.
+     */
+    uint8_t runBroadcast(I2CTransfer& xfer, uint16_t address, size_t& written) {
+      bool acked = false;
+      for (I2CSimTarget* t = m_targets; t; t = t->next) {
+        if (t->isConnected() && 
+            (address == 0 ? t->acceptsGeneralCall() : t->matches(address, false))) {
+          acked |= t->onStart(false);
+          uint32_t stretch = t->stretchNs();
+          if (stretch > m_stretch) m_stretch = stretch;
+        }
+      }
+      if (!acked) return NACK_ON_ADDRESS;
+      uint8_t status = SUCCESS;
+      while (written < xfer.txLength && status == SUCCESS) {
+        uint8_t data = xfer.txData[written++];
+        acked = false;
+        for (I2CSimTarget* t = m_targets; t; t = t->next) {
+          if (t->isConnected() && 
+            (address == 0 ? t->acceptsGeneralCall() : t->matches(address, false))) {
+            acked |= t->onWrite(data);
+          }
+        }
+        if (!acked) status = NACK_ON_DATA;
+      }
+      if (status == SUCCESS && (xfer.flags & I2CTransfer::NO_STOP)) {
+        m_openBroadcast = true;
+        m_openAddress = address;
+        return status;
+      }
+      stopListeners(address);
+      return status;
+    }
+
+    /**
+     * @brief Send a stop to every device listening to a 7-bit write address
+     */
+    void stopListeners(uint16_t address) {
+      for (I2CSimTarget* t = m_targets; t; t = t->next) {
+        if (t->isConnected() && 
+            (address == 0 ? t->acceptsGeneralCall() : t->matches(address, false))) {
+          t->onStop();
+        }
+      }
+    }
+
+    uint8_t runPrefixRead(I2CTransfer& xfer, size_t& read) {
+      I2CSimTarget* target = m_selected10;
+      if (target && ((target->getAddress() >> 8) & 0x03) != (xfer.address & 0x03)) {
+        target = nullptr;
+      }
+      return runRead(xfer, target, read);
+    }
+
+    uint8_t runRead(I2CTransfer& xfer, I2CSimTarget* target, size_t& read) {
+      if (!target) return NACK_ON_ADDRESS;
+      m_stretch = target->stretchNs();
+      if (xfer.rxLength > 0) {
+        if (!target->onStart(true)) return NACK_ON_ADDRESS;
+        while (read < xfer.rxLength) xfer.rxData[read++] = target->onRead();
+      }
+      if (xfer.flags & I2CTransfer::NO_STOP) m_open = target;
+      else target->onStop();
+      return SUCCESS;
+    }
+
+    I2CSimTarget* m_targets; //!< The attached simulated devices
+    I2CSimTarget* m_selected10; //!< The last 10-bit device selected
+    I2CSimMaster* m_contender; //!< The competing controller, or nullptr
+    uint64_t m_now;          //!< The simulated time in nanoseconds
+    uint32_t m_stretch;      //!< Clock stretching of the current transfer
+    bool m_held;             //!< The last transfer kept the bus (NO_STOP)
+    I2CSimTarget* m_open;    //!< The device addressed by a held transfer
+    bool m_openBroadcast;    //!< The held transfer was a broadcast write
+    uint16_t m_openAddress;  //!< The address of a held broadcast write
+    I2CSimStats m_stats;     //!< Simulated bus statistics
+};
+
+/**
+ * @brief Time source running on the simulated time of an I2CSimBus.  Has 
+ *        the same interface as I2CArduinoClock, delays advance the 
+ *        simulated time.
+ */
+class I2CSimClock {
+  public:
+    I2CSimClock(I2CSimBus& bus): m_bus(&bus){};
+
+    /**
+     * @brief Get the simulated time
+     * 
+     * @return The time in microseconds
+     */
+    inline uint32_t nowUs() const { return (uint32_t)(m_bus->now() / 1000); }
+
+    /**
+     * @brief Advance the simulated time
+     * 
+     * @param us The time to wait in microseconds
+     */
+    inline void delayUs(uint32_t us) const { m_bus->advance((uint64_t)us * 1000); }
+
+  protected:
+    I2CSimBus* m_bus; //!< The simulated bus providing the time
+};
+#endif /* I2C_SIM_BUS_LIB_H_ */
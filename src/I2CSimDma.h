@@ -0,0 +1,148 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CSimDma.h 
+//!  @brief Host-side simulation of a DMA I2C backend
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_SIM_DMA_LIB_H_
+#define I2C_SIM_DMA_LIB_H_
+
+#include "I2CDmaBackend.h"
+#include "I2CSimBus.h"
+
+/**
+ * @brief Simulated DMA engine on top of an I2CSimBus.
+ * 
+ *        dmaStart() runs the transaction against the simulated devices and 
+ *        schedules the completion interrupt for when the transaction would 
+ *        have finished on the wire.  advance() moves simulated time forward 
+ *        and delivers the interrupt.  CPU time is modelled as a fixed setup 
+ *        cost per transfer plus a fixed interrupt cost, independent of the 
+ *        transfer length.
+ */
+class I2CSimDmaBackend : public I2CDmaBackend {
+  public:
+    /**
+     * @brief Construct a simulated DMA backend
+     * 
+     * @param bus The simulated bus the devices are attached to
+     * @param setupNs Modelled CPU time to program a transfer
+     * @param interruptNs Modelled CPU time of the completion interrupt
+     */
+    I2CSimDmaBackend(I2CSimBus& bus, uint32_t setupNs = 2000, 
+                     uint32_t interruptNs = 1000):
+      m_bus(bus), m_setupNs(setupNs), m_interruptNs(interruptNs),
+      m_doneAt(0), m_result(SUCCESS), m_rxCount(0), m_cpuNs(0){};
+
+    void setClock(uint32_t frequency) override {
+      I2CBackend::setClock(frequency);
+      m_bus.setClock(frequency);
+    }
+
+    /**
+     * @brief Advance simulated time, delivering the completion interrupt if
+     *        the active transfer finishes.
+     * 
+     * @param ns The time to advance in nanoseconds
+     */
+    void advance(uint64_t ns) {
+      m_bus.advance(ns);
+      if (m_active && m_bus.now() >= m_doneAt) {
+        m_cpuNs += m_interruptNs;
+        handleCompletion(m_result, m_rxCount);
+      }
+    }
+
+    /**
+     * @brief Get the modelled CPU time spent on transfers
+     * 
+     * @return The CPU time in nanoseconds
+     */
+    inline uint64_t getCpuNs() const { return m_cpuNs; }
+
+    /**
+     * @brief Get the simulated bus
+     * 
+     * @return I2CSimBus& 
+     */
+    inline I2CSimBus& getBus() const { return m_bus; }
+
+  protected:
+    bool dmaStart(I2CTransfer& xfer) override {
+      uint32_t ns;
+      uint8_t status = m_bus.execute(xfer, ns);
+      m_result = status;
+      m_rxCount = xfer.rxCount;
+      m_doneAt = m_bus.now() + ns;
+      m_cpuNs += m_setupNs;
+      return true;
+    }
+
+    void waitForCompletion() override {
+      uint64_t now = m_bus.now();
+      advance(m_doneAt > now ? m_doneAt - now : 0);
+    }
+
+    I2CSimBus& m_bus;       //!< The simulated bus
+    uint32_t m_setupNs;     //!< Modelled CPU time per transfer setup
+    uint32_t m_interruptNs; //!< Modelled CPU time per completion interrupt
+    uint64_t m_doneAt;      //!< Simulated completion time of the active transfer
+    uint8_t m_result;       //!< Result delivered with the completion interrupt
+    size_t m_rxCount;       //!< Bytes received delivered with the interrupt
+    uint64_t m_cpuNs;       //!< Modelled CPU time spent on transfers
+};
+#endif /* I2C_SIM_DMA_LIB_H_ */
@@ -0,0 +1,317 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CSimPins.h 
+//!  @brief Host-side simulated SDA/SCL lines for the software I2C backend
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_SIM_PINS_LIB_H_
+#define I2C_SIM_PINS_LIB_H_
+
+#include "I2CSimBus.h"
+
+/**
+ * @brief Bit-level model of the SDA and SCL lines of an I2CSimBus.
+ * 
+ *        The lines are wired-AND between the master (driven through the 
+ *        I2CSoftBackend pin policy interface) and a bit-level target 
+ *        decoder that detects start/stop conditions, shifts bytes and 
+ *        drives ACK and read bits for the I2CSimTarget objects attached to 
+ *        the bus.  Waiting advances the simulated bus time, so the achieved
+ *        bit rate can be measured.  Optionally the addressed device 
+ *        stretches the clock after every ACK.
+ * 
+ *        Use as I2CSoftBackend<I2CSimPinsRef>.
+ */
+class I2CSimPins {
+  public:
+    I2CSimPins(I2CSimBus& bus):
+      m_bus(bus), m_masterSda(true), m_masterScl(true), m_slaveSda(true),
+      m_sda(true), m_scl(true), m_state(IDLE), m_shift(0), m_bits(0), m_prefix(0),
+      m_read(false), m_masterAck(false), m_target(nullptr), 
+      m_stretchNs(0), m_holdUntil(0), m_clocks(0), m_errors(0){};
+
+    inline void begin() {
+      m_masterSda = true;
+      m_masterScl = true;
+      update();
+    }
+    inline void sdaLow() { m_masterSda = false; update(); }
+    inline void sdaRelease() { m_masterSda = true; update(); }
+    inline bool sdaRead() { return m_sda; }
+    inline void sclLow() { m_masterScl = false; update(); }
+    inline void sclRelease() { m_masterScl = true; update(); }
+    inline bool sclRead() { return m_scl; }
+    inline void wait(uint32_t ns) { m_bus.advance(ns); update(); }
+
+    /**
+     * @brief Make the addressed device stretch the clock after every ACK
+     * 
+     * @param ns The stretching time in nanoseconds, 0 to disable
+     */
+    inline void setStretch(uint32_t ns) { m_stretchNs = ns; }
+
+    /**
+     * @brief Get the number of SCL clock pulses seen on the bus
+     * 
+     * @return uint32_t 
+     */
+    inline uint32_t getClocks() const { return m_clocks; }
+
+    /**
+     * @brief Get the number of protocol violations detected by the decoder
+     *        (e.g. a stop in the middle of a byte).
+     * 
+     * @return uint32_t 
+     */
+    inline uint32_t getErrors() const { return m_errors; }
+
+    /**
+     * @brief Get the simulated bus
+     * 
+     * @return I2CSimBus& 
+     */
+    inline I2CSimBus& getBus() const { return m_bus; }
+
+  protected:
+    enum State : uint8_t { 
+      IDLE, ADDRESS, PREFIX_ACK, ADDRESS_LOW, ADDRESS_ACK, 
+      WRITE, WRITE_ACK, READ, READ_ACK, IGNORE 
+    };
+
+    void update() {
+      bool scl = m_masterScl && (m_bus.now() >= m_holdUntil);
+      bool sda = m_masterSda && m_slaveSda;
+      if (scl && m_scl && sda != m_sda) {
+        m_sda = sda;
+        if (sda) stopCondition();
+        else startCondition();
+        return;
+      }
+      bool rising = scl && !m_scl;
+      bool falling = !scl && m_scl;
+      m_scl = scl;
+      m_sda = sda;
+      if (rising) sclRising();
+      if (falling) sclFalling();
+      m_sda = m_masterSda && m_slaveSda;
+    }
+
+    void startCondition() {
+      if (m_state != IDLE && m_state != IGNORE && m_bits > 1) m_errors++;
+      m_state = ADDRESS;
+      m_shift = 0;
+      m_bits = 0;
+    }
+
+    void stopCondition() {
+      if (m_target) m_target->onStop();
+      if (m_state != IGNORE && m_bits > 1) m_errors++;
+      m_target = nullptr;
+      m_state = IDLE;
+      m_slaveSda = true;
+    }
+
+    void sclRising() {
+      m_clocks++;
+      if (m_state == ADDRESS || m_state == ADDRESS_LOW || m_state == WRITE) {
+        m_shift = (uint8_t)((m_shift << 1) | (m_sda ? 1 : 0));
+        m_bits++;
+      }
+      else if (m_state == READ_ACK) m_masterAck = !m_sda;
+    }
+
+    void sclFalling() {
+      switch (m_state) {
+        case ADDRESS:
+          if (m_bits < 8) break;
+          m_read = (m_shift & 0x01) != 0;
+          m_bits = 0;
+          if ((m_shift & 0xF8) == 0xF0) {
+            // 10-bit address prefix
+            m_prefix = (m_shift >> 1) & 0x03;
+            if (!m_read && m_bus.hasTenBitPrefix(m_prefix)) {
+              m_slaveSda = false;
+              m_state = PREFIX_ACK;
+              break;
+            }
+            m_target = m_read ? m_bus.getSelectedTenBit() : nullptr;
+            if (m_target && ((m_target->getAddress() >> 8) & 0x03) != m_prefix) {
+              m_target = nullptr;
+            }
+          }
+          else m_target = m_bus.find(m_shift >> 1);
+          if (m_target && m_target->onStart(m_read)) {
+            m_slaveSda = false;
+            m_state = ADDRESS_ACK;
+          }
+          else {
+            m_target = nullptr;
+            m_state = IGNORE;
+          }
+          break;
+        case PREFIX_ACK:
+          m_slaveSda = true;
+          m_state = ADDRESS_LOW;
+          m_shift = 0;
+          m_bits = 0;
+          break;
+        case ADDRESS_LOW:
+          if (m_bits < 8) break;
+          m_bits = 0;
+          m_target = m_bus.find((uint16_t)((m_prefix << 8) | m_shift), true);
+          m_bus.setSelectedTenBit(m_target);
+          if (m_target && m_target->onStart(false)) {
+            m_slaveSda = false;
+            m_state = ADDRESS_ACK;
+          }
+          else {
+            m_target = nullptr;
+            m_state = IGNORE;
+          }
+          break;
+        case ADDRESS_ACK:
+        case WRITE_ACK:
+        case READ_ACK:
+          m_slaveSda = true;
+          stretch();
+          if (m_state == READ_ACK && !m_masterAck) m_state = IGNORE;
+          else if (m_read) loadReadByte();
+          else {
+            m_state = WRITE;
+            m_shift = 0;
+            m_bits = 0;
+          }
+          break;
+        case WRITE:
+          if (m_bits < 8) break;
+          m_bits = 0;
+          m_slaveSda = !m_target->onWrite(m_shift);
+          m_state = WRITE_ACK;
+          if (m_slaveSda) m_state = IGNORE;
+          break;
+        case READ:
+          m_bits++;
+          if (m_bits < 8) m_slaveSda = (m_shift & (0x80 >> m_bits)) != 0;
+          else {
+            m_bits = 0;
+            m_slaveSda = true;
+            m_state = READ_ACK;
+          }
+          break;
+        default:
+          break;
+      }
+    }
+
+    void loadReadByte() {
+      m_shift = m_target->onRead();
+      m_bits = 0;
+      m_slaveSda = (m_shift & 0x80) != 0;
+      m_state = READ;
+    }
+
+    void stretch() {
+      if (m_stretchNs) m_holdUntil = m_bus.now() + m_stretchNs;
+    }
+
+    I2CSimBus& m_bus;       //!< The simulated bus providing targets and time
+    bool m_masterSda;       //!< SDA released by the master
+    bool m_masterScl;       //!< SCL released by the master
+    bool m_slaveSda;        //!< SDA released by the target decoder
+    bool m_sda;             //!< SDA line level
+    bool m_scl;             //!< SCL line level
+    State m_state;          //!< Target decoder state
+    uint8_t m_shift;        //!< Byte shift register
+    uint8_t m_bits;         //!< Bits shifted in the current byte
+    uint8_t m_prefix;       //!< Address bits 9-8 of a 10-bit address phase
+    bool m_read;            //!< The current transaction is a read
+    bool m_masterAck;       //!< The master ACKed the last read byte
+    I2CSimTarget* m_target; //!< The addressed target
+    uint32_t m_stretchNs;   //!< Clock stretching after each ACK
+    uint64_t m_holdUntil;   //!< SCL is held low by the target until this time
+    uint32_t m_clocks;      //!< SCL pulses seen
+    uint32_t m_errors;      //!< Protocol violations seen
+};
+
+/**
+ * @brief Copyable handle to an I2CSimPins model, used as the pin policy of 
+ *        I2CSoftBackend.
+ */
+class I2CSimPinsRef {
+  public:
+    I2CSimPinsRef(I2CSimPins& pins): m_pins(&pins){};
+
+    inline void begin() { m_pins->begin(); }
+    inline void sdaLow() { m_pins->sdaLow(); }
+    inline void sdaRelease() { m_pins->sdaRelease(); }
+    inline bool sdaRead() { return m_pins->sdaRead(); }
+    inline void sclLow() { m_pins->sclLow(); }
+    inline void sclRelease() { m_pins->sclRelease(); }
+    inline bool sclRead() { return m_pins->sclRead(); }
+    inline void wait(uint32_t ns) { m_pins->wait(ns); }
+
+    /**
+     * @brief Get the line model
+     * 
+     * @return I2CSimPins& 
+     */
+    inline I2CSimPins& get() const { return *m_pins; }
+
+  protected:
+    I2CSimPins* m_pins; //!< The line model
+};
+#endif /* I2C_SIM_PINS_LIB_H_ */
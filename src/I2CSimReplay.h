@@ -0,0 +1,475 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CSimReplay.h 
+//!  @brief I2CSimReplayTarget class definitions
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_SIM_REPLAY_LIB_H_
+#define I2C_SIM_REPLAY_LIB_H_
+
+#include "I2CSimBus.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief One captured address phase: a (repeated) start, the address, and 
+ *        the bytes transferred until the next start or stop
+ */
+struct I2CCaptureSegment {
+  static constexpr size_t MAX_DATA = 256; //!< Bytes kept per segment
+
+  uint16_t address;  //!< The 7-bit (or 10-bit) device address
+  bool read;         //!< True for a read
+  bool addressAck;   //!< The device acknowledged the address
+  uint16_t length;   //!< Bytes transferred, may exceed MAX_DATA
+  uint16_t acked;    //!< Bytes acknowledged before the first NACK
+  uint8_t data[MAX_DATA]; //!< The first MAX_DATA bytes
+};
+
+/**
+ * @brief Line parser for logic analyzer I2C decodes.  Two formats are 
+ *        recognized:
+ * 
+ *        - sigrok-cli annotations (sigrok-cli -P i2c -A i2c), long or short
+ *          form, with or without the decoder prefix: "i2c-1: Start", 
+ *          "Address write: 50", "DR: 1F", "NACK", "Stop"...
+ *        - CSV exports with a header naming "type", "address", "read", 
+ *          "data" and "ack" columns, as written by Saleae Logic 2: rows of 
+ *          type start, address, data and stop.
+ * 
+ *        The format is detected from the first line.  Memory use does not 
+ *        depend on the capture size.
+ */
+class I2CCaptureParser {
+  public:
+    I2CCaptureParser(): m_csv(false), m_started(false), m_open(false), m_first(true), m_nacked(false),
+      m_typeColumn(-1), m_addressColumn(-1), m_readColumn(-1), m_dataColumn(-1), 
+      m_ackColumn(-1), m_errors(0){};
+
+    /**
+     * @brief Parse one line
+     * 
+     * @param line The line, terminated by a null or a line end
+     * @param out Set to the segment completed by this line
+     * @return bool True if a segment was completed
+     */
+    bool feed(const char* line, I2CCaptureSegment& out) {
+      bool first = m_first;
+      m_first = false;
+      if (first && parseHeader(line)) return false;
+      return m_csv ? feedCsv(line, out) : feedSigrok(line, out);
+    }
+
+    /**
+     * @brief End the capture
+     * 
+     * @param out Set to the last segment if it was not ended by a stop
+     * @return bool True if a segment was completed
+     */
+    bool finish(I2CCaptureSegment& out) { return complete(out); }
+
+    /**
+     * @brief Get the number of lines that could not be parsed
+     * 
+     * @return uint32_t 
+     */
+    inline uint32_t getErrors() const { return m_errors; }
+
+  protected:
+    static constexpr uint8_t MAX_COLUMNS = 16;
+
+    static bool isEnd(char c) { return c == '\0' || c == '\r' || c == '\n'; }
+
+    static bool startsWith(const char* s, const char* word) {
+      size_t n = strlen(word);
+      return strncmp(s, word, n) == 0 && (isEnd(s[n]) || s[n] == ':' || s[n] == ' ');
+    }
+
+    static const char* value(const char* s) {
+      const char* colon = strchr(s, ':');
+      return colon ? colon + 1 : s;
+    }
+
+    bool complete(I2CCaptureSegment& out) {
+      if (!m_open) return false;
+      m_open = false;
+      size_t stored = m_segment.length < I2CCaptureSegment::MAX_DATA ? 
+                      m_segment.length : I2CCaptureSegment::MAX_DATA;
+      memcpy(&out, &m_segment, offsetof(I2CCaptureSegment, data));
+      memcpy(out.data, m_segment.data, stored);
+      return true;
+    }
+
+    bool start(I2CCaptureSegment& out) {
+      bool done = complete(out);
+      m_started = true;
+      return done;
+    }
+
+    void address(uint16_t address, bool read, bool ack) {
+      if (!m_started) { m_errors++; return; }
+      m_started = false;
+      m_open = true;
+      m_nacked = !ack;
+      m_segment.address = address;
+      m_segment.read = read;
+      m_segment.addressAck = ack;
+      m_segment.length = 0;
+      m_segment.acked = 0;
+    }
+
+    void data(uint8_t value, bool ack) {
+      if (!m_open) { m_errors++; return; }
+      if (m_segment.length < I2CCaptureSegment::MAX_DATA) m_segment.data[m_segment.length] = value;
+      if (m_segment.length < 0xFFFF) m_segment.length++;
+      if (!m_nacked) m_segment.acked = m_segment.length;
+      if (!ack) acknowledge(false);
+    }
+
+    /**
+     * @brief Apply an ACK or NACK to the address or the last byte.  Bytes 
+     *        count as acknowledged unless a NACK follows them, so decodes 
+     *        without ACK annotations replay as fully acknowledged.
+     */
+    void acknowledge(bool ack) {
+      if (!m_open) return;
+      if (m_segment.length == 0) {
+        m_segment.addressAck = ack;
+        m_nacked = !ack;
+      } else if (!ack && !m_nacked) {
+        m_segment.acked = m_segment.length - 1;
+        m_nacked = true;
+      }
+    }
+
+    bool feedSigrok(const char* line, I2CCaptureSegment& out) {
+      while (*line == ' ' || *line == '\t' || (*line >= '0' && *line <= '9') || *line == '-') line++;
+      if (strncmp(line, "i2c", 3) == 0) {
+        const char* colon = strchr(line, ':');
+        if (colon) line = colon + 1;
+        while (*line == ' ') line++;
+      }
+      if (isEnd(*line)) return false;
+      if (startsWith(line, "Start repeated") || startsWith(line, "Sr") || 
+          startsWith(line, "Start") || startsWith(line, "S")) return start(out);
+      if (startsWith(line, "Stop") || startsWith(line, "P")) {
+        m_started = false;
+        return complete(out);
+      }
+      if (startsWith(line, "Address read") || startsWith(line, "AR")) {
+        address((uint16_t)strtoul(value(line), nullptr, 16), true, true);
+      } else if (startsWith(line, "Address write") || startsWith(line, "AW")) {
+        address((uint16_t)strtoul(value(line), nullptr, 16), false, true);
+      } else if (startsWith(line, "Data read") || startsWith(line, "DR") || 
+                 startsWith(line, "Data write") || startsWith(line, "DW")) {
+        data((uint8_t)strtoul(value(line), nullptr, 16), true);
+      } else if (startsWith(line, "ACK") || startsWith(line, "A")) {
+        acknowledge(true);
+      } else if (startsWith(line, "NACK") || startsWith(line, "N")) {
+        acknowledge(false);
+      } else if (!startsWith(line, "Read") && !startsWith(line, "Write") && 
+                 !startsWith(line, "R") && !startsWith(line, "W")) {
+        m_errors++;
+      }
+      return false;
+    }
+
+    /**
+     * @brief Split a CSV line into at most MAX_COLUMNS unquoted fields
+     * 
+     * @return The number of fields
+     */
+    static uint8_t split(const char* line, const char* fields[], uint8_t lengths[]) {
+      uint8_t count = 0;
+      while (count < MAX_COLUMNS) {
+        bool quoted = *line == '"';
+        if (quoted) line++;
+        const char* end = line;
+        while (!isEnd(*end) && (quoted ? *end != '"' : *end != ',')) end++;
+        fields[count] = line;
+        lengths[count++] = (uint8_t)((end - line) < 255 ? (end - line) : 255);
+        if (quoted && *end == '"') end++;
+        while (!isEnd(*end) && *end != ',') end++;
+        if (*end != ',') break;
+        line = end + 1;
+      }
+      return count;
+    }
+
+    static bool equals(const char* field, uint8_t length, const char* word) {
+      return strlen(word) == length && strncmp(field, word, length) == 0;
+    }
+
+    bool parseHeader(const char* line) {
+      const char* fields[MAX_COLUMNS];
+      uint8_t lengths[MAX_COLUMNS];
+      uint8_t count = split(line, fields, lengths);
+      for (uint8_t i = 0; i < count; i++) {
+        if (equals(fields[i], lengths[i], "type")) m_typeColumn = i;
+        else if (equals(fields[i], lengths[i], "address")) m_addressColumn = i;
+        else if (equals(fields[i], lengths[i], "read")) m_readColumn = i;
+        else if (equals(fields[i], lengths[i], "data")) m_dataColumn = i;
+        else if (equals(fields[i], lengths[i], "ack")) m_ackColumn = i;
+      }
+      m_csv = m_typeColumn >= 0 && m_addressColumn >= 0 && m_dataColumn >= 0;
+      return m_csv;
+    }
+
+    bool feedCsv(const char* line, I2CCaptureSegment& out) {
+      const char* fields[MAX_COLUMNS];
+      uint8_t lengths[MAX_COLUMNS];
+      uint8_t count = split(line, fields, lengths);
+      if (count <= m_typeColumn) {
+        if (count > 1 || lengths[0]) m_errors++;
+        return false;
+      }
+      const char* type = fields[m_typeColumn];
+      uint8_t length = lengths[m_typeColumn];
+      bool ack = m_ackColumn < 0 || m_ackColumn >= count || 
+                 !equals(fields[m_ackColumn], lengths[m_ackColumn], "false");
+      if (equals(type, length, "start")) return start(out);
+      if (equals(type, length, "stop")) {
+        m_started = false;
+        return complete(out);
+      }
+      if (equals(type, length, "address") && m_addressColumn < count) {
+        bool read = m_readColumn >= 0 && m_readColumn < count && 
+                    equals(fields[m_readColumn], lengths[m_readColumn], "true");
+        address((uint16_t)strtoul(fields[m_addressColumn], nullptr, 0), read, ack);
+      } else if (equals(type, length, "data") && m_dataColumn < count) {
+        data((uint8_t)strtoul(fields[m_dataColumn], nullptr, 0), ack);
+      } else {
+        m_errors++;
+      }
+      return false;
+    }
+
+    bool m_csv;          //!< The capture is a CSV export
+    bool m_started;      //!< A start was seen, the address is next
+    bool m_open;         //!< m_segment is being filled
+    bool m_first;        //!< The next line is the first
+    bool m_nacked;       //!< A NACK ended the acknowledged bytes
+    int8_t m_typeColumn;    //!< CSV column of the frame type
+    int8_t m_addressColumn; //!< CSV column of the address
+    int8_t m_readColumn;    //!< CSV column of the read flag
+    int8_t m_dataColumn;    //!< CSV column of the data byte
+    int8_t m_ackColumn;     //!< CSV column of the ack flag
+    uint32_t m_errors;   //!< Lines not understood
+    I2CCaptureSegment m_segment; //!< The segment being filled
+};
+
+#if !defined(ARDUINO)
+#include <stdio.h>
+
+/**
+ * @brief Streams the segments of a capture file through an 
+ *        I2CCaptureParser, one line at a time.  Lines longer than 
+ *        LINE_BYTES are skipped and counted as errors.
+ */
+class I2CCaptureReader {
+  public:
+    static constexpr size_t LINE_BYTES = 256; //!< Longest line parsed
+
+    I2CCaptureReader(): m_file(nullptr), m_lines(0), m_skipped(0){};
+    ~I2CCaptureReader() { close(); }
+
+    /**
+     * @brief Open a capture file
+     * 
+     * @param path The file path
+     * @return bool False if the file could not be opened
+     */
+    bool open(const char* path) {
+      close();
+      m_file = fopen(path, "r");
+      m_parser = I2CCaptureParser();
+      m_lines = 0;
+      m_skipped = 0;
+      return m_file != nullptr;
+    }
+
+    /**
+     * @brief Close the capture file
+     */
+    void close() {
+      if (m_file) fclose(m_file);
+      m_file = nullptr;
+    }
+
+    /**
+     * @brief Read the next segment
+     * 
+     * @param out Set to the segment
+     * @return bool False at the end of the capture
+     */
+    bool next(I2CCaptureSegment& out) {
+      if (!m_file) return false;
+      while (fgets(m_line, sizeof(m_line), m_file)) {
+        m_lines++;
+        if (!strchr(m_line, '\n') && !feof(m_file)) {
+          int c;
+          do { c = getc(m_file); } while (c != '\n' && c != EOF);
+          m_skipped++;
+          continue;
+        }
+        if (m_parser.feed(m_line, out)) return true;
+      }
+      bool last = m_parser.finish(out);
+      if (!last) close();
+      return last;
+    }
+
+    /**
+     * @brief Get the number of lines read
+     * 
+     * @return uint32_t 
+     */
+    inline uint32_t getLines() const { return m_lines; }
+
+    /**
+     * @brief Get the number of lines skipped or not understood
+     * 
+     * @return uint32_t 
+     */
+    inline uint32_t getErrors() const { return m_skipped + m_parser.getErrors(); }
+
+  protected:
+    FILE* m_file;                //!< The capture file
+    I2CCaptureParser m_parser;   //!< Turns lines into segments
+    uint32_t m_lines;            //!< Lines read
+    uint32_t m_skipped;          //!< Lines too long to parse
+    char m_line[LINE_BYTES];     //!< The current line
+};
+#endif
+
+/**
+ * @brief Simulated device replaying a capture of a real one: each address 
+ *        phase takes the device's next captured segment, acknowledges as 
+ *        the real device did and returns its read data.  Written bytes and 
+ *        directions that differ from the capture are counted, so a driver 
+ *        can be regression tested against recorded traffic.  Segments of 
+ *        other addresses are skipped, use one source per replayed device.
+ * 
+ * @tparam Source Has bool next(I2CCaptureSegment&), e.g. I2CCaptureReader
+ */
+template <class Source>
+class I2CSimReplayTarget : public I2CSimTarget {
+  public:
+    I2CSimReplayTarget(Source& source, uint16_t address, bool tenBit = false):
+      I2CSimTarget(address, tenBit), m_source(source), m_position(0), 
+      m_finished(false), m_replayed(0), m_mismatches(0){};
+
+    bool onStart(bool read) override {
+      m_position = 0;
+      do {
+        if (m_finished || !m_source.next(m_segment)) {
+          m_finished = true;
+          return false;
+        }
+      } while (m_segment.address != m_address);
+      m_replayed++;
+      if (m_segment.read != read) m_mismatches++;
+      return m_segment.addressAck;
+    }
+
+    bool onWrite(uint8_t data) override {
+      uint16_t i = m_position++;
+      if (i >= m_segment.length || (i < I2CCaptureSegment::MAX_DATA && m_segment.data[i] != data)) {
+        m_mismatches++;
+      }
+      return i < m_segment.acked;
+    }
+
+    uint8_t onRead() override {
+      uint16_t i = m_position++;
+      if (i >= m_segment.length) m_mismatches++;
+      return i < m_segment.length && i < I2CCaptureSegment::MAX_DATA ? m_segment.data[i] : 0xFF;
+    }
+
+    /**
+     * @brief Check if the capture has no more segments for the device.  
+     *        The device NACKs its address from then on.
+     * 
+     * @return bool 
+     */
+    inline bool isFinished() const { return m_finished; }
+
+    /**
+     * @brief Get the number of segments replayed
+     * 
+     * @return uint32_t 
+     */
+    inline uint32_t getReplayed() const { return m_replayed; }
+
+    /**
+     * @brief Get the number of directions, written bytes and transfer 
+     *        lengths that differed from the capture
+     * 
+     * @return uint32_t 
+     */
+    inline uint32_t getMismatches() const { return m_mismatches; }
+
+  protected:
+    Source& m_source;             //!< The captured segments
+    I2CCaptureSegment m_segment;  //!< The segment being replayed
+    uint16_t m_position;          //!< The next byte of the segment
+    bool m_finished;              //!< The capture has ended
+    uint32_t m_replayed;          //!< Segments replayed
+    uint32_t m_mismatches;        //!< Differences from the capture
+};
+#endif /* I2C_SIM_REPLAY_LIB_H_ */
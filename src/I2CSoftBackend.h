@@ -0,0 +1,410 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CSoftBackend.h 
+//!  @brief Bit-banged software I2C backend
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_SOFT_BACKEND_LIB_H_
+#define I2C_SOFT_BACKEND_LIB_H_
+
+#include "I2CBackend.h"
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#endif
+
+/**
+ * @brief Bit-banged I2C master usable on any two pins.
+ * 
+ *        The pin access is provided by the Pins policy class, which must 
+ *        implement:
+ *          void begin();          // configure both lines as released
+ *          void sdaLow();         // drive SDA low
+ *          void sdaRelease();     // let SDA float high
+ *          bool sdaRead();        // sample SDA
+ *          void sclLow();         // drive SCL low
+ *          void sclRelease();     // let SCL float high
+ *          bool sclRead();        // sample SCL (for clock stretching)
+ *          void wait(uint32_t ns);// wait for (at least) ns nanoseconds
+ *        All methods are called in the inner loop and should be inline.
+ *        Lines are treated as open drain: they are never driven high.
+ * 
+ * @tparam Pins The pin access policy
+ */
+template <class Pins>
+class I2CSoftBackend : public I2CBackend {
+  public:
+    /**
+     * @brief Construct a software I2C backend
+     * 
+     * @param pins The pin access policy instance
+     * @param stretchTimeoutNs Maximum time a device may stretch the clock
+     *                         before the transfer is aborted
+     */
+    I2CSoftBackend(const Pins& pins, uint32_t stretchTimeoutNs = 25000000UL):
+      m_pins(pins), m_halfPeriodNs(5000), m_stretchTimeoutNs(stretchTimeoutNs),
+      m_normalHalfPeriodNs(5000), m_held(false){};
+
+    /**
+     * @brief Release both lines.  Call before the first transfer.
+     */
+    void begin() {
+      m_pins.begin();
+    }
+
+    /**
+     * @brief Set the bus clock.  The pin access overhead is not accounted 
+     *        for, see setHalfPeriod() to trim the timing.  The Arduino pin 
+     *        policies wait in whole microseconds, rounded up, so the clock 
+     *        is never faster than requested: 400 kHz runs at 250 kHz at most.
+     * 
+     * @param frequency The SCL frequency in Hz
+     */
+    void setClock(uint32_t frequency) override {
+      I2CBackend::setClock(frequency);
+      m_halfPeriodNs = 500000000UL / frequency;
+    }
+
+    /**
+     * @brief Set the time waited for each half SCL period directly
+     * 
+     * @param ns The half period in nanoseconds (0 to run as fast as the 
+     *           pin access allows)
+     */
+    inline void setHalfPeriod(uint32_t ns) { m_halfPeriodNs = ns; }
+
+    /**
+     * @brief Set the maximum time a device may stretch the clock
+     * 
+     * @param ns The timeout in nanoseconds
+     */
+    inline void setStretchTimeout(uint32_t ns) { m_stretchTimeoutNs = ns; }
+
+    /**
+     * @brief Get the pin access policy
+     * 
+     * @return Pins& 
+     */
+    inline Pins& getPins() { return m_pins; }
+
+    bool supportsHighSpeed() const override { return true; }
+
+    void releaseBus() override {
+      if (m_held) stop();
+      m_held = false;
+      leaveHighSpeed();
+    }
+
+    uint8_t transfer(I2CTransfer& xfer) override {
+      xfer.rxCount = 0;
+      xfer.status = SUCCESS;
+      if ((xfer.flags & I2CTransfer::HIGH_SPEED) && !m_hsActive) {
+        xfer.status = enterHighSpeed();
+      }
+      if (xfer.status == SUCCESS) xfer.status = run(xfer);
+      m_held = (xfer.status == SUCCESS) && (xfer.flags & I2CTransfer::NO_STOP);
+      if (xfer.status == ARBITRATION_LOST) {
+        // the winning controller owns the bus, release it without a stop
+        m_pins.sdaRelease();
+        m_pins.sclRelease();
+        leaveHighSpeed();
+      }
+      else if (!m_held) {
+        stop();
+        leaveHighSpeed();
+      }
+      return xfer.status;
+    }
+
+  protected:
+    /**
+     * @brief Send the master code at the normal clock (it is not ACKed), 
+     *        then switch to the high-speed clock.  The following start is a
+     *        repeated start.
+     */
+    uint8_t enterHighSpeed() {
+      if (!start()) return OTHER_ERROR;
+      uint8_t ack = writeByte(m_masterCode);
+      if (ack == OTHER_ERROR || ack == ARBITRATION_LOST) return ack;
+      m_normalHalfPeriodNs = m_halfPeriodNs;
+      m_halfPeriodNs = 500000000UL / m_hsClock;
+      m_hsActive = true;
+      return SUCCESS;
+    }
+
+    inline void leaveHighSpeed() {
+      if (!m_hsActive) return;
+      m_halfPeriodNs = m_normalHalfPeriodNs;
+      m_hsActive = false;
+    }
+
+    uint8_t run(I2CTransfer& xfer) {
+      bool tenBit = (xfer.flags & I2CTransfer::TEN_BIT) != 0;
+      uint8_t address = tenBit ? (uint8_t)(0xF0 | ((xfer.address >> 7) & 0x06)) :
+                                 (uint8_t)(xfer.address << 1);
+      if (!start()) return OTHER_ERROR;
+      if (xfer.txLength > 0 || xfer.rxLength == 0 || tenBit) {
+        uint8_t ack = writeAddress(address);
+        if (ack == SUCCESS && tenBit) ack = writeAddress((uint8_t)xfer.address);
+        if (ack != SUCCESS) return ack;
+        for (size_t i = 0; i < xfer.txLength; i++) {
+          ack = writeByte(xfer.txData[i]);
+          if (ack != SUCCESS) return ack;
+        }
+        if (xfer.rxLength == 0) return SUCCESS;
+        if (!start()) return OTHER_ERROR;
+      }
+      uint8_t ack = writeAddress(address | 0x01);
+      if (ack != SUCCESS) return ack;
+      while (xfer.rxCount < xfer.rxLength) {
+        bool last = (xfer.rxCount + 1 == xfer.rxLength);
+        if (!readByte(xfer.rxData[xfer.rxCount], !last)) return OTHER_ERROR;
+        xfer.rxCount++;
+      }
+      return SUCCESS;
+    }
+
+    /**
+     * @brief Send an address byte, a NACK is reported as NACK_ON_ADDRESS
+     */
+    inline uint8_t writeAddress(uint8_t data) {
+      uint8_t ack = writeByte(data);
+      return (ack == NACK_ON_DATA) ? NACK_ON_ADDRESS : ack;
+    }
+
+    /**
+     * @brief Release SCL and wait for any clock stretching to end
+     * 
+     * @return bool False if the device held SCL low past the timeout
+     */
+    inline bool sclHigh() {
+      m_pins.sclRelease();
+      uint32_t waited = 0;
+      while (!m_pins.sclRead()) {
+        if (waited >= m_stretchTimeoutNs) return false;
+        uint32_t step = m_halfPeriodNs ? m_halfPeriodNs : 1000;
+        m_pins.wait(step);
+        waited += step;
+      }
+      return true;
+    }
+
+    /**
+     * @brief Send a start (or repeated start) condition
+     */
+    inline bool start() {
+      m_pins.sdaRelease();
+      m_pins.wait(m_halfPeriodNs);
+      if (!sclHigh()) return false;
+      m_pins.wait(m_halfPeriodNs);
+      m_pins.sdaLow();
+      m_pins.wait(m_halfPeriodNs);
+      m_pins.sclLow();
+      return true;
+    }
+
+    /**
+     * @brief Send a stop condition
+     */
+    inline void stop() {
+      m_pins.sdaLow();
+      m_pins.wait(m_halfPeriodNs);
+      sclHigh();
+      m_pins.wait(m_halfPeriodNs);
+      m_pins.sdaRelease();
+      m_pins.wait(m_halfPeriodNs);
+    }
+
+    /**
+     * @brief Clock out one byte and read the ACK bit
+     * 
+     * @return SUCCESS on ACK, NACK_ON_DATA on NACK, OTHER_ERROR on a 
+     *         clock stretching timeout, ARBITRATION_LOST if another 
+     *         controller pulled SDA low while a 1 was sent
+     */
+    inline uint8_t writeByte(uint8_t data) {
+      for (uint8_t mask = 0x80; mask; mask >>= 1) {
+        if (data & mask) m_pins.sdaRelease();
+        else m_pins.sdaLow();
+        m_pins.wait(m_halfPeriodNs);
+        if (!sclHigh()) return OTHER_ERROR;
+        if ((data & mask) && !m_pins.sdaRead()) return ARBITRATION_LOST;
+        m_pins.wait(m_halfPeriodNs);
+        m_pins.sclLow();
+      }
+      m_pins.sdaRelease();
+      m_pins.wait(m_halfPeriodNs);
+      if (!sclHigh()) return OTHER_ERROR;
+      bool ack = !m_pins.sdaRead();
+      m_pins.wait(m_halfPeriodNs);
+      m_pins.sclLow();
+      return ack ? SUCCESS : NACK_ON_DATA;
+    }
+
+    /**
+     * @brief Clock in one byte and send the ACK bit
+     * 
+     * @param data Set to the byte read
+     * @param ack True to ACK (more bytes follow), false to NACK
+     * @return bool False on a clock stretching timeout
+     */
+    inline bool readByte(uint8_t& data, bool ack) {
+      m_pins.sdaRelease();
+      data = 0;
+      for (uint8_t i = 0; i < 8; i++) {
+        m_pins.wait(m_halfPeriodNs);
+        if (!sclHigh()) return false;
+        data = (data << 1) | (m_pins.sdaRead() ? 1 : 0);
+        m_pins.wait(m_halfPeriodNs);
+        m_pins.sclLow();
+      }
+      if (ack) m_pins.sdaLow();
+      m_pins.wait(m_halfPeriodNs);
+      if (!sclHigh()) return false;
+      m_pins.wait(m_halfPeriodNs);
+      m_pins.sclLow();
+      m_pins.sdaRelease();
+      return true;
+    }
+
+    Pins m_pins;                 //!< The pin access policy
+    uint32_t m_halfPeriodNs;     //!< Time waited per half SCL period
+    uint32_t m_stretchTimeoutNs; //!< Maximum clock stretching time
+    uint32_t m_normalHalfPeriodNs; //!< Half period restored when leaving high-speed mode
+    bool m_held;                 //!< The bus is held after a NO_STOP transfer
+};
+
+#if defined(ARDUINO)
+/**
+ * @brief Portable pin access through pinMode()/digitalRead().  Slow, but 
+ *        works on every Arduino core.  Like I2CFastPins only the pin 
+ *        direction is switched and the output latch is kept low, so a line 
+ *        is never driven high; the bus needs external pull-ups.
+ */
+class I2CArduinoPins {
+  public:
+    I2CArduinoPins(uint8_t sda, uint8_t scl): m_sda(sda), m_scl(scl){};
+
+    inline void begin() {
+      pinMode(m_sda, INPUT);
+      pinMode(m_scl, INPUT);
+      digitalWrite(m_sda, LOW);
+      digitalWrite(m_scl, LOW);
+    }
+    inline void sdaLow() { pinMode(m_sda, OUTPUT); }
+    inline void sdaRelease() { pinMode(m_sda, INPUT); }
+    inline bool sdaRead() { return digitalRead(m_sda) == HIGH; }
+    inline void sclLow() { pinMode(m_scl, OUTPUT); }
+    inline void sclRelease() { pinMode(m_scl, INPUT); }
+    inline bool sclRead() { return digitalRead(m_scl) == HIGH; }
+    inline void wait(uint32_t ns) { if (ns) delayMicroseconds((ns + 999) / 1000); }
+
+  protected:
+    uint8_t m_sda; //!< The SDA pin number
+    uint8_t m_scl; //!< The SCL pin number
+};
+
+#if defined(portModeRegister) && defined(portOutputRegister) && defined(portInputRegister)
+/**
+ * @brief Fast pin access through the port registers.  The port register 
+ *        addresses and bit masks are looked up once in the constructor, 
+ *        switching a line is then a single read-modify-write of the 
+ *        direction register (the output latch is kept low).
+ * 
+ *        Other pins on the same port must not be changed from interrupts 
+ *        while a transfer is in progress.
+ */
+class I2CFastPins {
+  public:
+    typedef decltype(portModeRegister(0)) PortRegister; //!< Port register pointer type
+    typedef decltype(digitalPinToBitMask(0)) PortMask;  //!< Port bit mask type
+
+    I2CFastPins(uint8_t sda, uint8_t scl):
+      m_sdaMode(portModeRegister(digitalPinToPort(sda))),
+      m_sdaIn(portInputRegister(digitalPinToPort(sda))),
+      m_sclMode(portModeRegister(digitalPinToPort(scl))),
+      m_sclIn(portInputRegister(digitalPinToPort(scl))),
+      m_sdaMask(digitalPinToBitMask(sda)), m_sclMask(digitalPinToBitMask(scl)),
+      m_sda(sda), m_scl(scl){};
+
+    inline void begin() {
+      pinMode(m_sda, INPUT);
+      pinMode(m_scl, INPUT);
+      digitalWrite(m_sda, LOW);
+      digitalWrite(m_scl, LOW);
+    }
+    inline void sdaLow() { *m_sdaMode |= m_sdaMask; }
+    inline void sdaRelease() { *m_sdaMode &= ~m_sdaMask; }
+    inline bool sdaRead() { return (*m_sdaIn & m_sdaMask) != 0; }
+    inline void sclLow() { *m_sclMode |= m_sclMask; }
+    inline void sclRelease() { *m_sclMode &= ~m_sclMask; }
+    inline bool sclRead() { return (*m_sclIn & m_sclMask) != 0; }
+    inline void wait(uint32_t ns) { if (ns) delayMicroseconds((ns + 999) / 1000); }
+
+  protected:
+    PortRegister m_sdaMode; //!< SDA direction register
+    PortRegister m_sdaIn;   //!< SDA input register
+    PortRegister m_sclMode; //!< SCL direction register
+    PortRegister m_sclIn;   //!< SCL input register
+    PortMask m_sdaMask;     //!< SDA bit mask
+    PortMask m_sclMask;     //!< SCL bit mask
+    uint8_t m_sda;          //!< The SDA pin number
+    uint8_t m_scl;          //!< The SCL pin number
+};
+#endif
+#endif /* ARDUINO */
+#endif /* I2C_SOFT_BACKEND_LIB_H_ */
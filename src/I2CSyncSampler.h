@@ -0,0 +1,292 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CSyncSampler.h 
+//!  @brief I2CSyncSampler class definition
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_SYNC_SAMPLER_LIB_H_
+#define I2C_SYNC_SAMPLER_LIB_H_
+
+#include "I2CDeviceGroup.h"
+#include "I2CClock.h"
+
+/**
+ * @brief Running min/max/mean statistics of a time spread in microseconds
+ */
+struct I2CSkewStats {
+  uint32_t count;   //!< Number of values recorded
+  uint32_t last;    //!< The last value
+  uint32_t min;     //!< The smallest value
+  uint32_t max;     //!< The largest value
+  uint64_t total;   //!< Sum of all values
+
+  I2CSkewStats(): count(0), last(0), min(0), max(0), total(0){};
+
+  /**
+   * @brief Record a value
+   * 
+   * @param value The spread in microseconds
+   */
+  void add(uint32_t value) {
+    if (!count || value < min) min = value;
+    if (!count || value > max) max = value;
+    last = value;
+    total += value;
+    count++;
+  }
+
+  /**
+   * @brief Get the mean of all recorded values
+   * 
+   * @return The mean in microseconds
+   */
+  inline uint32_t mean() const { return count ? (uint32_t)(total / count) : 0; }
+};
+
+/**
+ * @brief A sample read by I2CSyncSampler from one device
+ * 
+ * @tparam Size The sample size in bytes
+ */
+template <uint8_t Size>
+struct I2CSyncSample {
+  uint32_t triggerUs;  //!< Time the trigger for this device completed
+  uint32_t readUs;     //!< Time the sample read completed
+  uint8_t status;      //!< The I2C Bus result of the read
+  uint8_t data[Size];  //!< The sample data
+};
+
+/**
+ * @brief Takes samples from a group of devices as close together as 
+ *        possible: all devices are triggered with one broadcast write (or 
+ *        back-to-back writes), then all results are read in one batch.  
+ *        Every sample is stamped with its trigger and read time and the 
+ *        spread between devices is tracked.
+ * 
+ * @tparam Device The I2C device type, an instance of BasicI2CDevice
+ * @tparam Capacity The maximum number of devices
+ * @tparam SampleSize The number of bytes read from each device
+ * @tparam Clock The time source, e.g. I2CArduinoClock or I2CSimClock
+ */
+template <class Device = I2CDevice, uint8_t Capacity = 8, uint8_t SampleSize = 6,
+          class Clock = I2CDefaultClock>
+class I2CSyncSampler : public I2CBusResult {
+  public:
+    typedef I2CSyncSample<SampleSize> Sample; //!< The sample type
+
+    /**
+     * @brief The trigger is sent once to the broadcast or general call address
+     */
+    static constexpr uint8_t TRIGGER_BROADCAST = 0;
+    /**
+     * @brief The trigger is written to each device back-to-back
+     */
+    static constexpr uint8_t TRIGGER_SEQUENTIAL = 1;
+
+    /**
+     * @brief Construct a synchronized sampler
+     * 
+     * @param clock The time source
+     * @param broadcastAddress The 7-bit broadcast address of the devices, 
+     *        or I2CDeviceGroup::NO_BROADCAST_ADDRESS for general call
+     */
+    I2CSyncSampler(const Clock& clock = Clock(), 
+                   uint8_t broadcastAddress = 
+                     I2CDeviceGroup<Device, Capacity>::NO_BROADCAST_ADDRESS):
+      m_group(broadcastAddress), m_clock(clock), m_mode(TRIGGER_BROADCAST),
+      m_triggerLength(0), m_readLength(0), m_conversionUs(0){};
+
+    /**
+     * @brief Add a device to the sampler
+     * 
+     * @param device The device, must be on the same bus as the others
+     * @return bool True if the device was added
+     */
+    inline bool add(Device& device) { return m_group.add(device); }
+
+    /**
+     * @brief Get the device group used for triggering
+     * 
+     * @return I2CDeviceGroup<Device, Capacity>& 
+     */
+    inline I2CDeviceGroup<Device, Capacity>& getGroup() { return m_group; }
+
+    /**
+     * @brief Set the trigger command
+     * 
+     * @param data The trigger command bytes (copied, at most 4)
+     * @param size The number of bytes
+     * @param mode TRIGGER_BROADCAST or TRIGGER_SEQUENTIAL
+     */
+    void setTrigger(const uint8_t* data, uint8_t size, uint8_t mode = TRIGGER_BROADCAST) {
+      m_triggerLength = (size > sizeof(m_trigger)) ? sizeof(m_trigger) : size;
+      memcpy(m_trigger, data, m_triggerLength);
+      m_mode = mode;
+    }
+
+    /**
+     * @brief Set the command written before reading a sample, usually the 
+     *        result register address
+     * 
+     * @param data The command bytes (copied, at most 4)
+     * @param size The number of bytes
+     */
+    void setReadCommand(const uint8_t* data, uint8_t size) {
+      m_readLength = (size > sizeof(m_read)) ? sizeof(m_read) : size;
+      memcpy(m_read, data, m_readLength);
+    }
+
+    /**
+     * @brief Set the time to wait between trigger and read
+     * 
+     * @param us The conversion time in microseconds
+     */
+    inline void setConversionTime(uint32_t us) { m_conversionUs = us; }
+
+    /**
+     * @brief Trigger all devices, wait for the conversion, then read the 
+     *        samples of all devices.
+     * 
+     * @return The I2C Bus result of the first failing transaction, or SUCCESS
+     */
+    uint8_t sample() {
+      uint8_t result = trigger();
+      if (m_conversionUs) m_clock.delayUs(m_conversionUs);
+      uint8_t status = read();
+      return (result == SUCCESS) ? status : result;
+    }
+
+    /**
+     * @brief Trigger all devices
+     * 
+     * @return The I2C Bus result
+     */
+    uint8_t trigger() {
+      uint8_t n = m_group.size();
+      uint8_t result = SUCCESS;
+      if (m_mode == TRIGGER_BROADCAST) {
+        result = m_group.write(m_trigger, m_triggerLength);
+        uint32_t now = m_clock.nowUs();
+        for (uint8_t i = 0; i < n; i++) m_samples[i].triggerUs = now;
+      }
+      else {
+        for (uint8_t i = 0; i < n; i++) {
+          uint8_t status = m_group.get(i).transfer(m_trigger, m_triggerLength);
+          m_samples[i].triggerUs = m_clock.nowUs();
+          if (result == SUCCESS) result = status;
+        }
+      }
+      if (n) m_triggerSkew.add(m_samples[n - 1].triggerUs - m_samples[0].triggerUs);
+      return result;
+    }
+
+    /**
+     * @brief Read the samples of all devices back-to-back
+     * 
+     * @return The I2C Bus result of the first failing read, or SUCCESS
+     */
+    uint8_t read() {
+      uint8_t n = m_group.size();
+      uint8_t result = SUCCESS;
+      for (uint8_t i = 0; i < n; i++) {
+        Sample& s = m_samples[i];
+        s.status = m_group.get(i).transfer(m_read, m_readLength, s.data, SampleSize);
+        s.readUs = m_clock.nowUs();
+        if (result == SUCCESS) result = s.status;
+      }
+      if (n) m_readSkew.add(m_samples[n - 1].readUs - m_samples[0].readUs);
+      return result;
+    }
+
+    /**
+     * @brief Get the last sample of a device
+     * 
+     * @param index The device index (in order of adding)
+     * @return const Sample& 
+     */
+    inline const Sample& getSample(uint8_t index) const { return m_samples[index]; }
+
+    /**
+     * @brief Get the spread of trigger times between the first and the last
+     *        device.  Zero for broadcast triggers.
+     * 
+     * @return const I2CSkewStats& 
+     */
+    inline const I2CSkewStats& getTriggerSkew() const { return m_triggerSkew; }
+
+    /**
+     * @brief Get the spread of read times between the first and the last 
+     *        device
+     * 
+     * @return const I2CSkewStats& 
+     */
+    inline const I2CSkewStats& getReadSkew() const { return m_readSkew; }
+
+  protected:
+    I2CDeviceGroup<Device, Capacity> m_group; //!< The sampled devices
+    Clock m_clock;                 //!< The time source
+    uint8_t m_mode;                //!< TRIGGER_BROADCAST or TRIGGER_SEQUENTIAL
+    uint8_t m_trigger[4];          //!< The trigger command
+    uint8_t m_triggerLength;       //!< The trigger command length
+    uint8_t m_read[4];             //!< The read command
+    uint8_t m_readLength;          //!< The read command length
+    uint32_t m_conversionUs;       //!< Time between trigger and read
+    Sample m_samples[Capacity];    //!< The last sample of each device
+    I2CSkewStats m_triggerSkew;    //!< Trigger time spread statistics
+    I2CSkewStats m_readSkew;       //!< Read time spread statistics
+};
+#endif /* I2C_SYNC_SAMPLER_LIB_H_ */
@@ -0,0 +1,136 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CTiming.h 
+//!  @brief I2C bus timing model
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_TIMING_LIB_H_
+#define I2C_TIMING_LIB_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Simple model of the time a transaction occupies the bus.
+ * 
+ *        Every byte takes 9 SCL periods (8 data bits and the ACK bit), 
+ *        start, repeated start and stop conditions are counted as one 
+ *        period each.  Clock stretching is not included.
+ */
+struct I2CTiming {
+  /**
+   * @brief Get the number of SCL periods used by a transaction
+   * 
+   * @param addressBytes The number of address bytes (1 for 7-bit addresses)
+   * @param txLength The number of bytes written
+   * @param rxLength The number of bytes read
+   * @return The transaction length in SCL periods
+   */
+  static uint32_t bitPeriods(uint8_t addressBytes, size_t txLength, size_t rxLength) {
+    uint32_t periods = 1; // stop
+    bool writePhase = (txLength > 0) || (rxLength == 0) || (addressBytes > 1);
+    if (writePhase) periods += 1 + 9 * (addressBytes + (uint32_t)txLength);
+    if (rxLength > 0) periods += 1 + 9 * (1 + (uint32_t)rxLength);
+    return periods;
+  }
+
+  /**
+   * @brief Get the duration of a number of SCL periods
+   * 
+   * @param periods The number of SCL periods
+   * @param clock The SCL frequency in Hz
+   * @return The duration in nanoseconds 
+   */
+  static uint32_t periodsToNs(uint32_t periods, uint32_t clock) {
+    return periods * (1000000000UL / clock);
+  }
+
+  /**
+   * @brief Get the predicted bus time of a transaction
+   * 
+   * @param clock The SCL frequency in Hz
+   * @param addressBytes The number of address bytes (1 for 7-bit addresses)
+   * @param txLength The number of bytes written
+   * @param rxLength The number of bytes read
+   * @return The transaction duration in nanoseconds
+   */
+  static uint32_t transferNs(uint32_t clock, uint8_t addressBytes, 
+                             size_t txLength, size_t rxLength) {
+    return periodsToNs(bitPeriods(addressBytes, txLength, rxLength), clock);
+  }
+
+  /**
+   * @brief Get the predicted bus time of a high-speed mode transaction
+   * 
+   * @param clock The Fast-mode SCL frequency in Hz, used for the master code
+   * @param hsClock The high-speed SCL frequency in Hz
+   * @param masterCode True if the master code is sent first (the bus was 
+   *                   not already in high-speed mode)
+   * @param addressBytes The number of address bytes (1 for 7-bit addresses)
+   * @param txLength The number of bytes written
+   * @param rxLength The number of bytes read
+   * @param stop True if the transaction ends with a stop condition
+   * @return The transaction duration in nanoseconds
+   */
+  static uint32_t highSpeedNs(uint32_t clock, uint32_t hsClock, bool masterCode,
+                              uint8_t addressBytes, size_t txLength, 
+                              size_t rxLength, bool stop) {
+    uint32_t periods = bitPeriods(addressBytes, txLength, rxLength) - (stop ? 0 : 1);
+    return (masterCode ? periodsToNs(10, clock) : 0) + periodsToNs(periods, hsClock);
+  }
+};
+#endif /* I2C_TIMING_LIB_H_ */
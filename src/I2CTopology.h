@@ -0,0 +1,400 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CTopology.h 
+//!  @brief Compile-time I2C bus topology description and checks
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_TOPOLOGY_LIB_H_
+#define I2C_TOPOLOGY_LIB_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief One node of a board's I2C topology: a device or a multiplexer, 
+ *        on a bus, either directly or behind a multiplexer channel.
+ * 
+ *        A topology is a constexpr array of nodes built with 
+ *        I2CTopology::device() and I2CTopology::mux().  Nodes behind a 
+ *        multiplexer refer to it by its index in the array:
+ * 
+ *          constexpr I2CTopologyNode board[] = {
+ *            I2CTopology::mux(0, 0x70),                // 0
+ *            I2CTopology::device(0, 0x68),             // 1: IMU on bus 0
+ *            I2CTopology::device(0, 0x76, 0, 0),       // 2: behind mux 0, channel 0
+ *            I2CTopology::device(0, 0x76, 0, 1),       // 3: behind mux 0, channel 1
+ *          };
+ *          I2C_TOPOLOGY_CHECK(board);
+ * 
+ *        Device objects can then be constructed from the table 
+ *        (board[1].address), which is resolved at compile time, or 
+ *        generated for a whole bus:
+ * 
+ *          constexpr auto bus0 = I2C_BUS_TABLE(board, 0);      // addresses
+ *          I2CDeviceSet<I2CDevice, bus0.COUNT> devices = 
+ *            I2C_BUS_DEVICES(I2CDevice, Wire, board, 0);       // device objects
+ * 
+ *        Both are constant-initialized, there is no runtime registration.
+ */
+struct I2CTopologyNode {
+  uint8_t kind;     //!< I2CTopology::DEVICE or I2CTopology::MUX
+  uint8_t bus;      //!< The bus number
+  uint8_t address;  //!< The 7-bit I2C address
+  uint8_t mux;      //!< Index of the upstream multiplexer, or I2CTopology::ROOT
+  uint8_t channel;  //!< Channel of the upstream multiplexer
+};
+
+/**
+ * @brief A compile-time list of indices, used to expand topology tables 
+ *        (std::index_sequence is C++14)
+ */
+template <size_t... I>
+struct I2CIndexList {};
+
+template <size_t N, size_t... I>
+struct I2CMakeIndexList : I2CMakeIndexList<N - 1, N - 1, I...> {};
+
+template <size_t... I>
+struct I2CMakeIndexList<0, I...> {
+  typedef I2CIndexList<I...> Type; //!< The list 0 .. N-1
+};
+
+/**
+ * @brief The devices of one bus, generated from a topology table by 
+ *        I2C_BUS_TABLE()
+ * 
+ * @tparam N The number of devices on the bus
+ */
+template <size_t N>
+struct I2CBusTable {
+  static constexpr size_t COUNT = N; //!< The number of devices
+
+  uint8_t address[N ? N : 1];  //!< The device addresses, in table order
+  uint8_t node[N ? N : 1];     //!< The topology table index of each device
+};
+
+/**
+ * @brief Device objects for the devices of one bus, generated from a 
+ *        topology table by I2C_BUS_DEVICES()
+ * 
+ * @tparam Device The device type, an instance of BasicI2CDevice
+ * @tparam N The number of devices on the bus
+ */
+template <class Device, size_t N>
+struct I2CDeviceSet {
+  static_assert(N > 0, "I2CDeviceSet needs at least one device");
+  static constexpr size_t COUNT = N; //!< The number of devices
+
+  Device devices[N]; //!< The devices, in table order
+
+  inline Device& operator[](size_t i) { return devices[i]; }
+  inline const Device& operator[](size_t i) const { return devices[i]; }
+};
+
+/**
+ * @brief constexpr helpers to build and check I2CTopologyNode tables.  All 
+ *        checks are C++11 constexpr functions usable in static_assert.
+ */
+struct I2CTopology {
+  static constexpr uint8_t DEVICE = 0;   //!< Node kind: I2C device
+  static constexpr uint8_t MUX = 1;      //!< Node kind: I2C multiplexer
+  static constexpr uint8_t ROOT = 0xFF;  //!< Node sits directly on the bus
+
+  /**
+   * @brief Describe a device
+   * 
+   * @param bus The bus number
+   * @param address The 7-bit I2C address
+   * @param mux Index of the upstream multiplexer node, or ROOT
+   * @param channel The multiplexer channel
+   */
+  static constexpr I2CTopologyNode device(uint8_t bus, uint8_t address, 
+                                          uint8_t mux = ROOT, uint8_t channel = 0) {
+    return I2CTopologyNode{ DEVICE, bus, address, mux, channel };
+  }
+
+  /**
+   * @brief Describe a multiplexer
+   * 
+   * @param bus The bus number
+   * @param address The 7-bit I2C address
+   * @param mux Index of the upstream multiplexer node, or ROOT
+   * @param channel The upstream multiplexer channel
+   */
+  static constexpr I2CTopologyNode mux(uint8_t bus, uint8_t address,
+                                       uint8_t mux = ROOT, uint8_t channel = 0) {
+    return I2CTopologyNode{ MUX, bus, address, mux, channel };
+  }
+
+  /**
+   * @brief Check if an address is reserved by the I2C specification 
+   *        (0x00-0x07 and 0x78-0x7F)
+   */
+  static constexpr bool reserved(uint8_t address) {
+    return address < 0x08 || address > 0x77;
+  }
+
+  /**
+   * @brief Check if the segment (segMux, segChannel) is the segment 
+   *        (mux, channel) or upstream of it
+   */
+  static constexpr bool upstream(const I2CTopologyNode* t, uint8_t segMux, 
+                                 uint8_t segChannel, uint8_t mux, uint8_t channel) {
+    return (segMux == mux && (mux == ROOT || segChannel == channel)) ||
+           (mux != ROOT && upstream(t, segMux, segChannel, t[mux].mux, t[mux].channel));
+  }
+
+  /**
+   * @brief Check if two nodes can both answer on the bus at the same time:
+   *        same bus and one sits upstream of (or beside) the other
+   */
+  static constexpr bool visible(const I2CTopologyNode* t, size_t i, size_t j) {
+    return t[i].bus == t[j].bus &&
+           (upstream(t, t[i].mux, t[i].channel, t[j].mux, t[j].channel) ||
+            upstream(t, t[j].mux, t[j].channel, t[i].mux, t[i].channel));
+  }
+
+  /**
+   * @brief Check if node i conflicts with any node from j on
+   */
+  static constexpr bool conflictFrom(const I2CTopologyNode* t, size_t n, size_t i, size_t j) {
+    return j < n && ((t[i].address == t[j].address && visible(t, i, j)) ||
+                     conflictFrom(t, n, i, j + 1));
+  }
+
+  /**
+   * @brief Check a table for address conflicts
+   * 
+   * @param t The topology table
+   * @param n The number of nodes
+   * @param i The first node to check (0 for the whole table)
+   * @return bool True if no two visible nodes share an address
+   */
+  static constexpr bool conflictFree(const I2CTopologyNode* t, size_t n, size_t i = 0) {
+    return i >= n || (!conflictFrom(t, n, i, i + 1) && conflictFree(t, n, i + 1));
+  }
+
+  /**
+   * @brief Check a table for reserved addresses
+   * 
+   * @param t The topology table
+   * @param n The number of nodes
+   * @param i The first node to check (0 for the whole table)
+   * @return bool True if no node uses a reserved address
+   */
+  static constexpr bool reservedFree(const I2CTopologyNode* t, size_t n, size_t i = 0) {
+    return i >= n || (!reserved(t[i].address) && reservedFree(t, n, i + 1));
+  }
+
+  /**
+   * @brief Check that every multiplexer reference points to an earlier 
+   *        multiplexer node on the same bus, and channels are 0-7
+   * 
+   * @param t The topology table
+   * @param n The number of nodes
+   * @param i The first node to check (0 for the whole table)
+   * @return bool True if all references are valid
+   */
+  static constexpr bool muxRefsValid(const I2CTopologyNode* t, size_t n, size_t i = 0) {
+    return i >= n || ((t[i].mux == ROOT || 
+                       (t[i].mux < i && t[t[i].mux].kind == MUX && 
+                        t[t[i].mux].bus == t[i].bus && t[i].channel < 8)) &&
+                      muxRefsValid(t, n, i + 1));
+  }
+
+  /**
+   * @brief Count the devices on a bus
+   * 
+   * @param t The topology table
+   * @param n The number of nodes
+   * @param bus The bus number
+   * @param i The first node to count (0 for the whole table)
+   */
+  static constexpr uint8_t deviceCount(const I2CTopologyNode* t, size_t n, 
+                                       uint8_t bus, size_t i = 0) {
+    return i >= n ? 0 : (uint8_t)((t[i].kind == DEVICE && t[i].bus == bus ? 1 : 0) +
+                                  deviceCount(t, n, bus, i + 1));
+  }
+
+  /**
+   * @brief Get the table index of the k-th device on a bus
+   * 
+   * @param t The topology table
+   * @param n The number of nodes
+   * @param bus The bus number
+   * @param k The device number on the bus (0 based)
+   * @param i The first node to search (0 for the whole table)
+   * @return The table index, or n if there are fewer devices
+   */
+  static constexpr size_t nthDevice(const I2CTopologyNode* t, size_t n, 
+                                    uint8_t bus, uint8_t k, size_t i = 0) {
+    return i >= n ? n :
+           (t[i].kind == DEVICE && t[i].bus == bus) ? 
+             (k == 0 ? i : nthDevice(t, n, bus, k - 1, i + 1)) :
+             nthDevice(t, n, bus, k, i + 1);
+  }
+
+  /**
+   * @brief Get 32 bits of the address presence mask of a bus segment: the 
+   *        addresses expected to answer while (mux, channel) is selected, 
+   *        including everything upstream.  Bit (address % 32) of word 
+   *        (address / 32) is set for each address.
+   * 
+   * @param t The topology table
+   * @param n The number of nodes
+   * @param bus The bus number
+   * @param mux The multiplexer node index, or ROOT
+   * @param channel The multiplexer channel
+   * @param word The mask word (0-3)
+   * @param i The first node to include (0 for the whole table)
+   */
+  static constexpr uint32_t presenceMask(const I2CTopologyNode* t, size_t n, uint8_t bus,
+                                         uint8_t mux, uint8_t channel, uint8_t word,
+                                         size_t i = 0) {
+    return i >= n ? 0 :
+           (((t[i].bus == bus && t[i].address / 32 == word &&
+              upstream(t, t[i].mux, t[i].channel, mux, channel)) ? 
+               (1UL << (t[i].address % 32)) : 0) |
+            presenceMask(t, n, bus, mux, channel, word, i + 1));
+  }
+
+  /**
+   * @brief Generate the address table of a bus, see I2C_BUS_TABLE()
+   * 
+   * @tparam N The number of devices on the bus, deviceCount()
+   * @param t The topology table
+   * @param n The number of nodes
+   * @param bus The bus number
+   */
+  template <size_t N>
+  static constexpr I2CBusTable<N> busTable(const I2CTopologyNode* t, size_t n, uint8_t bus) {
+    return busTable<N>(t, n, bus, typename I2CMakeIndexList<N>::Type());
+  }
+
+  template <size_t N, size_t... I>
+  static constexpr I2CBusTable<N> busTable(const I2CTopologyNode* t, size_t n, uint8_t bus,
+                                           I2CIndexList<I...>) {
+    return I2CBusTable<N>{ { t[nthDevice(t, n, bus, I)].address... }, 
+                           { (uint8_t)nthDevice(t, n, bus, I)... } };
+  }
+
+  /**
+   * @brief Construct a device object for a table node
+   * 
+   * @tparam Device The device type, an instance of BasicI2CDevice
+   * @param wire The bus of the device
+   * @param node The device node
+   */
+  template <class Device, class Bus>
+  static constexpr Device makeDevice(Bus& wire, const I2CTopologyNode& node) {
+    return Device(wire, node.address);
+  }
+
+  /**
+   * @brief Generate the device objects of a bus, see I2C_BUS_DEVICES()
+   * 
+   * @tparam Device The device type, an instance of BasicI2CDevice
+   * @tparam N The number of devices on the bus, deviceCount()
+   * @param wire The bus the devices are on
+   * @param t The topology table
+   * @param n The number of nodes
+   * @param bus The bus number
+   */
+  template <class Device, size_t N, class Bus>
+  static constexpr I2CDeviceSet<Device, N> devices(Bus& wire, const I2CTopologyNode* t, 
+                                                   size_t n, uint8_t bus) {
+    return devices<Device, N>(wire, t, n, bus, typename I2CMakeIndexList<N>::Type());
+  }
+
+  template <class Device, size_t N, class Bus, size_t... I>
+  static constexpr I2CDeviceSet<Device, N> devices(Bus& wire, const I2CTopologyNode* t, 
+                                                   size_t n, uint8_t bus, I2CIndexList<I...>) {
+    return I2CDeviceSet<Device, N>{ { makeDevice<Device>(wire, t[nthDevice(t, n, bus, I)])... } };
+  }
+};
+
+/**
+ * @brief The number of nodes of a topology table array
+ */
+#define I2C_TOPOLOGY_SIZE(table) (sizeof(table) / sizeof(table[0]))
+
+/**
+ * @brief Generate the I2CBusTable of a bus from a constexpr topology table
+ */
+#define I2C_BUS_TABLE(table, bus) \
+  I2CTopology::busTable<I2CTopology::deviceCount(table, I2C_TOPOLOGY_SIZE(table), bus)>( \
+    table, I2C_TOPOLOGY_SIZE(table), bus)
+
+/**
+ * @brief Generate the I2CDeviceSet of a bus from a constexpr topology table
+ */
+#define I2C_BUS_DEVICES(Device, wire, table, bus) \
+  I2CTopology::devices<Device, I2CTopology::deviceCount(table, I2C_TOPOLOGY_SIZE(table), bus)>( \
+    wire, table, I2C_TOPOLOGY_SIZE(table), bus)
+
+/**
+ * @brief Validate a topology table at compile time: reserved addresses, 
+ *        multiplexer references and address conflicts.
+ */
+#define I2C_TOPOLOGY_CHECK(table) \
+  static_assert(I2CTopology::reservedFree(table, I2C_TOPOLOGY_SIZE(table)), \
+                "I2C topology " #table " uses a reserved address"); \
+  static_assert(I2CTopology::muxRefsValid(table, I2C_TOPOLOGY_SIZE(table)), \
+                "I2C topology " #table " has an invalid multiplexer reference"); \
+  static_assert(I2CTopology::conflictFree(table, I2C_TOPOLOGY_SIZE(table)), \
+                "I2C topology " #table " has an address conflict")
+#endif /* I2C_TOPOLOGY_LIB_H_ */
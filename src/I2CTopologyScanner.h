@@ -0,0 +1,345 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+//!  @file I2CTopologyScanner.h 
+//!  @brief I2CTopologyScanner class definition
+//!
+//!  @author Nate Taylor 
+
+//!  Contact: nate@rtelectronix.com
+//!  @copyright (C) 2023  Nate Taylor - All Rights Reserved.
+//
+//    |-----------------------------------------------------------------------|
+//    |                                                                       |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |         MMMMMMMMMMMMMMMMMMMMMM   NNNNNNNNNNNNNNNNNN                   |
+//    |        MMMMMMMMM    MMMMMMMMMM       NNNNNMNNN                        |
+//    |        MMMMMMMM:    MMMMMMMMMM       NNNNNNNN                         |
+//    |       MMMMMMMMMMMMMMMMMMMMMMM       NNNNNNNNN                         |
+//    |      MMMMMMMMMMMMMMMMMMMMMM         NNNNNNNN                          |
+//    |      MMMMMMMM     MMMMMMM          NNNNNNNN                           |
+//    |     MMMMMMMMM    MMMMMMMM         NNNNNNNNN                           |
+//    |     MMMMMMMM     MMMMMMM          NNNNNNNN                            |
+//    |    MMMMMMMM     MMMMMMM          NNNNNNNNN                            |
+//    |                MMMMMMMM        NNNNNNNNNN                             |
+//    |               MMMMMMMMM       NNNNNNNNNNN                             |
+//    |               MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM         |
+//    |             MMMMMMM      E L E C T R O N I X         MMMMMM           |
+//    |              MMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMMM             |
+//    |                                                                       |
+//    |-----------------------------------------------------------------------|
+//
+//    |------------------------------------------------------------------------|
+//    |                                                                        |
+//    |    [MIT License]                                                       |
+//    |                                                                        |
+//    |    Copyright (c) 2023 Nathaniel Taylor                                 |
+//    |                                                                        |
+//    |    Permission is hereby granted, free of charge, to any person         |
+//    |    obtaining a copy of this software and associated documentation      |
+//    |    files (the "Software"), to deal in the Software without             |
+//    |    restriction, including without limitation the rights to use,        |
+//    |    copy, modify, merge, publish, distribute, sublicense, and/or sell   |
+//    |    copies of the Software, and to permit persons to whom the Software  |
+//    |    is furnished to do so, subject to the following conditions:         |
+//    |                                                                        |
+//    |    The above copyright notice and this permission notice shall be      |
+//    |    included in all copies or substantial portions of the Software.     |
+//    |                                                                        |
+//    |    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,     |
+//    |    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES     |
+//    |    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND            |
+//    |    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS |
+//    |    BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN     |
+//    |    AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF      |
+//    |    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     |
+//    |    IN THE SOFTWARE.                                                    |
+//    |                                                                        |
+//    |------------------------------------------------------------------------|
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifndef I2C_TOPOLOGY_SCANNER_LIB_H_
+#define I2C_TOPOLOGY_SCANNER_LIB_H_
+
+#include "I2CDevice.h"
+#include "I2CTopology.h"
+
+/**
+ * @brief A set of 7-bit addresses, one bit per address
+ */
+struct I2CAddressMask {
+  uint8_t bits[16]; //!< Bit (address % 8) of byte (address / 8)
+
+  I2CAddressMask() { clear(); }
+
+  inline void clear() { memset(bits, 0, sizeof(bits)); }
+  inline void set(uint8_t address) { bits[(address >> 3) & 0x0F] |= (uint8_t)(1 << (address & 0x07)); }
+  inline bool test(uint8_t address) const { return (bits[(address >> 3) & 0x0F] >> (address & 0x07)) & 0x01; }
+};
+
+/**
+ * @brief Discovered bus topology: the devices and multiplexers found, as a 
+ *        list of I2CTopologyNode entries (see I2CTopology.h).  Multiplexer 
+ *        references are indices into the list, so the same checks and 
+ *        queries work on discovered and compile-time tables.  The map is 
+ *        plain data and can be stored as-is in non-volatile memory.
+ * 
+ * @tparam Capacity The maximum number of nodes
+ */
+template <uint8_t Capacity = 32>
+struct I2CTopologyMap {
+  uint8_t count;                     //!< The number of nodes found
+  I2CTopologyNode nodes[Capacity];   //!< The nodes found
+
+  I2CTopologyMap(): count(0){};
+
+  /**
+   * @brief Append a node
+   * 
+   * @param node The node
+   * @return The node index, or I2CTopology::ROOT if the map is full
+   */
+  uint8_t add(const I2CTopologyNode& node) {
+    if (count >= Capacity) return I2CTopology::ROOT;
+    nodes[count] = node;
+    return count++;
+  }
+
+  /**
+   * @brief Find a node by address and segment
+   * 
+   * @param address The 7-bit I2C address
+   * @param mux The multiplexer node index, or I2CTopology::ROOT
+   * @param channel The multiplexer channel
+   * @return The node index, or I2CTopology::ROOT if not found
+   */
+  uint8_t find(uint8_t address, uint8_t mux = I2CTopology::ROOT, uint8_t channel = 0) const {
+    for (uint8_t i = 0; i < count; i++) {
+      const I2CTopologyNode& n = nodes[i];
+      if (n.address == address && n.mux == mux && (mux == I2CTopology::ROOT || n.channel == channel)) {
+        return i;
+      }
+    }
+    return I2CTopology::ROOT;
+  }
+
+  /**
+   * @brief Get the number of bytes in use, for storing the map
+   * 
+   * @return size_t 
+   */
+  inline size_t usedBytes() const { 
+    return sizeof(count) + count * sizeof(I2CTopologyNode); 
+  }
+};
+
+/**
+ * @brief Discovers the devices on a bus and behind TCA9548A style 
+ *        multiplexers, including nested multiplexers.
+ * 
+ *        Addresses are probed with an address-only write.  Behind a 
+ *        multiplexer, all channels are enabled at once and each address is 
+ *        probed once; only addresses that answer are narrowed down to their 
+ *        channel(s) by bisecting the channel mask.  Addresses already seen 
+ *        upstream (they answer on every channel) are skipped.  A bus with 
+ *        sparse multiplexer channels needs a little over one probe per 
+ *        address instead of one per address and channel.
+ * 
+ *        Multiplexers are only looked for at the addresses declared with 
+ *        addMuxAddress() or addMuxAddresses().  Identifying one writes 0xA5 
+ *        and then 0x00 to the device and reads each value back, which would 
+ *        reconfigure other parts at 0x70-0x77 (HT16K33, PCA9685 all-call, 
+ *        BME280, ...), so a scan without declared multiplexers only sends 
+ *        address probes.
+ * 
+ * @tparam Bus The bus type, TwoWire or a class derived from I2CBackend
+ * @tparam Capacity The capacity of the topology map
+ */
+template <class Bus = TwoWire, uint8_t Capacity = 32>
+class I2CTopologyScanner : public I2CBusResult {
+  public:
+    typedef I2CTopologyMap<Capacity> Map; //!< The topology map type
+
+    static constexpr uint8_t FIRST_ADDRESS = 0x08; //!< First non-reserved address
+    static constexpr uint8_t LAST_ADDRESS = 0x77;  //!< Last non-reserved address
+    static constexpr uint8_t FIRST_MUX = 0x70;     //!< First TCA9548A address
+    static constexpr uint8_t LAST_MUX = 0x77;      //!< Last TCA9548A address
+
+    /**
+     * @brief Construct a topology scanner
+     * 
+     * @param bus The TwoWire object or backend
+     * @param busNumber The bus number stored in the map nodes
+     */
+    I2CTopologyScanner(Bus& bus, uint8_t busNumber = 0):
+      m_bus(bus), m_busNumber(busNumber), m_probes(0){};
+
+    /**
+     * @brief Declare an address where a multiplexer may sit.  A device 
+     *        answering there is written to (see the class description).
+     * 
+     * @param address The 7-bit I2C address
+     */
+    inline void addMuxAddress(uint8_t address) { m_muxAddresses.set(address); }
+
+    /**
+     * @brief Declare a range of multiplexer addresses, e.g. FIRST_MUX to 
+     *        LAST_MUX on a board known to have nothing else there
+     * 
+     * @param first The first 7-bit I2C address
+     * @param last The last 7-bit I2C address
+     */
+    void addMuxAddresses(uint8_t first, uint8_t last) {
+      for (uint8_t a = first; a <= last && a <= LAST_ADDRESS; a++) addMuxAddress(a);
+    }
+
+    /**
+     * @brief Declare the multiplexer addresses of a topology description 
+     *        (see I2CTopology.h) on this scanner's bus
+     * 
+     * @param t The topology table
+     * @param n The number of nodes
+     */
+    void addMuxAddresses(const I2CTopologyNode* t, size_t n) {
+      for (size_t i = 0; i < n; i++) {
+        if (t[i].kind == I2CTopology::MUX && t[i].bus == m_busNumber) addMuxAddress(t[i].address);
+      }
+    }
+
+    /**
+     * @brief Discover the topology.  All multiplexers are left disabled.
+     * 
+     * @param m The map to fill (appended to)
+     * @return The number of nodes in the map
+     */
+    uint8_t discover(Map& m) {
+      for (uint8_t a = FIRST_ADDRESS; a <= LAST_ADDRESS; a++) {
+        if (m_muxAddresses.test(a) && probe(a) && identifyMux(a)) {
+          m.add(I2CTopology::mux(m_busNumber, a));
+        }
+      }
+      for (uint8_t a = FIRST_ADDRESS; a <= LAST_ADDRESS; a++) {
+        if (m.find(a) == I2CTopology::ROOT && probe(a)) {
+          m.add(I2CTopology::device(m_busNumber, a));
+        }
+      }
+      for (uint8_t i = 0; i < m.count; i++) {
+        if (m.nodes[i].kind == I2CTopology::MUX) scanMux(m, i);
+      }
+      return m.count;
+    }
+
+    /**
+     * @brief Probe an address with an address-only write
+     * 
+     * @param address The 7-bit I2C address
+     * @return bool True if the address was ACKed
+     */
+    bool probe(uint8_t address) {
+      m_probes++;
+      I2CTransfer xfer(address);
+      return i2cTransfer(m_bus, xfer) == SUCCESS;
+    }
+
+    /**
+     * @brief Get the number of probes sent so far
+     * 
+     * @return uint32_t 
+     */
+    inline uint32_t getProbeCount() const { return m_probes; }
+
+    /**
+     * @brief Select a multiplexer channel mask, enabling the path to it.  
+     *        Can be used to reach devices from a discovered map.
+     * 
+     * @param map The topology map
+     * @param mux The multiplexer node index
+     * @param mask The channel mask of the multiplexer
+     * @return The I2C Bus result
+     */
+    uint8_t selectPath(const Map& map, uint8_t mux, uint8_t mask) {
+      const I2CTopologyNode& n = map.nodes[mux];
+      if (n.mux != I2CTopology::ROOT) {
+        uint8_t status = selectPath(map, n.mux, (uint8_t)(1 << n.channel));
+        if (status != SUCCESS) return status;
+      }
+      return writeMux(n.address, mask);
+    }
+
+  protected:
+    uint8_t writeMux(uint8_t address, uint8_t mask) {
+      I2CTransfer xfer(address, &mask, 1);
+      return i2cTransfer(m_bus, xfer);
+    }
+
+    /**
+     * @brief Check that an address behaves like a multiplexer control 
+     *        register (written values read back), leaving it disabled.  
+     *        Writes to the device, only called for declared addresses.
+     */
+    bool identifyMux(uint8_t address) {
+      static const uint8_t patterns[2] = { 0xA5, 0x00 };
+      for (uint8_t i = 0; i < 2; i++) {
+        uint8_t value = (uint8_t)~patterns[i];
+        if (writeMux(address, patterns[i]) != SUCCESS) return false;
+        I2CTransfer xfer(address, nullptr, 0, &value, 1);
+        if (i2cTransfer(m_bus, xfer) != SUCCESS || value != patterns[i]) {
+          writeMux(address, 0);
+          return false;
+        }
+      }
+      return true;
+    }
+
+    void scanMux(Map& map, uint8_t mux) {
+      const I2CTopologyNode n = map.nodes[mux];
+      I2CAddressMask upstream;
+      for (uint8_t i = 0; i < map.count; i++) {
+        const I2CTopologyNode& u = map.nodes[i];
+        if (I2CTopology::upstream(map.nodes, u.mux, u.channel, n.mux, n.channel)) {
+          upstream.set(u.address);
+        }
+      }
+      if (selectPath(map, mux, 0xFF) != SUCCESS) return;
+      for (uint8_t a = FIRST_ADDRESS; a <= LAST_ADDRESS; a++) {
+        if (upstream.test(a) || !probe(a)) continue;
+        bisect(map, mux, a, 0xFF);
+        writeMux(n.address, 0xFF);
+      }
+      for (uint8_t i = mux; i != I2CTopology::ROOT; i = map.nodes[i].mux) {
+        writeMux(map.nodes[i].address, 0);
+      }
+    }
+
+    void bisect(Map& map, uint8_t mux, uint8_t address, uint8_t mask) {
+      if (!(mask & (mask - 1))) {
+        uint8_t channel = 0;
+        while (!((mask >> channel) & 0x01)) channel++;
+        bool isMux = m_muxAddresses.test(address) && identifyMux(address);
+        if (isMux) map.add(I2CTopology::mux(m_busNumber, address, mux, channel));
+        else map.add(I2CTopology::device(m_busNumber, address, mux, channel));
+        return;
+      }
+      uint8_t low = 0;
+      uint8_t half = 0;
+      uint8_t bits = 0;
+      for (uint8_t m = mask; m; m &= (uint8_t)(m - 1)) bits++;
+      for (uint8_t c = 0; c < 8 && half < bits / 2; c++) {
+        if ((mask >> c) & 0x01) {
+          low |= (uint8_t)(1 << c);
+          half++;
+        }
+      }
+      uint8_t parts[2] = { low, (uint8_t)(mask & ~low) };
+      for (uint8_t i = 0; i < 2; i++) {
+        writeMux(map.nodes[mux].address, parts[i]);
+        if (probe(address)) bisect(map, mux, address, parts[i]);
+      }
+    }
+
+    Bus& m_bus;           //!< The bus being scanned
+    uint8_t m_busNumber;  //!< The bus number stored in the map
+    uint32_t m_probes;    //!< Probes sent
+    I2CAddressMask m_muxAddresses; //!< Addresses where multiplexers may sit
+};
+#endif /* I2C_TOPOLOGY_SCANNER_LIB_H_ */